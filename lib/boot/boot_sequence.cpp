@@ -0,0 +1,307 @@
+#include "cJSON.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "boot_sequence.hpp"
+#include "task_placement.hpp"
+
+namespace cubestone_wang
+{
+
+namespace boot
+{
+
+const char *const BootSequence::LOG_TAG = "BOOT_SEQUENCE";
+
+sync::Mutex BootSequence::mutex(LOG_TAG);
+
+EventGroupHandle_t BootSequence::event_group = xEventGroupCreate();
+
+std::vector<BootSequence::Stage> BootSequence::stages;
+
+std::vector<BootSequence::Milestone> BootSequence::milestones;
+
+int64_t BootSequence::start_timestamp = 0;
+
+bool BootSequence::start_flag = false;
+
+int BootSequence::find(const std::string &name)
+{
+    for (size_t index = 0; index < stages.size(); index++) {
+        if (name == stages[index].Name) {
+            return index;
+        }
+    }
+    return -1;
+}
+
+bool BootSequence::Add(const std::string &name, StageFunc_t func, const std::vector<std::string> &dependencies)
+{
+    bool result = false;
+    Stage stage;
+    // 设置临界区
+    mutex.Lock();
+    if (true == start_flag) {
+        ESP_LOGE(LOG_TAG, "add %s after start", name.c_str());
+        goto DONE;
+    }
+    if (stages.size() >= MAX_STAGE_COUNT) {
+        ESP_LOGE(LOG_TAG, "too many stages, max is %u", MAX_STAGE_COUNT);
+        goto DONE;
+    }
+    if (-1 != find(name)) {
+        ESP_LOGE(LOG_TAG, "%s already exists", name.c_str());
+        goto DONE;
+    }
+    // 依赖需先添加，因此不会出现循环依赖
+    for (auto &dependency : dependencies) {
+        int index = find(dependency);
+        if (-1 == index) {
+            ESP_LOGE(LOG_TAG, "%s depends on unknown stage %s", name.c_str(), dependency.c_str());
+            goto DONE;
+        }
+        stage.Dependencies.push_back(index);
+    }
+    stage.Name = name;
+    stage.Func = func;
+    stage.Status = State::WAITING;
+    stage.ReadyTimestamp = 0;
+    stage.StartTimestamp = 0;
+    stage.EndTimestamp = 0;
+    stages.push_back(stage);
+    result = true;
+DONE:
+    // 退出临界区
+    mutex.Unlock();
+    return result;
+}
+
+void BootSequence::schedule()
+{
+    // 调用者已设置临界区
+    EventBits_t finished_bits = 0;
+    bool changed = true;
+    // 跳过的阶段可能使后续阶段也被跳过，直到没有变化
+    while (changed) {
+        changed = false;
+        for (size_t index = 0; index < stages.size(); index++) {
+            auto &stage = stages[index];
+            if (State::WAITING != stage.Status) {
+                continue;
+            }
+            bool ready = true;
+            bool skipped = false;
+            for (auto dependency : stage.Dependencies) {
+                auto state = stages[dependency].Status;
+                if (State::FAILURE == state || State::SKIPPED == state) {
+                    skipped = true;
+                    break;
+                }
+                if (State::SUCCESS != state) {
+                    ready = false;
+                }
+            }
+            if (true == skipped) {
+                stage.Status = State::SKIPPED;
+                stage.EndTimestamp = esp_timer_get_time();
+                finished_bits |= ((EventBits_t)1 << index);
+                changed = true;
+                ESP_LOGW(LOG_TAG, "%s skipped", stage.Name.c_str());
+                continue;
+            }
+            if (false == ready) {
+                continue;
+            }
+            stage.Status = State::RUNNING;
+            stage.ReadyTimestamp = esp_timer_get_time();
+            if (!task_placement::TaskPlacement::Create(task_placement::TaskPlacement::TaskType::BOOT,
+                                                       stage_task,
+                                                       (void *)index)) {
+                stage.Status = State::FAILURE;
+                stage.EndTimestamp = stage.ReadyTimestamp;
+                finished_bits |= ((EventBits_t)1 << index);
+                changed = true;
+            }
+        }
+    }
+    if (0 != finished_bits) {
+        xEventGroupSetBits(event_group, finished_bits);
+    }
+}
+
+void BootSequence::stage_task(void *args)
+{
+    size_t index = (size_t)args;
+    // 阶段添加后不再改变，执行期间无需加锁
+    auto name = stages[index].Name.c_str();
+    auto func = stages[index].Func;
+    int64_t begin = esp_timer_get_time();
+    ESP_LOGD(LOG_TAG, "%s start", name);
+    bool result = func();
+    int64_t end = esp_timer_get_time();
+    if (true == result) {
+        ESP_LOGI(LOG_TAG, "%s success, %lld us", name, end - begin);
+    } else {
+        ESP_LOGE(LOG_TAG, "%s failed, %lld us", name, end - begin);
+    }
+    // 设置临界区
+    mutex.Lock();
+    stages[index].StartTimestamp = begin;
+    stages[index].EndTimestamp = end;
+    stages[index].Status = result ? State::SUCCESS : State::FAILURE;
+    schedule();
+    // 退出临界区
+    mutex.Unlock();
+    xEventGroupSetBits(event_group, ((EventBits_t)1 << index));
+    vTaskDelete(NULL);
+}
+
+void BootSequence::Start()
+{
+    // 设置临界区
+    mutex.Lock();
+    if (true == start_flag) {
+        ESP_LOGE(LOG_TAG, "this has been started");
+    } else {
+        start_flag = true;
+        start_timestamp = esp_timer_get_time();
+        schedule();
+    }
+    // 退出临界区
+    mutex.Unlock();
+}
+
+bool BootSequence::Wait(const std::string &name, const uint32_t timeout)
+{
+    // 设置临界区
+    mutex.Lock();
+    int index = find(name);
+    // 退出临界区
+    mutex.Unlock();
+    if (-1 == index) {
+        ESP_LOGE(LOG_TAG, "can't find %s", name.c_str());
+        return false;
+    }
+    TickType_t ticks = portMAX_DELAY == timeout ? portMAX_DELAY : pdMS_TO_TICKS(timeout);
+    EventBits_t bits = xEventGroupWaitBits(event_group, ((EventBits_t)1 << index), pdFALSE, pdTRUE, ticks);
+    if (0 == (bits & ((EventBits_t)1 << index))) {
+        ESP_LOGW(LOG_TAG, "wait %s timeout", name.c_str());
+        return false;
+    }
+    return IsDone(name);
+}
+
+bool BootSequence::IsDone(const std::string &name)
+{
+    bool result = false;
+    // 设置临界区
+    mutex.Lock();
+    int index = find(name);
+    if (-1 != index) {
+        result = State::SUCCESS == stages[index].Status;
+    }
+    // 退出临界区
+    mutex.Unlock();
+    return result;
+}
+
+void BootSequence::Mark(const std::string &name)
+{
+    int64_t timestamp = esp_timer_get_time();
+    bool found = false;
+    // 设置临界区
+    mutex.Lock();
+    for (auto &milestone : milestones) {
+        if (name == milestone.Name) {
+            found = true;
+            break;
+        }
+    }
+    if (false == found) {
+        milestones.push_back({name, timestamp});
+    }
+    // 退出临界区
+    mutex.Unlock();
+    if (false == found) {
+        ESP_LOGI(LOG_TAG, "%s at %lld us", name.c_str(), timestamp);
+    }
+}
+
+const char *BootSequence::state_to_string(const State state)
+{
+    switch (state) {
+        case State::WAITING:
+            return "waiting";
+        case State::RUNNING:
+            return "running";
+        case State::SUCCESS:
+            return "success";
+        case State::FAILURE:
+            return "failure";
+        case State::SKIPPED:
+            return "skipped";
+        default:
+            return "unknown";
+    }
+}
+
+void BootSequence::LogTimeline()
+{
+    // 设置临界区
+    mutex.Lock();
+    ESP_LOGI(LOG_TAG, "           stage     ready(us)     start(us)       end(us)  state");
+    for (auto &stage : stages) {
+        ESP_LOGI(LOG_TAG, "%16s  %12lld  %12lld  %12lld  %s",
+                 stage.Name.c_str(),
+                 stage.ReadyTimestamp,
+                 stage.StartTimestamp,
+                 stage.EndTimestamp,
+                 state_to_string(stage.Status));
+    }
+    for (auto &milestone : milestones) {
+        ESP_LOGI(LOG_TAG, "%16s  %12lld", milestone.Name.c_str(), milestone.Timestamp);
+    }
+    // 退出临界区
+    mutex.Unlock();
+}
+
+std::string BootSequence::ExportTimeline()
+{
+    cJSON *json_root = cJSON_CreateObject();
+    cJSON *json_stages, *json_milestones, *json_item, *json_dependencies;
+    // 设置临界区
+    mutex.Lock();
+    cJSON_AddNumberToObject(json_root, "start", start_timestamp);
+    json_stages = cJSON_AddArrayToObject(json_root, "stages");
+    for (auto &stage : stages) {
+        json_item = cJSON_CreateObject();
+        cJSON_AddStringToObject(json_item, "name", stage.Name.c_str());
+        json_dependencies = cJSON_AddArrayToObject(json_item, "dependencies");
+        for (auto dependency : stage.Dependencies) {
+            cJSON_AddItemToArray(json_dependencies, cJSON_CreateString(stages[dependency].Name.c_str()));
+        }
+        cJSON_AddStringToObject(json_item, "state", state_to_string(stage.Status));
+        cJSON_AddNumberToObject(json_item, "ready", stage.ReadyTimestamp);
+        cJSON_AddNumberToObject(json_item, "start", stage.StartTimestamp);
+        cJSON_AddNumberToObject(json_item, "end", stage.EndTimestamp);
+        cJSON_AddItemToArray(json_stages, json_item);
+    }
+    json_milestones = cJSON_AddArrayToObject(json_root, "milestones");
+    for (auto &milestone : milestones) {
+        json_item = cJSON_CreateObject();
+        cJSON_AddStringToObject(json_item, "name", milestone.Name.c_str());
+        cJSON_AddNumberToObject(json_item, "time", milestone.Timestamp);
+        cJSON_AddItemToArray(json_milestones, json_item);
+    }
+    // 退出临界区
+    mutex.Unlock();
+    char *json_data = cJSON_PrintUnformatted(json_root);
+    std::string result = json_data;
+    cJSON_free(json_data);
+    cJSON_Delete(json_root);
+    return result;
+}
+
+}
+
+}
@@ -0,0 +1,111 @@
+#ifndef _boot_sequence_hpp_
+#define _boot_sequence_hpp_
+
+#include <string>
+#include <vector>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+
+#include "mutex.hpp"
+
+namespace cubestone_wang
+{
+
+namespace boot
+{
+
+/*
+  启动流程类
+  各启动阶段声明所依赖的阶段，依赖全部成功后在独立的任务中执行，互不依赖的阶段并行执行，
+  依赖失败的阶段被跳过；记录各阶段就绪、开始、结束的时间（启动后的微秒数）及首次采样等里程碑，
+  用于输出或导出启动时间线
+*/
+class BootSequence
+{
+    public:
+        // 阶段函数，返回是否成功
+        typedef bool (*StageFunc_t)();
+        // 阶段最大数量，受事件组可用位数限制
+        static const uint8_t MAX_STAGE_COUNT = 24;
+        // 日志标签
+        static const char *const LOG_TAG;
+        /**
+         * @brief 添加阶段，需在Start之前调用
+         *
+         * @param name 名称
+         * @param func 阶段函数
+         * @param dependencies 依赖的阶段名称，需已添加
+         */
+        static bool Add(const std::string &name, StageFunc_t func, const std::vector<std::string> &dependencies={});
+        /**
+         * @brief 开始执行，不等待
+         */
+        static void Start();
+        /**
+         * @brief 等待阶段结束
+         *
+         * @param name 名称
+         * @param timeout 超时时间（毫秒）
+         * @return 阶段是否成功，失败、被跳过或超时返回false
+         */
+        static bool Wait(const std::string &name, const uint32_t timeout=portMAX_DELAY);
+        /**
+         * @brief 阶段是否已成功结束，不等待
+         *
+         * @param name 名称
+         */
+        static bool IsDone(const std::string &name);
+        /**
+         * @brief 记录里程碑，同名的只记录第一次
+         *
+         * @param name 名称
+         */
+        static void Mark(const std::string &name);
+        /**
+         * @brief 输出时间线
+         */
+        static void LogTimeline();
+        /**
+         * @brief 导出时间线（JSON）
+         */
+        static std::string ExportTimeline();
+    private:
+        // 阶段状态
+        enum class State {
+            WAITING,
+            RUNNING,
+            SUCCESS,
+            FAILURE,
+            SKIPPED,
+        };
+        struct Stage {
+            std::string Name;
+            StageFunc_t Func;
+            std::vector<uint8_t> Dependencies;
+            State Status;
+            int64_t ReadyTimestamp;     // 微秒
+            int64_t StartTimestamp;     // 微秒
+            int64_t EndTimestamp;       // 微秒
+        };
+        struct Milestone {
+            std::string Name;
+            int64_t Timestamp;          // 微秒
+        };
+        static sync::Mutex mutex;
+        static EventGroupHandle_t event_group;
+        static std::vector<Stage> stages;
+        static std::vector<Milestone> milestones;
+        static int64_t start_timestamp;
+        static bool start_flag;
+        static int find(const std::string &name);
+        static void schedule();
+        static void stage_task(void *args);
+        static const char *state_to_string(const State state);
+};
+
+}
+
+}
+
+#endif // _boot_sequence_hpp_
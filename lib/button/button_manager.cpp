@@ -1,11 +1,13 @@
 #include <map>
 #include <string>
+#include <vector>
 
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
 #include "system.hpp"
+#include "timer.hpp"
 
 #include "button_manager.hpp"
 
@@ -17,28 +19,95 @@ namespace button
 
 using namespace std;
 using namespace system;
+using namespace timer;
 
 const char *const ButtonManager::LOG_TAG = "BUTTON_MANAGER";
 
 bool ButtonManager::start_flag = false;
 
-SemaphoreHandle_t ButtonManager::mutex = xSemaphoreCreateMutex();
+bool ButtonManager::use_interrupt = true;
 
-map<string, ButtonManager::Button *> ButtonManager::button_map = map<string, ButtonManager::Button *>();
+uint32_t ButtonManager::wakeup_count = 0;
 
-TaskHandle_t ButtonManager::task_handler = nullptr;
+sync::Mutex ButtonManager::mutex("button_manager");
 
-bool ButtonManager::Add(const string& name, const gpio_num_t pin, const uint8_t button_pressed_level)
+Timer::Signal_t ButtonManager::process_signal = Timer::INVALID_SIGNAL;
+
+Timer::Handle_t ButtonManager::timer_handle = Timer::INVALID_HANDLE;
+
+const ButtonManager::Handle_t ButtonManager::INVALID_HANDLE = 0;
+
+vector<ButtonManager::Button *> ButtonManager::buttons;
+
+vector<uint16_t> ButtonManager::generations;
+
+map<string, ButtonManager::Handle_t> ButtonManager::name_to_handle;
+
+// 轮询模式的处理周期及中断模式下长按中回调的调用周期（毫秒）
+static const uint32_t POLL_INTERVAL = 10;
+// 无需超时等待
+static const uint32_t WAIT_FOREVER = UINT32_MAX;
+
+void IRAM_ATTR ButtonManager::isr_handler(void *args)
+{
+    BaseType_t task_woken = pdFALSE;
+    // 抖动时会产生多个中断，处理前只执行一次
+    Timer::RaiseFromISR(process_signal, &task_woken);
+    if (task_woken == pdTRUE) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+void ButtonManager::enable_interrupt(Button *button)
+{
+    auto err = gpio_install_isr_service(0);
+    // 已安装时返回ESP_ERR_INVALID_STATE
+    if (ESP_OK != err && ESP_ERR_INVALID_STATE != err) {
+        ESP_ERROR_CHECK(err);
+    }
+    ESP_ERROR_CHECK(gpio_set_intr_type(button->pin, GPIO_INTR_ANYEDGE));
+    ESP_ERROR_CHECK(gpio_isr_handler_add(button->pin, isr_handler, button));
+}
+
+void ButtonManager::disable_interrupt(Button *button)
 {
+    ESP_ERROR_CHECK(gpio_isr_handler_remove(button->pin));
+    ESP_ERROR_CHECK(gpio_set_intr_type(button->pin, GPIO_INTR_DISABLE));
+}
+
+void ButtonManager::update_settings(Button *button)
+{
+    // 设置最大点击数
+    if (button->multi_click_callback_func != nullptr) {
+        button->max_click_count = 100;
+    } else if (button->double_click_callback_func != nullptr) {
+        button->max_click_count = 2;
+    } else {
+        button->max_click_count = 1;
+    }
+    // 判断是否开启长按判断
+    if (button->long_press_start_callback_func == nullptr &&
+        button->during_long_press_callback_func == nullptr &&
+        button->long_press_stop_callback_func == nullptr) {
+        button->has_long_press = false;
+    } else {
+        button->has_long_press = true;
+    }
+}
+
+ButtonManager::Handle_t ButtonManager::Add(const string& name, const gpio_num_t pin, const uint8_t button_pressed_level)
+{
+    Handle_t handle;
     // 设置临界区
-    xSemaphoreTake(mutex, portMAX_DELAY);
-    if (button_map.count(name) > 0) {
+    mutex.Lock();
+    if (name_to_handle.count(name) > 0) {
         ESP_LOGE(LOG_TAG, "%s has been exist", name.c_str());
         // 退出临界区
-        xSemaphoreGive(mutex);
-        return false;
+        mutex.Unlock();
+        return INVALID_HANDLE;
     }
     auto button = new Button();
+    button->name = name;
     button->pin = pin;
     button->button_pressed_level = button_pressed_level;
     ESP_ERROR_CHECK(gpio_reset_pin(button->pin));
@@ -67,224 +136,388 @@ bool ButtonManager::Add(const string& name, const gpio_num_t pin, const uint8_t
     button->state = button->last_state = StateType::INIT;
     button->click_count = 0;
     button->start_time = 0;
-    button_map[name] = button;
+    button->button_pressed = false;
+    update_settings(button);
+    if (start_flag && use_interrupt) {
+        enable_interrupt(button);
+    }
+    // 优先复用已删除的位置
+    size_t index;
+    for (index = 0; index < buttons.size(); index++) {
+        if (nullptr == buttons[index]) {
+            break;
+        }
+    }
+    if (index >= buttons.size()) {
+        buttons.push_back(button);
+        generations.push_back(1);
+    } else {
+        buttons[index] = button;
+    }
+    handle = (static_cast<Handle_t>(generations[index]) << 16) | (index + 1);
+    name_to_handle[name] = handle;
     ESP_LOGD(LOG_TAG, "%s add", name.c_str());
     // 退出临界区
-    xSemaphoreGive(mutex);
-    return true;
+    mutex.Unlock();
+    return handle;
 }
 
 bool ButtonManager::Del(const string& name)
 {
     // 设置临界区
-    xSemaphoreTake(mutex, portMAX_DELAY);
-    if (button_map.count(name) == 0) {
+    mutex.Lock();
+    auto iter = name_to_handle.find(name);
+    if (iter == name_to_handle.end()) {
         ESP_LOGW(LOG_TAG, "%s can't be found", name.c_str());
         // 退出临界区
-        xSemaphoreGive(mutex);
+        mutex.Unlock();
         return false;
     }
-    button_map.erase(name);
+    auto index = (iter->second & 0xffff) - 1;
+    auto button = buttons[index];
+    if (start_flag && use_interrupt) {
+        disable_interrupt(button);
+    }
+    delete button;
+    buttons[index] = nullptr;
+    generations[index]++;
+    name_to_handle.erase(iter);
     ESP_LOGD(LOG_TAG, "%s del", name.c_str());
     // 退出临界区
-    xSemaphoreGive(mutex);
+    mutex.Unlock();
     return true;
 }
 
-bool ButtonManager::Start(const UBaseType_t task_priority, const uint32_t stack_depth)
+bool ButtonManager::Start(const bool use_interrupt)
 {  
+    bool result;
     // 判断是否已经启动  
     // 设置临界区
-    xSemaphoreTake(mutex, portMAX_DELAY);
+    mutex.Lock();
     // ESP_LOGD(LOG_TAG, "mutex return code: %d", err);
     if (start_flag == true) {
         ESP_LOGI(LOG_TAG, "this has been started");
         // 退出临界区
-        xSemaphoreGive(mutex);
+        mutex.Unlock();
         return false;
     }
     ButtonManager::start_flag = true;
-    auto err = xTaskCreate(run_task, 
-                           "button", 
-                           stack_depth, 
-                           nullptr, 
-                           task_priority, 
-                           &task_handler);
+    ButtonManager::use_interrupt = use_interrupt;
+    for (auto button : buttons) {
+        if (nullptr != button) {
+            reset(button);
+            if (use_interrupt) {
+                enable_interrupt(button);
+            }
+        }
+    }
+    if (use_interrupt) {
+        // 信号不能删除，再次启动时沿用
+        if (Timer::INVALID_SIGNAL == process_signal) {
+            process_signal = Timer::AddSignal(process_all);
+        }
+        result = Timer::INVALID_SIGNAL != process_signal;
+        Timer::Raise(process_signal);
+    } else {
+        timer_handle = Timer::AddPeriodicEvent(POLL_INTERVAL, process_all);
+        result = Timer::INVALID_HANDLE != timer_handle;
+    }
     // 退出临界区
-    xSemaphoreGive(mutex);
-    return err == pdPASS;
+    mutex.Unlock();
+    return result;
 }
 
-bool ButtonManager::SetClickCallbackFunction(const string& name, const CallbackFunction_t func, void *args)
+ButtonManager::Handle_t ButtonManager::GetHandle(const string& name)
 {
+    Handle_t handle = INVALID_HANDLE;
     // 设置临界区
-    xSemaphoreTake(mutex, portMAX_DELAY);
-    auto iter = button_map.find(name);  
-    if(iter == button_map.end()) {
+    mutex.Lock();
+    auto iter = name_to_handle.find(name);
+    if (iter != name_to_handle.end()) {
+        handle = iter->second;
+    }
+    // 退出临界区
+    mutex.Unlock();
+    return handle;
+}
+
+ButtonManager::Button *ButtonManager::get(const Handle_t handle)
+{
+    uint32_t index = (handle & 0xffff);
+    if (0 == index || index > buttons.size()) {
+        return nullptr;
+    }
+    // 已删除或位置已被复用时代数不一致
+    if (generations[index - 1] != (handle >> 16)) {
+        return nullptr;
+    }
+    return buttons[index - 1];
+}
+
+bool ButtonManager::SetClickCallbackFunction(const string& name, const CallbackFunction_t func, void *args)
+{
+    auto handle = GetHandle(name);
+    if (INVALID_HANDLE == handle) {
+        ESP_LOGE(LOG_TAG, "%s can't be found", name.c_str());
+        return false;
+    }
+    return SetClickCallbackFunction(handle, func, args);
+}
+
+bool ButtonManager::SetDoubleClickCallbackFunction(const string& name, const CallbackFunction_t func, void *args)
+{
+    auto handle = GetHandle(name);
+    if (INVALID_HANDLE == handle) {
+        ESP_LOGE(LOG_TAG, "%s can't be found", name.c_str());
+        return false;
+    }
+    return SetDoubleClickCallbackFunction(handle, func, args);
+}
+
+bool ButtonManager::SetMultiClickCallbackFunction(const string& name, const CallbackFunction_t func, void *args)
+{
+    auto handle = GetHandle(name);
+    if (INVALID_HANDLE == handle) {
+        ESP_LOGE(LOG_TAG, "%s can't be found", name.c_str());
+        return false;
+    }
+    return SetMultiClickCallbackFunction(handle, func, args);
+}
+
+bool ButtonManager::SetLongPressStartCallbackFunction(const string& name, const CallbackFunction_t func, void *args)
+{
+    auto handle = GetHandle(name);
+    if (INVALID_HANDLE == handle) {
+        ESP_LOGE(LOG_TAG, "%s can't be found", name.c_str());
+        return false;
+    }
+    return SetLongPressStartCallbackFunction(handle, func, args);
+}
+
+bool ButtonManager::SetLongPressStopCallbackFunction(const string& name, const CallbackFunction_t func, void *args)
+{
+    auto handle = GetHandle(name);
+    if (INVALID_HANDLE == handle) {
+        ESP_LOGE(LOG_TAG, "%s can't be found", name.c_str());
+        return false;
+    }
+    return SetLongPressStopCallbackFunction(handle, func, args);
+}
+
+bool ButtonManager::SetDuringLongPressCallbackFunction(const string& name, const CallbackFunction_t func, void *args)
+{
+    auto handle = GetHandle(name);
+    if (INVALID_HANDLE == handle) {
+        ESP_LOGE(LOG_TAG, "%s can't be found", name.c_str());
+        return false;
+    }
+    return SetDuringLongPressCallbackFunction(handle, func, args);
+}
+
+bool ButtonManager::SetDebounceTicks(const string& name, const uint32_t ticks)
+{
+    auto handle = GetHandle(name);
+    if (INVALID_HANDLE == handle) {
+        ESP_LOGE(LOG_TAG, "%s can't be found", name.c_str());
+        return false;
+    }
+    return SetDebounceTicks(handle, ticks);
+}
+
+bool ButtonManager::SetClickTicks(const string& name, const uint32_t ticks)
+{
+    auto handle = GetHandle(name);
+    if (INVALID_HANDLE == handle) {
+        ESP_LOGE(LOG_TAG, "%s can't be found", name.c_str());
+        return false;
+    }
+    return SetClickTicks(handle, ticks);
+}
+
+bool ButtonManager::SetPressTicks(const string& name, const uint32_t ticks)
+{
+    auto handle = GetHandle(name);
+    if (INVALID_HANDLE == handle) {
         ESP_LOGE(LOG_TAG, "%s can't be found", name.c_str());
+        return false;
+    }
+    return SetPressTicks(handle, ticks);
+}
+
+bool ButtonManager::SetClickCallbackFunction(const Handle_t handle, const CallbackFunction_t func, void *args)
+{
+    // 设置临界区
+    mutex.Lock();
+    auto button = get(handle);
+    if (nullptr == button) {
+        ESP_LOGE(LOG_TAG, "handle %lu can't be found", handle);
         // 退出临界区
-        xSemaphoreGive(mutex);
+        mutex.Unlock();
         return false;
     }
-    auto button = iter->second;
     button->click_callback_func = func;
     button->click_callback_func_args = args;
+    update_settings(button);
     // 退出临界区
-    xSemaphoreGive(mutex);
+    mutex.Unlock();
     return true;
 }
 
-bool ButtonManager::SetDoubleClickCallbackFunction(const string& name, const CallbackFunction_t func, void *args)
+bool ButtonManager::SetDoubleClickCallbackFunction(const Handle_t handle, const CallbackFunction_t func, void *args)
 {
     // 设置临界区
-    xSemaphoreTake(mutex, portMAX_DELAY);
-    auto iter = button_map.find(name);  
-    if(iter == button_map.end()) {
-        ESP_LOGE(LOG_TAG, "%s can't be found", name.c_str());
+    mutex.Lock();
+    auto button = get(handle);
+    if (nullptr == button) {
+        ESP_LOGE(LOG_TAG, "handle %lu can't be found", handle);
         // 退出临界区
-        xSemaphoreGive(mutex);
+        mutex.Unlock();
         return false;
     }
-    auto button = iter->second;
     button->double_click_callback_func = func;
     button->double_click_callback_func_args = args;
+    update_settings(button);
     // 退出临界区
-    xSemaphoreGive(mutex);
+    mutex.Unlock();
     return true;
 }
 
-bool ButtonManager::SetMultiClickCallbackFunction(const string& name, const CallbackFunction_t func, void *args)
+bool ButtonManager::SetMultiClickCallbackFunction(const Handle_t handle, const CallbackFunction_t func, void *args)
 {
     // 设置临界区
-    xSemaphoreTake(mutex, portMAX_DELAY);
-    auto iter = button_map.find(name);  
-    if(iter == button_map.end()) {
-        ESP_LOGE(LOG_TAG, "%s can't be found", name.c_str());
+    mutex.Lock();
+    auto button = get(handle);
+    if (nullptr == button) {
+        ESP_LOGE(LOG_TAG, "handle %lu can't be found", handle);
         // 退出临界区
-        xSemaphoreGive(mutex);
+        mutex.Unlock();
         return false;
     }
-    auto button = iter->second;
     button->multi_click_callback_func = func;
     button->multi_click_callback_func_args = args;
+    update_settings(button);
     // 退出临界区
-    xSemaphoreGive(mutex);
+    mutex.Unlock();
     return true;
 }
 
-bool ButtonManager::SetLongPressStartCallbackFunction(const string& name, const CallbackFunction_t func, void *args)
+bool ButtonManager::SetLongPressStartCallbackFunction(const Handle_t handle, const CallbackFunction_t func, void *args)
 {
     // 设置临界区
-    xSemaphoreTake(mutex, portMAX_DELAY);
-    auto iter = button_map.find(name);  
-    if(iter == button_map.end()) {
-        ESP_LOGE(LOG_TAG, "%s can't be found", name.c_str());
+    mutex.Lock();
+    auto button = get(handle);
+    if (nullptr == button) {
+        ESP_LOGE(LOG_TAG, "handle %lu can't be found", handle);
         // 退出临界区
-        xSemaphoreGive(mutex);
+        mutex.Unlock();
         return false;
     }
-    auto button = iter->second;
     button->long_press_start_callback_func = func;
     button->long_press_start_callback_func_args = args;
+    update_settings(button);
     // 退出临界区
-    xSemaphoreGive(mutex);
+    mutex.Unlock();
     return true;
 }
 
-bool ButtonManager::SetLongPressStopCallbackFunction(const string& name, const CallbackFunction_t func, void *args)
+bool ButtonManager::SetLongPressStopCallbackFunction(const Handle_t handle, const CallbackFunction_t func, void *args)
 {
     // 设置临界区
-    xSemaphoreTake(mutex, portMAX_DELAY);
-    auto iter = button_map.find(name);  
-    if(iter == button_map.end()) {
-        ESP_LOGE(LOG_TAG, "%s can't be found", name.c_str());
+    mutex.Lock();
+    auto button = get(handle);
+    if (nullptr == button) {
+        ESP_LOGE(LOG_TAG, "handle %lu can't be found", handle);
         // 退出临界区
-        xSemaphoreGive(mutex);
+        mutex.Unlock();
         return false;
     }
-    auto button = iter->second;
     button->long_press_stop_callback_func = func;
     button->long_press_stop_callback_func_args = args;
+    update_settings(button);
     // 退出临界区
-    xSemaphoreGive(mutex);
+    mutex.Unlock();
     return true;
 }
 
-bool ButtonManager::SetDuringLongPressCallbackFunction(const string& name, const CallbackFunction_t func, void *args)
+bool ButtonManager::SetDuringLongPressCallbackFunction(const Handle_t handle, const CallbackFunction_t func, void *args)
 {
     // 设置临界区
-    xSemaphoreTake(mutex, portMAX_DELAY);
-    auto iter = button_map.find(name);  
-    if(iter == button_map.end()) {
-        ESP_LOGE(LOG_TAG, "%s can't be found", name.c_str());
+    mutex.Lock();
+    auto button = get(handle);
+    if (nullptr == button) {
+        ESP_LOGE(LOG_TAG, "handle %lu can't be found", handle);
         // 退出临界区
-        xSemaphoreGive(mutex);
+        mutex.Unlock();
         return false;
     }
-    auto button = iter->second;
     button->during_long_press_callback_func = func;
     button->during_long_press_callback_func_args = args;
+    update_settings(button);
     // 退出临界区
-    xSemaphoreGive(mutex);
+    mutex.Unlock();
     return true;
 }
 
-bool ButtonManager::SetDebounceTicks(const string& name, const uint32_t ticks)
+bool ButtonManager::SetDebounceTicks(const Handle_t handle, const uint32_t ticks)
 {
     // 设置临界区
-    xSemaphoreTake(mutex, portMAX_DELAY);
-    auto iter = button_map.find(name);  
-    if(iter == button_map.end()) {
-        ESP_LOGE(LOG_TAG, "%s can't be found", name.c_str());
+    mutex.Lock();
+    auto button = get(handle);
+    if (nullptr == button) {
+        ESP_LOGE(LOG_TAG, "handle %lu can't be found", handle);
         // 退出临界区
-        xSemaphoreGive(mutex);
+        mutex.Unlock();
         return false;
     }
-    auto button = iter->second;
     button->debounce_ticks = ticks;
     // 退出临界区
-    xSemaphoreGive(mutex);
+    mutex.Unlock();
     return true;
 }
 
-bool ButtonManager::SetClickTicks(const string& name, const uint32_t ticks)
+bool ButtonManager::SetClickTicks(const Handle_t handle, const uint32_t ticks)
 {
     // 设置临界区
-    xSemaphoreTake(mutex, portMAX_DELAY);
-    auto iter = button_map.find(name);  
-    if(iter == button_map.end()) {
-        ESP_LOGE(LOG_TAG, "%s can't be found", name.c_str());
+    mutex.Lock();
+    auto button = get(handle);
+    if (nullptr == button) {
+        ESP_LOGE(LOG_TAG, "handle %lu can't be found", handle);
         // 退出临界区
-        xSemaphoreGive(mutex);
+        mutex.Unlock();
         return false;
     }
-    auto button = iter->second;
     button->click_ticks = ticks;
     // 退出临界区
-    xSemaphoreGive(mutex);
+    mutex.Unlock();
     return true;
 }
 
-bool ButtonManager::SetPressTicks(const string& name, const uint32_t ticks)
+bool ButtonManager::SetPressTicks(const Handle_t handle, const uint32_t ticks)
 {
     // 设置临界区
-    xSemaphoreTake(mutex, portMAX_DELAY);
-    auto iter = button_map.find(name);  
-    if(iter == button_map.end()) {
-        ESP_LOGE(LOG_TAG, "%s can't be found", name.c_str());
+    mutex.Lock();
+    auto button = get(handle);
+    if (nullptr == button) {
+        ESP_LOGE(LOG_TAG, "handle %lu can't be found", handle);
         // 退出临界区
-        xSemaphoreGive(mutex);
+        mutex.Unlock();
         return false;
     }
-    auto button = iter->second;
     button->press_ticks = ticks;
     // 退出临界区
-    xSemaphoreGive(mutex);
+    mutex.Unlock();
     return true;
 }
 
-void ButtonManager::run_task(void *) {
-    ESP_LOGD(LOG_TAG, "running");
+void ButtonManager::reset(Button *button)
+{
+    button->state = button->last_state = StateType::INIT;
+    button->click_count = 0;
+    button->start_time = 0;
+}
+
+void ButtonManager::new_state(Button *button, const StateType state)
+{
     auto tmp_map = [](StateType _state)
     {
         switch (_state)
@@ -305,151 +538,41 @@ void ButtonManager::run_task(void *) {
             return "UNKWON";
         }
     };
-    auto new_state = [&tmp_map](string& button_name, Button *button, StateType state)
-    { 
-        ESP_LOGV(LOG_TAG, "%s %s to %s", button_name.c_str(), tmp_map(button->last_state), tmp_map(button->state));
-        button->last_state = state; 
-        button->state = state;
-    };
-    auto reset = [](Button *button)
-    {
-        button->state = button->last_state = StateType::INIT;
-        button->click_count = 0;
-        button->start_time = 0;
-    };
-    for (auto iter = button_map.begin(); iter != button_map.end(); iter++) 
+    ESP_LOGV(LOG_TAG, "%s %s to %s", button->name.c_str(), tmp_map(button->last_state), tmp_map(state));
+    button->last_state = state;
+    button->state = state;
+}
+
+bool ButtonManager::process(Button *button, const uint32_t current_time)
+{
+    auto state = button->state;
+    auto click_count = button->click_count;
+    // 判断按钮状态
+    button->button_pressed = gpio_get_level(button->pin) == button->button_pressed_level ? true : false;
+    // 处理时间，无符号减法可正确处理时间戳溢出
+    button->wait_time = current_time - button->start_time;
+    switch (button->state)
     {
-        reset(iter->second);
-    }
-    while(true)
-    {   
-        // 设置临界区
-        xSemaphoreTake(mutex, portMAX_DELAY);
-        // 处理每一个按钮
-        for (auto iter = button_map.begin(); iter != button_map.end(); iter++) 
-        {
-            auto button_name = iter->first;
-            auto button = iter->second;
-            // 设置最大点击数
-            if (button->multi_click_callback_func != nullptr) {
-                button->max_click_count = 100;
-            } else if (button->double_click_callback_func != nullptr) {
-                button->max_click_count = 2;
-            } else {
-                button->max_click_count = 1;
-            }
-            // 判断是否开启长按判断
-            if (button->long_press_start_callback_func == nullptr && 
-                button->during_long_press_callback_func == nullptr &&
-                button->long_press_stop_callback_func == nullptr) {
-                button->has_long_press = false;
-            } else {
-                button->has_long_press = true;
-            }
-            // 判断按钮状态
-            button->button_pressed = gpio_get_level(button->pin) == button->button_pressed_level ? true : false; 
-            // 处理时间
-            auto current_time = esp_log_timestamp();
-            if (current_time >= button->start_time) {
-                button->wait_time = current_time - button->start_time;
-            } else {
-                // 处理时间戳溢出问题
-                button->wait_time = UINT32_MAX - button->start_time + current_time;
+        case StateType::INIT:
+            if (button->button_pressed) {
+                new_state(button, StateType::PRESS);
+                button->start_time = current_time;
+                button->click_count = 0;
             }
-            switch (button->state)
-            {
-                case StateType::INIT:
-                    if (button->button_pressed) {
-                        new_state(button_name, button, StateType::PRESS);
-                        button->start_time = esp_log_timestamp();
-                        button->click_count = 0;
-                    }
-                    break;
-                case StateType::PRESS:
-                    if (button->button_pressed) { 
-                        if (button->has_long_press) {
-                            if (button->wait_time > button->press_ticks) {
-                                ESP_LOGD(LOG_TAG, "%s long press start", button_name.c_str());
-                                if (button->long_press_start_callback_func != nullptr) {
-                                    try {
-                                        button->long_press_start_callback_func(button->long_press_start_callback_func_args);
-                                    } catch(const std::exception& e) {
-                                        ESP_LOGE(LOG_TAG, "unexpected->%s", e.what());
-                                    }
-                                }
-                                ESP_LOGD(LOG_TAG, "%s during long press", button_name.c_str());
-                                if (button->during_long_press_callback_func != nullptr) {
-                                    try {
-                                        button->during_long_press_callback_func(button->during_long_press_callback_func_args);
-                                    } catch(const std::exception& e) {
-                                        ESP_LOGE(LOG_TAG, "unexpected->%s", e.what());
-                                    }
-                                }
-                                new_state(button_name, button, StateType::LONG_PRESS);
-                            }
-                        }
-                    } else {
-                        if (button->wait_time < button->debounce_ticks) {
-                            new_state(button_name, button, button->last_state);
-                        } else {
-                            new_state(button_name, button, StateType::PRESS_RELEASE);
-                            button->start_time = esp_log_timestamp();
-                        }
-                    }
-                    break;
-                case StateType::PRESS_RELEASE:
-                    if (button->button_pressed) {
-                        if (button->wait_time < button->debounce_ticks) {
-                            new_state(button_name, button, button->last_state);
-                        } 
-                    } else {
-                        if (button->wait_time >= button->debounce_ticks) {
-                            button->click_count += 1;
-                            new_state(button_name, button, StateType::COUNT);
-                        }
-                    }
-                    break;
-                case StateType::COUNT:
-                    if (button->button_pressed) {
-                        new_state(button_name, button, StateType::PRESS);
-                        button->start_time = esp_log_timestamp();
-                    } else {
-                        if (button->wait_time >= button->click_ticks || button->click_count == button->max_click_count) {
-                            if (button->click_count == 1) {
-                                ESP_LOGD(LOG_TAG, "%s click", button_name.c_str());
-                                if (button->click_callback_func != nullptr) {
-                                    try {
-                                        button->click_callback_func(button->click_callback_func_args);
-                                    } catch(const std::exception& e) {
-                                        ESP_LOGE(LOG_TAG, "unexpected->%s", e.what());
-                                    }
-                                }
-                            } else if (button->click_count == 2) {
-                                ESP_LOGD(LOG_TAG, "%s double click", button_name.c_str());
-                                if (button->double_click_callback_func != nullptr) {
-                                    try {
-                                        button->double_click_callback_func(button->double_click_callback_func_args);
-                                    } catch(const std::exception& e) {
-                                        ESP_LOGE(LOG_TAG, "unexpected->%s", e.what());
-                                    }
-                                }
-                            } else {
-                                ESP_LOGD(LOG_TAG, "%s multi click", button_name.c_str());
-                                if (button->multi_click_callback_func != nullptr) {
-                                    try {
-                                        button->multi_click_callback_func(button->multi_click_callback_func_args);
-                                    } catch(const std::exception& e) {
-                                        ESP_LOGE(LOG_TAG, "unexpected->%s", e.what());
-                                    }
-                                }
+            break;
+        case StateType::PRESS:
+            if (button->button_pressed) {
+                if (button->has_long_press) {
+                    if (button->wait_time > button->press_ticks) {
+                        ESP_LOGD(LOG_TAG, "%s long press start", button->name.c_str());
+                        if (button->long_press_start_callback_func != nullptr) {
+                            try {
+                                button->long_press_start_callback_func(button->long_press_start_callback_func_args);
+                            } catch(const std::exception& e) {
+                                ESP_LOGE(LOG_TAG, "unexpected->%s", e.what());
                             }
-                            reset(button);
                         }
-                    }
-                    break; 
-                case StateType::LONG_PRESS:
-                    if (button->button_pressed) {
-                        ESP_LOGD(LOG_TAG, "%s during long press", button_name.c_str());
+                        ESP_LOGD(LOG_TAG, "%s during long press", button->name.c_str());
                         if (button->during_long_press_callback_func != nullptr) {
                             try {
                                 button->during_long_press_callback_func(button->during_long_press_callback_func_args);
@@ -457,56 +580,222 @@ void ButtonManager::run_task(void *) {
                                 ESP_LOGE(LOG_TAG, "unexpected->%s", e.what());
                             }
                         }
-                    } else {
-                        new_state(button_name, button, StateType::LONG_PRESS_RELEASE);
-                        button->start_time = esp_log_timestamp();
+                        new_state(button, StateType::LONG_PRESS);
+                        button->start_time = current_time;
                     }
-                    break;
-                case StateType::LONG_PRESS_RELEASE:
-                    if (button->button_pressed) {
-                        if (button->wait_time < button->debounce_ticks) {
-                            new_state(button_name, button, button->last_state);
+                }
+            } else {
+                if (button->wait_time >= button->debounce_ticks) {
+                    new_state(button, StateType::PRESS_RELEASE);
+                    button->start_time = current_time;
+                }
+            }
+            break;
+        case StateType::PRESS_RELEASE:
+            if (!button->button_pressed) {
+                if (button->wait_time >= button->debounce_ticks) {
+                    button->click_count += 1;
+                    new_state(button, StateType::COUNT);
+                }
+            }
+            break;
+        case StateType::COUNT:
+            if (button->button_pressed) {
+                new_state(button, StateType::PRESS);
+                button->start_time = current_time;
+            } else {
+                if (button->wait_time >= button->click_ticks || button->click_count == button->max_click_count) {
+                    if (button->click_count == 1) {
+                        ESP_LOGD(LOG_TAG, "%s click", button->name.c_str());
+                        if (button->click_callback_func != nullptr) {
+                            try {
+                                button->click_callback_func(button->click_callback_func_args);
+                            } catch(const std::exception& e) {
+                                ESP_LOGE(LOG_TAG, "unexpected->%s", e.what());
+                            }
+                        }
+                    } else if (button->click_count == 2) {
+                        ESP_LOGD(LOG_TAG, "%s double click", button->name.c_str());
+                        if (button->double_click_callback_func != nullptr) {
+                            try {
+                                button->double_click_callback_func(button->double_click_callback_func_args);
+                            } catch(const std::exception& e) {
+                                ESP_LOGE(LOG_TAG, "unexpected->%s", e.what());
+                            }
                         }
                     } else {
-                        if (button->wait_time >= button->debounce_ticks) {
-                            ESP_LOGD(LOG_TAG, "%s long press stop", button_name.c_str());
-                            if (button->long_press_stop_callback_func != nullptr) {
-                                try {
-                                    button->long_press_stop_callback_func(button->long_press_stop_callback_func_args);
-                                } catch(const std::exception& e) {
-                                    ESP_LOGE(LOG_TAG, "unexpected->%s", e.what());
-                                }
+                        ESP_LOGD(LOG_TAG, "%s multi click", button->name.c_str());
+                        if (button->multi_click_callback_func != nullptr) {
+                            try {
+                                button->multi_click_callback_func(button->multi_click_callback_func_args);
+                            } catch(const std::exception& e) {
+                                ESP_LOGE(LOG_TAG, "unexpected->%s", e.what());
                             }
-                            reset(button);
                         }
                     }
-                    break;
-                default:
                     reset(button);
-                    break;
+                }
+            }
+            break;
+        case StateType::LONG_PRESS:
+            if (button->button_pressed) {
+                // 中断模式下按周期调用，轮询模式下每次处理都调用
+                if (button->during_long_press_callback_func != nullptr
+                    && (!use_interrupt || button->wait_time >= POLL_INTERVAL)) {
+                    ESP_LOGD(LOG_TAG, "%s during long press", button->name.c_str());
+                    try {
+                        button->during_long_press_callback_func(button->during_long_press_callback_func_args);
+                    } catch(const std::exception& e) {
+                        ESP_LOGE(LOG_TAG, "unexpected->%s", e.what());
+                    }
+                    button->start_time = current_time;
+                }
+            } else {
+                new_state(button, StateType::LONG_PRESS_RELEASE);
+                button->start_time = current_time;
+            }
+            break;
+        case StateType::LONG_PRESS_RELEASE:
+            if (!button->button_pressed) {
+                if (button->wait_time >= button->debounce_ticks) {
+                    ESP_LOGD(LOG_TAG, "%s long press stop", button->name.c_str());
+                    if (button->long_press_stop_callback_func != nullptr) {
+                        try {
+                            button->long_press_stop_callback_func(button->long_press_stop_callback_func_args);
+                        } catch(const std::exception& e) {
+                            ESP_LOGE(LOG_TAG, "unexpected->%s", e.what());
+                        }
+                    }
+                    reset(button);
+                }
+            }
+            break;
+        default:
+            reset(button);
+            break;
+    }
+    return state != button->state || click_count != button->click_count;
+}
+
+uint32_t ButtonManager::get_wait_time(Button *button, const uint32_t current_time)
+{
+    auto elapsed = current_time - button->start_time;
+    // 距离判断窗口结束的剩余时间
+    auto remaining = [elapsed](const uint32_t ticks) -> uint32_t {
+        return ticks > elapsed ? ticks - elapsed : 0;
+    };
+    switch (button->state)
+    {
+        case StateType::INIT:
+            return WAIT_FOREVER;
+        case StateType::PRESS:
+            if (!button->button_pressed) {
+                return remaining(button->debounce_ticks);
+            }
+            return button->has_long_press ? remaining(button->press_ticks + 1) : WAIT_FOREVER;
+        case StateType::PRESS_RELEASE:
+        case StateType::LONG_PRESS_RELEASE:
+            // 消抖时间后仍按下则等待松开
+            if (button->button_pressed) {
+                return WAIT_FOREVER;
+            }
+            return remaining(button->debounce_ticks);
+        case StateType::COUNT:
+            return remaining(button->click_ticks);
+        case StateType::LONG_PRESS:
+            if (button->during_long_press_callback_func != nullptr) {
+                return remaining(POLL_INTERVAL);
+            }
+            return WAIT_FOREVER;
+        default:
+            return 0;
+    }
+}
+
+uint32_t ButtonManager::GetWakeupCount()
+{
+    return wakeup_count;
+}
+
+void ButtonManager::timer_callback(void *)
+{
+    // 设置临界区
+    mutex.Lock();
+    // 一次性事件已触发，句柄失效
+    timer_handle = Timer::INVALID_HANDLE;
+    // 退出临界区
+    mutex.Unlock();
+    process_all(nullptr);
+}
+
+void ButtonManager::process_all(void *)
+{
+    uint32_t current_time, wait_time;
+    // 设置临界区
+    mutex.Lock();
+    if (!start_flag) {
+        goto DONE;
+    }
+    wakeup_count++;
+    current_time = esp_log_timestamp();
+    wait_time = WAIT_FOREVER;
+    // 处理每一个按钮，状态改变后立即再处理一次，不必等到下一次唤醒
+    for (auto button : buttons)
+    {
+        if (nullptr == button) {
+            continue;
+        }
+        for (auto i = 0; i < 4; i++) {
+            if (!process(button, current_time)) {
+                break;
             }
         }
-        // 退出临界区
-        xSemaphoreGive(mutex);
-        //休眠至下一处理周期
-        System::Sleep(10);
+        auto button_wait_time = get_wait_time(button, current_time);
+        if (button_wait_time < wait_time) {
+            wait_time = button_wait_time;
+        }
+    }
+    // 轮询模式下由周期性事件处理
+    if (!use_interrupt) {
+        goto DONE;
     }
+    // 等待电平变化或最近的判断窗口结束
+    if (WAIT_FOREVER == wait_time) {
+        if (Timer::INVALID_HANDLE != timer_handle) {
+            Timer::Del(timer_handle);
+            timer_handle = Timer::INVALID_HANDLE;
+        }
+    } else if (Timer::INVALID_HANDLE == timer_handle || !Timer::Reschedule(timer_handle, wait_time)) {
+        timer_handle = Timer::AddOneShotEvent(wait_time, timer_callback);
+    }
+DONE:
+    // 退出临界区
+    mutex.Unlock();
 }
 
 void ButtonManager::Stop()
 {
     // 设置临界区
-    xSemaphoreTake(mutex, portMAX_DELAY);
+    mutex.Lock();
     if (start_flag == false) { 
         ESP_LOGD(LOG_TAG, "this has been stopped");
         goto DONE;
     }
-    vTaskDelete(task_handler);
-    task_handler = nullptr;
+    if (Timer::INVALID_HANDLE != timer_handle) {
+        Timer::Del(timer_handle);
+        timer_handle = Timer::INVALID_HANDLE;
+    }
+    if (use_interrupt) {
+        for (auto button : buttons) {
+            if (nullptr != button) {
+                disable_interrupt(button);
+            }
+        }
+    }
 DONE:
     start_flag = false;    
     // 退出临界区
-    xSemaphoreGive(mutex);
+    mutex.Unlock();
     return;
 }
 
@@ -3,12 +3,16 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 #include "driver/gpio.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
 
+#include "timer.hpp"
+#include "mutex.hpp"
+
 namespace cubestone_wang 
 {
 
@@ -17,7 +21,12 @@ namespace button
 
 using namespace std;
 
-// 按钮管理类
+/*
+  按钮管理类
+  处理在定时器的调度任务中执行，不再创建单独的任务
+  中断模式下由GPIO边沿中断投递处理，消抖、点击、长按的判断窗口结束时由一次性事件处理，
+  空闲时不占用CPU；轮询模式下每10毫秒读取一次电平
+*/
 class ButtonManager
 {
     public:
@@ -25,10 +34,23 @@ class ButtonManager
          * @brief 回调函数定义
          */
         typedef void (* CallbackFunction_t)(void *);
+        /**
+         * @brief 句柄定义，INVALID_HANDLE表示无效
+         * 低16位为位置+1，高16位为该位置的代数，删除后旧句柄失效
+         */
+        typedef uint32_t Handle_t;
+        static const Handle_t INVALID_HANDLE;
     private:
-        static void run_task(void *);
+        static void process_all(void *);
+        static void timer_callback(void *);
         static bool start_flag;
-        static SemaphoreHandle_t mutex;
+        static bool use_interrupt;
+        static uint32_t wakeup_count;
+        static sync::Mutex mutex;
+        // 中断中触发处理的信号，不占用投递队列，执行前多次触发只执行一次
+        static timer::Timer::Signal_t process_signal;
+        // 中断模式下为判断窗口结束时的一次性事件，轮询模式下为周期性事件
+        static timer::Timer::Handle_t timer_handle;
         enum class StateType {
             INIT,
             PRESS,
@@ -43,6 +65,7 @@ class ButtonManager
         {
             public:
                 static void run_task(void *_this);
+                string name;
                 uint32_t debounce_ticks; 
                 uint32_t click_ticks;  
                 uint32_t press_ticks;  
@@ -65,29 +88,47 @@ class ButtonManager
                 bool button_pressed, has_long_press;
                 StateType state, last_state;
         };
-        static map<string, Button *> button_map;
-        static TaskHandle_t task_handler;
+        static Button *get(const Handle_t handle);
+        static vector<Button *> buttons;
+        // 各位置的代数，每次删除后递增，防止旧句柄误用新添加的按钮
+        static vector<uint16_t> generations;
+        static map<string, Handle_t> name_to_handle;
+        static void isr_handler(void *args);
+        static void enable_interrupt(Button *button);
+        static void disable_interrupt(Button *button);
+        static void update_settings(Button *button);
+        static void reset(Button *button);
+        static void new_state(Button *button, const StateType state);
+        static bool process(Button *button, const uint32_t current_time);
+        static uint32_t get_wait_time(Button *button, const uint32_t current_time);
     public:
         /**
          * @brief 添加
          * 
          * @param name 名称
-         * @param button 实例
+         * @param pin GPIO
+         * @param button_pressed_level 按下时的电平
+         * @return 句柄，失败时返回INVALID_HANDLE
          */
-        static bool Add(const string& name, const gpio_num_t pin, const uint8_t button_pressed_level=0);
+        static Handle_t Add(const string& name, const gpio_num_t pin, const uint8_t button_pressed_level=0);
         /**
          * @brief 删除
          * 
          * @param name 名称
          */
         static bool Del(const string& name);
+        /**
+         * @brief 根据名称获取句柄，找不到时返回INVALID_HANDLE
+         *
+         * @param name 名称
+         */
+        static Handle_t GetHandle(const string& name);
         /**
          * @brief 启动
          * 
-         * @param task_priority 任务优先级
-         * @param stack_depth 任务栈深度
+         * @param use_interrupt 是否使用中断模式
          */
-        static bool Start(const UBaseType_t task_priority=2, const uint32_t stack_depth=4096);
+        static bool Start(const bool use_interrupt=true);
         /**
          * @brief 停止
          */
@@ -160,6 +201,22 @@ class ButtonManager
          * @param ticks 周期（毫秒）
          */
         static bool SetPressTicks(const string& name, const uint32_t ticks=800);
+        /*
+          以下为使用句柄的版本，省去按名称查找
+        */
+        static bool SetClickCallbackFunction(const Handle_t handle, const CallbackFunction_t func=nullptr, void *args=nullptr);
+        static bool SetDoubleClickCallbackFunction(const Handle_t handle, const CallbackFunction_t func=nullptr, void *args=nullptr);
+        static bool SetMultiClickCallbackFunction(const Handle_t handle, const CallbackFunction_t func=nullptr, void *args=nullptr);
+        static bool SetLongPressStartCallbackFunction(const Handle_t handle, const CallbackFunction_t func=nullptr, void *args=nullptr);
+        static bool SetLongPressStopCallbackFunction(const Handle_t handle, const CallbackFunction_t func=nullptr, void *args=nullptr);
+        static bool SetDuringLongPressCallbackFunction(const Handle_t handle, const CallbackFunction_t func=nullptr, void *args=nullptr);
+        static bool SetDebounceTicks(const Handle_t handle, const uint32_t ticks=50);
+        static bool SetClickTicks(const Handle_t handle, const uint32_t ticks=400);
+        static bool SetPressTicks(const Handle_t handle, const uint32_t ticks=800);
+        /**
+         * @brief 获取处理次数
+         */
+        static uint32_t GetWakeupCount();
         // 日志标签
         static const char *const LOG_TAG;
     
@@ -1,3 +1,6 @@
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+
 #include "base_config.hpp"
 
 namespace cubestone_wang 
@@ -6,8 +9,66 @@ namespace cubestone_wang
 namespace config
 {
 
+// 二进制格式的魔数及编码版本
+static const uint8_t BINARY_MAGIC = 0xC5;
+static const uint8_t BINARY_CODEC_VERSION = 1;
+static const size_t BINARY_HEADER_SIZE = 3;
+static const size_t BINARY_CRC_SIZE = 4;
+
 const char *const BaseConfig::LOG_TAG = "BASE_CONFIG";
 
+uint8_t BaseConfig::GetSchemaVersion() const
+{
+    return 1;
+}
+
+std::string BaseConfig::Serialize() const
+{
+    BinaryEncoder encoder;
+    Encode(encoder);
+    auto &payload = encoder.GetData();
+    std::string data;
+    data.reserve(BINARY_HEADER_SIZE + payload.length() + BINARY_CRC_SIZE);
+    data.push_back((char)BINARY_MAGIC);
+    data.push_back((char)BINARY_CODEC_VERSION);
+    data.push_back((char)GetSchemaVersion());
+    data.append(payload);
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t *)data.data(), data.length());
+    for (size_t index = 0; index < BINARY_CRC_SIZE; index++) {
+        data.push_back((char)(crc >> (index * 8)));
+    }
+    return data;
+}
+
+bool BaseConfig::Deserialize(const std::string &data)
+{
+    auto buffer = (const uint8_t *)data.data();
+    if (data.length() < BINARY_HEADER_SIZE + BINARY_CRC_SIZE) {
+        ESP_LOGE(LOG_TAG, "data is too short, %d", data.length());
+        return false;
+    }
+    if (BINARY_MAGIC != buffer[0] || BINARY_CODEC_VERSION != buffer[1]) {
+        ESP_LOGE(LOG_TAG, "unsupported format %02x %02x", buffer[0], buffer[1]);
+        return false;
+    }
+    size_t crc_position = data.length() - BINARY_CRC_SIZE;
+    uint32_t crc = 0;
+    for (size_t index = 0; index < BINARY_CRC_SIZE; index++) {
+        crc |= (uint32_t)buffer[crc_position + index] << (index * 8);
+    }
+    if (crc != esp_rom_crc32_le(0, buffer, crc_position)) {
+        ESP_LOGE(LOG_TAG, "crc error");
+        return false;
+    }
+    BinaryDecoder decoder(buffer + BINARY_HEADER_SIZE, crc_position - BINARY_HEADER_SIZE);
+    Reset();
+    if (false == Decode(decoder, buffer[2]) || decoder.IsError()) {
+        ESP_LOGE(LOG_TAG, "decode error");
+        return false;
+    }
+    return true;
+}
+
 }
 
 }
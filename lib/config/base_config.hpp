@@ -3,21 +3,65 @@
 
 #include <string>
 
+#include "binary_codec.hpp"
+
 namespace cubestone_wang 
 {
 
 namespace config
 {
 
+/*
+  配置基类
+  保存到NVS时使用二进制格式：魔数(1) + 编码版本(1) + 结构版本(1) + TLV数据 + CRC32(4，小端)，
+  JSON只用于导入导出及读取旧版本保存的数据
+*/
 class BaseConfig
 {
     public:
         // 日志标签
         static const char *const LOG_TAG;
         virtual void Reset()=0;
-        virtual std::string Dump()=0;
+        /**
+         * @brief 导出为JSON
+         */
+        virtual std::string Dump() const=0;
+        /**
+         * @brief 从JSON导入
+         */
         virtual bool Load(const char *const config_data)=0;
         virtual bool Load(const std::string &config_data)=0;
+        /**
+         * @brief 结构版本，字段含义改变时增加，解码时可据此转换旧数据
+         */
+        virtual uint8_t GetSchemaVersion() const;
+        /**
+         * @brief 编码各字段，不含头部及校验
+         *
+         * @param encoder 编码器
+         */
+        virtual void Encode(BinaryEncoder &encoder) const=0;
+        /**
+         * @brief 解码各字段，调用前已Reset，未出现的字段保持默认值
+         *
+         * @param decoder 解码器
+         * @param schema_version 数据的结构版本
+         */
+        virtual bool Decode(BinaryDecoder &decoder, const uint8_t schema_version)=0;
+        /**
+         * @brief 序列化为带头部及校验的二进制数据
+         */
+        std::string Serialize() const;
+        /**
+         * @brief 从二进制数据反序列化，失败时返回false，头部或校验错误时不修改配置
+         *
+         * @param data 数据
+         */
+        bool Deserialize(const std::string &data);
+        /**
+         * @brief 复制，用于在副本上修改后发布新版本
+         */
+        virtual BaseConfig *Clone() const=0;
         virtual ~BaseConfig(){};
 };
 
@@ -0,0 +1,146 @@
+#include "binary_codec.hpp"
+
+namespace cubestone_wang
+{
+
+namespace config
+{
+
+// 字段类型
+static const uint8_t TYPE_VARINT = 0;
+static const uint8_t TYPE_BYTES = 2;
+
+BinaryEncoder::BinaryEncoder(const size_t reserve)
+{
+    data.reserve(reserve);
+}
+
+void BinaryEncoder::write_varint(uint32_t value)
+{
+    while (value >= 0x80) {
+        data.push_back((char)((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    data.push_back((char)value);
+}
+
+void BinaryEncoder::WriteUInt(const uint8_t field, const uint32_t value)
+{
+    write_varint(((uint32_t)field << 3) | TYPE_VARINT);
+    write_varint(value);
+}
+
+void BinaryEncoder::WriteString(const uint8_t field, const std::string &value)
+{
+    write_varint(((uint32_t)field << 3) | TYPE_BYTES);
+    write_varint(value.length());
+    data.append(value);
+}
+
+void BinaryEncoder::WriteMessage(const uint8_t field, const BinaryEncoder &message)
+{
+    WriteString(field, message.data);
+}
+
+const std::string &BinaryEncoder::GetData() const
+{
+    return data;
+}
+
+BinaryDecoder::BinaryDecoder(const uint8_t *data, const size_t length)
+    : data(data), length(length), position(0), field(0), type(0), value(0), bytes(nullptr), error(false)
+{
+}
+
+bool BinaryDecoder::read_varint(uint32_t &value)
+{
+    value = 0;
+    for (uint8_t shift = 0; shift < 35; shift += 7) {
+        if (position >= length) {
+            return false;
+        }
+        uint8_t byte = data[position++];
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if (0 == (byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool BinaryDecoder::Next()
+{
+    if (error || position >= length) {
+        return false;
+    }
+    uint32_t tag;
+    if (false == read_varint(tag) || (tag >> 3) > UINT8_MAX) {
+        error = true;
+        return false;
+    }
+    field = tag >> 3;
+    type = tag & 0x07;
+    if (false == read_varint(value)) {
+        error = true;
+        return false;
+    }
+    switch (type) {
+        case TYPE_VARINT:
+            bytes = nullptr;
+            break;
+        case TYPE_BYTES:
+            // value为长度
+            if (value > length - position) {
+                error = true;
+                return false;
+            }
+            bytes = data + position;
+            position += value;
+            break;
+        default:
+            error = true;
+            return false;
+    }
+    return true;
+}
+
+uint8_t BinaryDecoder::GetField() const
+{
+    return field;
+}
+
+bool BinaryDecoder::GetUInt(uint32_t &value) const
+{
+    if (TYPE_VARINT != type) {
+        return false;
+    }
+    value = this->value;
+    return true;
+}
+
+bool BinaryDecoder::GetString(std::string &value) const
+{
+    if (TYPE_BYTES != type) {
+        return false;
+    }
+    value.assign((const char *)bytes, this->value);
+    return true;
+}
+
+bool BinaryDecoder::GetMessage(BinaryDecoder &message) const
+{
+    if (TYPE_BYTES != type) {
+        return false;
+    }
+    message = BinaryDecoder(bytes, this->value);
+    return true;
+}
+
+bool BinaryDecoder::IsError() const
+{
+    return error;
+}
+
+}
+
+}
@@ -0,0 +1,112 @@
+#ifndef _binary_codec_hpp_
+#define _binary_codec_hpp_
+
+#include <string>
+
+namespace cubestone_wang
+{
+
+namespace config
+{
+
+/*
+  二进制TLV编码
+  每个字段为 标签 + 值，标签为 (字段号 << 3) | 类型，类型为变长整数或带长度的数据（字符串、嵌套消息），
+  标签、整数及长度均使用7位变长编码，字段号1~15的标签占1字节；解码时跳过未知字段，新增字段不影响旧数据的读取
+*/
+class BinaryEncoder
+{
+    public:
+        /**
+         * @brief 构造
+         *
+         * @param reserve 预留的缓冲区大小（字节），避免多次分配
+         */
+        explicit BinaryEncoder(const size_t reserve=64);
+        /**
+         * @brief 写入无符号整数
+         *
+         * @param field 字段号（1~255）
+         * @param value 值
+         */
+        void WriteUInt(const uint8_t field, const uint32_t value);
+        /**
+         * @brief 写入字符串
+         *
+         * @param field 字段号（1~255）
+         * @param value 值
+         */
+        void WriteString(const uint8_t field, const std::string &value);
+        /**
+         * @brief 写入嵌套消息
+         *
+         * @param field 字段号（1~255）
+         * @param message 已编码的消息
+         */
+        void WriteMessage(const uint8_t field, const BinaryEncoder &message);
+        /**
+         * @brief 获取编码结果
+         */
+        const std::string &GetData() const;
+    private:
+        void write_varint(uint32_t value);
+        std::string data;
+};
+
+class BinaryDecoder
+{
+    public:
+        /**
+         * @brief 构造，不复制数据，解码期间data需保持有效
+         *
+         * @param data 数据
+         * @param length 长度（字节）
+         */
+        BinaryDecoder(const uint8_t *data, const size_t length);
+        /**
+         * @brief 读取下一个字段，没有更多字段或数据损坏时返回false
+         */
+        bool Next();
+        /**
+         * @brief 当前字段号
+         */
+        uint8_t GetField() const;
+        /**
+         * @brief 以无符号整数读取当前字段，类型不符时返回false
+         *
+         * @param value 值
+         */
+        bool GetUInt(uint32_t &value) const;
+        /**
+         * @brief 以字符串读取当前字段，类型不符时返回false
+         *
+         * @param value 值
+         */
+        bool GetString(std::string &value) const;
+        /**
+         * @brief 以嵌套消息读取当前字段，类型不符时返回false
+         *
+         * @param message 消息
+         */
+        bool GetMessage(BinaryDecoder &message) const;
+        /**
+         * @brief 数据是否损坏
+         */
+        bool IsError() const;
+    private:
+        bool read_varint(uint32_t &value);
+        const uint8_t *data;
+        size_t length;
+        size_t position;
+        uint8_t field;
+        uint8_t type;
+        uint32_t value;
+        const uint8_t *bytes;
+        bool error;
+};
+
+}
+
+}
+
+#endif // _binary_codec_hpp_
@@ -1,6 +1,7 @@
 #include <string>
 
 #include "esp_log.h"
+#include "esp_rom_crc.h"
 
 #include "nonvolatile_storage.hpp"
 
@@ -13,18 +14,74 @@ namespace config
 {
 
 using namespace nonvolatile_storage;
+using namespace timer;
 
 const char *const ConfigManager::LOG_TAG = "CONFIG_MANAGER";
 const char *const ConfigManager::ns = "CONFIG";
-SemaphoreHandle_t ConfigManager::mutex = xSemaphoreCreateRecursiveMutex();
-std::map<std::string, BaseConfig *> ConfigManager::config_map;
+const char *const ConfigManager::binary_ns = "CONFIG_BIN";
+sync::Mutex ConfigManager::mutex("config_manager", true);
+const ConfigManager::Handle_t ConfigManager::INVALID_HANDLE = 0;
+std::shared_ptr<const BaseConfig> ConfigManager::configs[ConfigManager::MAX_CONFIG_COUNT];
+portMUX_TYPE ConfigManager::spinlock = portMUX_INITIALIZER_UNLOCKED;
+std::atomic<uint32_t> ConfigManager::versions[ConfigManager::MAX_CONFIG_COUNT];
+std::map<std::string, ConfigManager::Handle_t> ConfigManager::name_to_handle;
+ConfigManager::State ConfigManager::states[ConfigManager::MAX_CONFIG_COUNT] = {};
+Timer::Handle_t ConfigManager::flush_timer_handle = Timer::INVALID_HANDLE;
+int64_t ConfigManager::first_dirty_timestamp = 0;
+
+static uint32_t get_hash(const std::string &data)
+{
+    return esp_rom_crc32_le(0, (const uint8_t *)data.data(), data.length());
+}
+
+bool ConfigManager::write(const std::string &name, const Handle_t handle, const bool commit, bool &written)
+{
+    auto &state = states[handle - 1];
+    auto data = configs[handle - 1]->Serialize();
+    auto hash = get_hash(data);
+    written = false;
+    state.Dirty = false;
+    if (state.HashValid && hash == state.Hash) {
+        ESP_LOGD(LOG_TAG, "%s is unchanged, skip", name.c_str());
+        return true;
+    }
+    if (false == NonvolatileStorage::WriteBlob(binary_ns, name, data, commit)) {
+        // 稍后重试
+        state.Dirty = true;
+        schedule_flush();
+        return false;
+    }
+    if (commit) {
+        state.HashValid = true;
+        state.Hash = hash;
+    } else {
+        // 由调用者提交后更新
+        state.Pending = true;
+        state.PendingHash = hash;
+    }
+    written = true;
+    return true;
+}
+
+void ConfigManager::publish(const Handle_t handle, BaseConfig *config)
+{
+    // 调用者已设置临界区
+    std::shared_ptr<const BaseConfig> old_config(config);
+    portENTER_CRITICAL(&spinlock);
+    configs[handle - 1].swap(old_config);
+    portEXIT_CRITICAL(&spinlock);
+    versions[handle - 1].fetch_add(1, std::memory_order_release);
+    // 读者仍持有快照时，旧版本在最后一个快照释放时才被释放
+}
 
 bool ConfigManager::inner_reset(const std::string &name, bool debug_log_enable)
 {
     bool result = true;
-    auto iter = config_map.find(name);
-    if (iter!=config_map.end()) {
-       iter->second->Reset();
+    auto iter = name_to_handle.find(name);
+    if (iter!=name_to_handle.end()) {
+        auto config = configs[iter->second - 1]->Clone();
+        config->Reset();
+        publish(iter->second, config);
         if (true == debug_log_enable) {
             ESP_LOGD(LOG_TAG, "%s reset success", name.c_str());
         }
@@ -38,13 +95,14 @@ bool ConfigManager::inner_reset(const std::string &name, bool debug_log_enable)
 bool ConfigManager::inner_save(const std::string &name, bool debug_log_enable)
 {
     bool result = true;
-    auto iter = config_map.find(name);
-    if (iter!=config_map.end()) {
-        result = NonvolatileStorage::WriteString(ns, name.c_str(), iter->second->Dump());
+    bool written;
+    auto iter = name_to_handle.find(name);
+    if (iter!=name_to_handle.end()) {
+        result = write(name, iter->second, true, written);
         if (false == result) {
             ESP_LOGE(LOG_TAG, "%s save failed", name.c_str());
         } else {
-            if (true == debug_log_enable) {
+            if (true == debug_log_enable && true == written) {
                 ESP_LOGD(LOG_TAG, "%s save success", name.c_str());
             }
         }
@@ -60,12 +118,44 @@ bool ConfigManager::inner_load(const std::string &name, bool debug_log_enable)
 {
     std::string config_data;
     bool result = true;
-    auto iter = config_map.find(name);
-    if (iter!=config_map.end()) {
-        config_data = NonvolatileStorage::ReadString(ns, name);
-        ESP_LOGD(LOG_TAG, "%s: %d %s", name.c_str(), config_data.length(), config_data.c_str());
-        result = iter->second->Load(config_data);
+    auto iter = name_to_handle.find(name);
+    if (iter!=name_to_handle.end()) {
+        auto config = configs[iter->second - 1]->Clone();
+        auto &state = states[iter->second - 1];
+        state.Dirty = false;
+        state.HashValid = false;
+        if (NonvolatileStorage::ReadBlob(binary_ns, name, config_data)) {
+            ESP_LOGD(LOG_TAG, "%s: %d B", name.c_str(), config_data.length());
+            if (false == config->Deserialize(config_data)) {
+                // 数据损坏时使用默认值，与JSON解析失败的处理一致
+                ESP_LOGE(LOG_TAG, "%s is corrupted, reset", name.c_str());
+                config->Reset();
+            } else {
+                state.HashValid = true;
+                state.Hash = get_hash(config_data);
+            }
+            publish(iter->second, config);
+            config = nullptr;
+        } else {
+            // 没有二进制数据时读取旧版本的JSON，成功后转换为二进制保存并删除JSON
+            config_data = NonvolatileStorage::ReadString(ns, name);
+            result = config->Load(config_data);
+            if (true == result) {
+                publish(iter->second, config);
+                config = nullptr;
+            }
+            if (true == result && "" != config_data) {
+                ESP_LOGI(LOG_TAG, "%s: migrate %d B JSON to binary", name.c_str(), config_data.length());
+                bool written;
+                if (write(name, iter->second, true, written)) {
+                    NonvolatileStorage::Erase(ns, name);
+                    NonvolatileStorage::Erase(ns, name + "_l");
+                }
+            }
+        }
         if (false == result) {
+            // 加载失败时不发布
+            delete config;
             ESP_LOGE(LOG_TAG, "%s load failed", name.c_str());
         } else {
             if (true == debug_log_enable) {
@@ -82,7 +172,7 @@ bool ConfigManager::inner_load(const std::string &name, bool debug_log_enable)
 bool ConfigManager::inner_run_func(InnerFunc_t inner_func, EndFunc_t end_func, const std::string &name)
 {
     // 设置临界区
-    xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
+    mutex.Lock();
     bool result = true;
     if ("" != name) {
         result = inner_func(name, true);
@@ -90,7 +180,7 @@ bool ConfigManager::inner_run_func(InnerFunc_t inner_func, EndFunc_t end_func, c
             goto DONE;
         }
     } else {
-        for (auto iter=config_map.begin(); iter!=config_map.end(); iter++) {
+        for (auto iter=name_to_handle.begin(); iter!=name_to_handle.end(); iter++) {
             result = inner_func(iter->first, false);
             if (false == result) {
                 goto DONE;
@@ -100,7 +190,7 @@ bool ConfigManager::inner_run_func(InnerFunc_t inner_func, EndFunc_t end_func, c
     }
 DONE:
     // 退出临界区
-    xSemaphoreGiveRecursive(mutex);  
+    mutex.Unlock();  
     return result;
 }
 
@@ -131,64 +221,296 @@ bool ConfigManager::Load(const std::string &name)
                           name);
 }
 
-BaseConfig *ConfigManager::Get(const std::string &name)
+ConfigManager::Snapshot ConfigManager::Get(const Handle_t handle)
+{
+    // 只在复制指针时短暂关中断，不加锁
+    if (INVALID_HANDLE == handle || handle > MAX_CONFIG_COUNT) {
+        ESP_LOGE(LOG_TAG, "invalid handle %lu", handle);
+        return nullptr;
+    }
+    portENTER_CRITICAL(&spinlock);
+    Snapshot config = configs[handle - 1];
+    portEXIT_CRITICAL(&spinlock);
+    return config;
+}
+
+uint32_t ConfigManager::GetVersion(const Handle_t handle)
+{
+    if (INVALID_HANDLE == handle || handle > MAX_CONFIG_COUNT) {
+        ESP_LOGE(LOG_TAG, "invalid handle %lu", handle);
+        return 0;
+    }
+    return versions[handle - 1].load(std::memory_order_acquire);
+}
+
+BaseConfig *ConfigManager::Edit(const Handle_t handle)
+{
+    // 已发布的版本不会被修改，持有快照复制时无需加锁
+    auto config = Get(handle);
+    if (nullptr == config) {
+        return nullptr;
+    }
+    return config->Clone();
+}
+
+BaseConfig *ConfigManager::Edit(const std::string &name)
+{
+    return Edit(GetHandle(name));
+}
+
+bool ConfigManager::Publish(const Handle_t handle, BaseConfig *config, const bool persist)
 {
-    BaseConfig *config;
+    if (INVALID_HANDLE == handle || handle > MAX_CONFIG_COUNT || nullptr == config) {
+        ESP_LOGE(LOG_TAG, "invalid handle %lu", handle);
+        delete config;
+        return false;
+    }
+    bool result = true;
     // 设置临界区
-    xSemaphoreTake(mutex, portMAX_DELAY);
-    auto iter = config_map.find(name);
-    if (iter != config_map.end()) {
-        config = iter->second;
+    mutex.Lock();
+    if (nullptr == configs[handle - 1]) {
+        ESP_LOGE(LOG_TAG, "config %lu has been deleted", handle);
+        delete config;
+        result = false;
+        goto DONE;
+    }
+    publish(handle, config);
+    if (persist) {
+        MarkDirty(handle);
+    }
+DONE:
+    // 退出临界区
+    mutex.Unlock();
+    return result;
+}
+
+bool ConfigManager::Publish(const std::string &name, BaseConfig *config, const bool persist)
+{
+    return Publish(GetHandle(name), config, persist);
+}
+
+ConfigManager::Handle_t ConfigManager::GetHandle(const std::string &name)
+{
+    Handle_t handle;
+    // 设置临界区
+    mutex.Lock();
+    auto iter = name_to_handle.find(name);
+    if (iter != name_to_handle.end()) {
+        handle = iter->second;
+    } else {
+        ESP_LOGE(LOG_TAG, "can't find %s config", name.c_str());
+        handle = INVALID_HANDLE;
+    }
+    // 退出临界区
+    mutex.Unlock();
+    return handle;
+}
+
+ConfigManager::Snapshot ConfigManager::Get(const std::string &name)
+{
+    Snapshot config;
+    // 设置临界区
+    mutex.Lock();
+    auto iter = name_to_handle.find(name);
+    if (iter != name_to_handle.end()) {
+        // 持有mutex时不会被替换，直接复制
+        config = configs[iter->second - 1];
     } else {
         ESP_LOGE(LOG_TAG, "can't find %s config", name.c_str());
         config = nullptr;
     }
     // 退出临界区
-    xSemaphoreGive(mutex);
+    mutex.Unlock();
     return config;
 }
 
-bool ConfigManager::Add(const std::string &name, BaseConfig *config, const bool &override)
+ConfigManager::Handle_t ConfigManager::Add(const std::string &name, BaseConfig *config, const bool &override)
 {
-    bool result;
+    Handle_t handle = INVALID_HANDLE;
     // 设置临界区
-    xSemaphoreTake(mutex, portMAX_DELAY);
-    auto iter = config_map.find(name);
-    if (iter != config_map.end()) {
+    mutex.Lock();
+    auto iter = name_to_handle.find(name);
+    if (iter != name_to_handle.end()) {
         if (true == override) {
-            delete iter->second;
-            iter->second = config;
-            result = true;
+            handle = iter->second;
+            publish(handle, config);
+            states[handle - 1] = {};
         } else {
             ESP_LOGE(LOG_TAG, "%s config has been exist", name.c_str());
-            result = false;
         }
-    } else {
-        config_map[name] = config;
-        result = true;
+        goto DONE;
     }
+    for (Handle_t i = 1; i <= MAX_CONFIG_COUNT; i++) {
+        if (nullptr == configs[i - 1]) {
+            handle = i;
+            break;
+        }
+    }
+    if (INVALID_HANDLE == handle) {
+        ESP_LOGE(LOG_TAG, "too many configs, %s can't be added", name.c_str());
+        goto DONE;
+    }
+    publish(handle, config);
+    states[handle - 1] = {};
+    name_to_handle[name] = handle;
+DONE:
     // 退出临界区
-    xSemaphoreGive(mutex);
-    return result;
+    mutex.Unlock();
+    return handle;
 }
 
 bool ConfigManager::Del(const std::string &name)
 {
     bool result;
     // 设置临界区
-    xSemaphoreTake(mutex, portMAX_DELAY);
-    auto iter = config_map.find(name);
-    if (iter != config_map.end()) {
-        delete iter->second;
-        iter->second = nullptr;
-        config_map.erase(iter);
+    mutex.Lock();
+    auto iter = name_to_handle.find(name);
+    if (iter != name_to_handle.end()) {
+        publish(iter->second, nullptr);
+        states[iter->second - 1] = {};
+        name_to_handle.erase(iter);
         result = true;
     } else {
         ESP_LOGE(LOG_TAG, "can't find %s config", name.c_str());
         result = false;
     }
     // 退出临界区
-    xSemaphoreGive(mutex);
+    mutex.Unlock();
+    return result;
+}
+
+std::string ConfigManager::Export(const std::string &name)
+{
+    std::string result;
+    // 设置临界区
+    mutex.Lock();
+    auto iter = name_to_handle.find(name);
+    if (iter != name_to_handle.end()) {
+        result = configs[iter->second - 1]->Dump();
+    } else {
+        ESP_LOGE(LOG_TAG, "can't find %s config", name.c_str());
+    }
+    // 退出临界区
+    mutex.Unlock();
+    return result;
+}
+
+bool ConfigManager::Import(const std::string &name, const std::string &config_data)
+{
+    bool result = false;
+    BaseConfig *config = nullptr;
+    // 设置临界区
+    mutex.Lock();
+    auto iter = name_to_handle.find(name);
+    if (iter == name_to_handle.end()) {
+        ESP_LOGE(LOG_TAG, "can't find %s config", name.c_str());
+        goto DONE;
+    }
+    config = configs[iter->second - 1]->Clone();
+    if (false == config->Load(config_data)) {
+        ESP_LOGE(LOG_TAG, "%s import failed", name.c_str());
+        delete config;
+        goto DONE;
+    }
+    publish(iter->second, config);
+    result = inner_save(name, true);
+DONE:
+    // 退出临界区
+    mutex.Unlock();
+    return result;
+}
+
+void ConfigManager::MarkDirty(const Handle_t handle)
+{
+    if (INVALID_HANDLE == handle || handle > MAX_CONFIG_COUNT) {
+        ESP_LOGE(LOG_TAG, "invalid handle %lu", handle);
+        return;
+    }
+    // 设置临界区
+    mutex.Lock();
+    states[handle - 1].Dirty = true;
+    schedule_flush();
+    // 退出临界区
+    mutex.Unlock();
+}
+
+void ConfigManager::schedule_flush()
+{
+    // 调用者已设置临界区
+    int64_t now = esp_timer_get_time();
+    if (Timer::INVALID_HANDLE == flush_timer_handle) {
+        first_dirty_timestamp = now;
+        flush_timer_handle = Timer::AddOneShotEvent(FLUSH_DELAY, flush_callback);
+        if (Timer::INVALID_HANDLE == flush_timer_handle) {
+            ESP_LOGE(LOG_TAG, "add flush event failed");
+        }
+    } else if (now + FLUSH_DELAY * 1000LL <= first_dirty_timestamp + FLUSH_MAX_DELAY * 1000LL) {
+        // 已触发时返回false，回调会写入本次的修改
+        Timer::Reschedule(flush_timer_handle, FLUSH_DELAY);
+    }
+}
+
+void ConfigManager::MarkDirty(const std::string &name)
+{
+    MarkDirty(GetHandle(name));
+}
+
+void ConfigManager::flush_callback(void *)
+{
+    // 设置临界区
+    mutex.Lock();
+    flush_timer_handle = Timer::INVALID_HANDLE;
+    // 退出临界区
+    mutex.Unlock();
+    Flush();
+}
+
+bool ConfigManager::Flush()
+{
+    bool result = true;
+    bool written;
+    uint32_t written_count = 0;
+    // 设置临界区
+    mutex.Lock();
+    for (auto iter = name_to_handle.begin(); iter != name_to_handle.end(); iter++) {
+        if (false == states[iter->second - 1].Dirty) {
+            continue;
+        }
+        if (false == write(iter->first, iter->second, false, written)) {
+            ESP_LOGE(LOG_TAG, "%s save failed", iter->first.c_str());
+            result = false;
+            continue;
+        }
+        if (written) {
+            written_count++;
+        }
+    }
+    // 多个配置的写入只提交一次
+    if (written_count > 0) {
+        bool committed = NonvolatileStorage::Commit(binary_ns);
+        for (auto iter = name_to_handle.begin(); iter != name_to_handle.end(); iter++) {
+            auto &state = states[iter->second - 1];
+            if (false == state.Pending) {
+                continue;
+            }
+            state.Pending = false;
+            if (committed) {
+                state.HashValid = true;
+                state.Hash = state.PendingHash;
+            } else {
+                // 提交失败时Hash保持不变，稍后重新写入
+                state.Dirty = true;
+            }
+        }
+        if (false == committed) {
+            ESP_LOGE(LOG_TAG, "commit failed, retry later");
+            schedule_flush();
+            result = false;
+        }
+    }
+    ESP_LOGD(LOG_TAG, "%lu configs have been flushed", written_count);
+    // 退出临界区
+    mutex.Unlock();
     return result;
 }
 
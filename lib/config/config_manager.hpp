@@ -1,13 +1,17 @@
 #ifndef _config_manager_hpp_
 #define _config_manager_hpp_
 
+#include <atomic>
 #include <map>
+#include <memory>
 #include <set>
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
 
 #include "base_config.hpp"
+#include "mutex.hpp"
+#include "timer.hpp"
 
 namespace cubestone_wang 
 {
@@ -15,21 +19,127 @@ namespace cubestone_wang
 namespace config
 {
 
+/*
+  配置管理类
+  已发布的配置不再修改，读取时获取当前版本的只读快照（引用计数），只在复制指针时短暂关中断，不等待；
+  修改时先用Edit获取副本，修改后用Publish发布新版本，旧版本在最后一个快照释放时才被释放，
+  因此快照可以跨越阻塞的调用，但长期持有会使旧版本一直占用内存
+*/
 class ConfigManager
 {
     public:
         // 日志标签
         static const char *const LOG_TAG;
+        // 句柄定义，INVALID_HANDLE表示无效
+        typedef uint32_t Handle_t;
+        static const Handle_t INVALID_HANDLE;
+        // 最大配置数量
+        static const size_t MAX_CONFIG_COUNT = 16;
+        // 修改后等待该时间（毫秒）没有新的修改再写入，合并连续的修改
+        static const uint32_t FLUSH_DELAY = 3000;
+        // 第一次修改后最长等待时间（毫秒），避免持续修改时一直推迟
+        static const uint32_t FLUSH_MAX_DELAY = 30000;
         static bool Reset(const std::string &name="");
+        // 立即保存，内容与上次保存的相同时跳过写入
         static bool Save(const std::string &name="");
+        /**
+         * @brief 标记为已修改，由定时器延迟写入
+         *
+         * @param handle 句柄
+         */
+        static void MarkDirty(const Handle_t handle);
+        static void MarkDirty(const std::string &name);
+        /**
+         * @brief 立即写入所有已标记修改的配置，只提交一次
+         */
+        static bool Flush();
         static bool Load(const std::string &name="");
-        static BaseConfig *Get(const std::string &name);
-        static bool Add(const std::string &name, BaseConfig *config, const bool &override=true);
+        // 只读快照，持有期间对应的版本不会被释放
+        typedef std::shared_ptr<const BaseConfig> Snapshot;
+        // 获取当前版本的只读快照，找不到时返回空
+        static Snapshot Get(const std::string &name);
+        // 通过句柄获取，不加锁也不查找名称，适合在循环中频繁调用
+        static Snapshot Get(const Handle_t handle);
+        // 获取并转换为具体的配置类型
+        template <typename T>
+        static std::shared_ptr<const T> Get(const std::string &name)
+        {
+            return std::static_pointer_cast<const T>(Get(name));
+        }
+        template <typename T>
+        static std::shared_ptr<const T> Get(const Handle_t handle)
+        {
+            return std::static_pointer_cast<const T>(Get(handle));
+        }
+        /**
+         * @brief 获取版本号，每次发布后递增
+         *
+         * @param handle 句柄
+         */
+        static uint32_t GetVersion(const Handle_t handle);
+        /**
+         * @brief 获取当前版本的副本用于修改，修改后调用Publish，放弃时delete
+         *
+         * @param handle 句柄
+         * @return 失败时返回nullptr
+         */
+        static BaseConfig *Edit(const Handle_t handle);
+        static BaseConfig *Edit(const std::string &name);
+        /**
+         * @brief 发布新版本，之后不应再修改config
+         *
+         * @param handle 句柄
+         * @param config 由Edit获取并修改后的副本，失败时被释放
+         * @param persist 是否标记为已修改，由定时器延迟写入
+         */
+        static bool Publish(const Handle_t handle, BaseConfig *config, const bool persist=true);
+        static bool Publish(const std::string &name, BaseConfig *config, const bool persist=true);
+        static Handle_t GetHandle(const std::string &name);
+        // 返回句柄，名称已存在且允许覆盖时返回原有句柄，失败时返回INVALID_HANDLE
+        static Handle_t Add(const std::string &name, BaseConfig *config, const bool &override=true);
         static bool Del(const std::string &name);
+        /**
+         * @brief 导出为JSON
+         *
+         * @param name 名称
+         * @return 找不到时返回空字符串
+         */
+        static std::string Export(const std::string &name);
+        /**
+         * @brief 从JSON导入并保存
+         *
+         * @param name 名称
+         * @param config_data JSON
+         */
+        static bool Import(const std::string &name, const std::string &config_data);
     private:
-        static SemaphoreHandle_t mutex;
+        static sync::Mutex mutex;
+        // 旧版本以JSON字符串保存的命名空间，只用于读取及迁移
         static const char *const ns;
-        static std::map<std::string, BaseConfig *> config_map;
+        // 以二进制格式保存的命名空间
+        static const char *const binary_ns;
+        // 当前版本，发布后不再修改；替换及读取时复制指针由spinlock保护，写者还需持有mutex
+        static std::shared_ptr<const BaseConfig> configs[MAX_CONFIG_COUNT];
+        static portMUX_TYPE spinlock;
+        static std::atomic<uint32_t> versions[MAX_CONFIG_COUNT];
+        static std::map<std::string, Handle_t> name_to_handle;
+        // 保存状态
+        struct State {
+            bool Dirty;
+            bool HashValid;
+            // 上次读取或写入的数据的CRC32
+            uint32_t Hash;
+            // 已写入但尚未提交，提交成功后才更新Hash
+            bool Pending;
+            uint32_t PendingHash;
+        };
+        static State states[MAX_CONFIG_COUNT];
+        static timer::Timer::Handle_t flush_timer_handle;
+        static int64_t first_dirty_timestamp;
+        static void flush_callback(void *);
+        static void schedule_flush();
+        static void publish(const Handle_t handle, BaseConfig *config);
+        static bool write(const std::string &name, const Handle_t handle, const bool commit, bool &written);
         typedef bool (*InnerFunc_t)(const std::string &name, bool debug_log_enable);
         typedef void (*EndFunc_t)();
         static bool inner_reset(const std::string &name="", bool debug_log_enable=true);
@@ -16,8 +16,8 @@ I2cMaster::I2cMaster(gpio_num_t sda,
                      gpio_num_t scl, 
                      uint32_t clk_speed, 
                      i2c_port_t i2c_num)
+    : mutex(std::string(LOG_TAG) + "_" + std::to_string(i2c_num))
 {
-    mutex = xSemaphoreCreateMutex();
     this->i2c_num = i2c_num;
     i2c_config_t conf;
     conf.mode = I2C_MODE_MASTER;
@@ -41,14 +41,14 @@ void I2cMaster::Write(const uint8_t device_address,
                       const size_t write_size)
 {
     // 设置临界区
-    xSemaphoreTake(mutex, portMAX_DELAY);
+    mutex.Lock();
     ESP_ERROR_CHECK(i2c_master_write_to_device(this->i2c_num, 
                                                device_address, 
                                                write_buffer, 
                                                write_size, 
                                                1000/portTICK_PERIOD_MS));
     // 退出临界区
-    xSemaphoreGive(mutex);
+    mutex.Unlock();
     return;
 }
 
@@ -57,14 +57,14 @@ void I2cMaster::Read(const uint8_t device_address,
                      const size_t read_size)
 {
     // 设置临界区
-    xSemaphoreTake(mutex, portMAX_DELAY);
+    mutex.Lock();
     ESP_ERROR_CHECK(i2c_master_read_from_device(this->i2c_num, 
                                                 device_address,
                                                 read_buffer, 
                                                 read_size, 
                                                 1000/portTICK_PERIOD_MS));
     // 退出临界区
-    xSemaphoreGive(mutex);
+    mutex.Unlock();
     return;
 }
 
@@ -75,7 +75,7 @@ void I2cMaster::ReadAfterWrite(const uint8_t device_address,
                                const size_t read_size)
 {
     // 设置临界区
-    xSemaphoreTake(mutex, portMAX_DELAY);
+    mutex.Lock();
     ESP_ERROR_CHECK(i2c_master_write_read_device(this->i2c_num, 
                                                 device_address,
                                                 write_buffer,
@@ -84,14 +84,14 @@ void I2cMaster::ReadAfterWrite(const uint8_t device_address,
                                                 read_size, 
                                                 1000/portTICK_PERIOD_MS));
     // 退出临界区
-    xSemaphoreGive(mutex);
+    mutex.Unlock();
     return;
 }
 
 void I2cMaster::SearchAddress()
 {
     // 设置临界区
-    xSemaphoreTake(mutex, portMAX_DELAY);
+    mutex.Lock();
     esp_err_t err;
     for (uint8_t address = 0x08; address <= 0x77; address++) {
         i2c_cmd_handle_t handle = i2c_cmd_link_create();
@@ -112,7 +112,7 @@ void I2cMaster::SearchAddress()
         }
     }
     // 退出临界区
-    xSemaphoreGive(mutex);
+    mutex.Unlock();
     return;
 }
 
@@ -6,6 +6,8 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
 
+#include "mutex.hpp"
+
 namespace cubestone_wang 
 {
 
@@ -36,7 +38,7 @@ class I2cMaster
                             const size_t read_size);
         void SearchAddress();
     private:
-        SemaphoreHandle_t mutex;
+        sync::Mutex mutex;
         i2c_port_t i2c_num;
 };
 
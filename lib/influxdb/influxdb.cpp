@@ -1,5 +1,7 @@
 #include "esp_log.h"
 
+#include "resolver.hpp"
+
 #include "influxdb.hpp"
 
 namespace cubestone_wang 
@@ -15,7 +17,9 @@ Influxdb::Influxdb(const std::string &host,
                    const std::string &token,
                    const std::string &org,
                    const std::string &bucket,
-                   const uint8_t &timeout)
+                   const uint8_t &timeout,
+                   const bool &tls,
+                   const std::string &ca_cert)
 {
     this->host = host;
     this->port = port;
@@ -23,6 +27,37 @@ Influxdb::Influxdb(const std::string &host,
     this->org = org;
     this->bucket = bucket;
     this->timeout = timeout;
+    this->tls_connection = nullptr;
+    if (tls) {
+        this->tls_connection = new InfluxdbTLS(host, port, ca_cert, timeout);
+    }
+}
+
+Influxdb::~Influxdb()
+{
+    delete this->tls_connection;
+    this->tls_connection = nullptr;
+}
+
+bool Influxdb::write_tls(const std::string &line, const std::string &query, const std::string &authorization)
+{
+    int status = 0;
+    if (!this->tls_connection->Post("/api/v2/write?" + query, authorization, line, status)) {
+        ESP_LOGE(Influxdb::LOG_TAG, "HTTPS POST request failed");
+        return false;
+    }
+    if (status != 204) {
+        ESP_LOGE(Influxdb::LOG_TAG, "HTTPS POST request failed: %d", status);
+        return false;
+    }
+    return true;
+}
+
+void Influxdb::LogStatistics() const
+{
+    if (nullptr != this->tls_connection) {
+        this->tls_connection->LogStatistics();
+    }
 }
 
 bool Influxdb::WritePoint(const Point &point)
@@ -31,21 +66,38 @@ bool Influxdb::WritePoint(const Point &point)
     std::string line = point.ToLineProtocol();
     std::string query = "bucket=" + this->bucket + "&org=" + this->org;
     std::string authorization = "Token "+this->token;
+    std::string address;
     esp_http_client_config_t config;
+    // HTTPS复用同一连接，不在每次写入时握手
+    if (nullptr != this->tls_connection) {
+        return this->write_tls(line, query, authorization);
+    }
+    // 使用缓存的地址，不在每次写入时解析
+    if (!resolver::Resolver::Resolve(this->host, address)) {
+        ESP_LOGE(Influxdb::LOG_TAG, "resolve %s failed", this->host.c_str());
+        return false;
+    }
     memset((void *)&config, 0, sizeof(config));
-    config.host = this->host.c_str();
+    config.host = address.c_str();
     config.port = this->port;
     config.path = "/api/v2/write";
     config.transport_type = HTTP_TRANSPORT_OVER_TCP;
     config.timeout_ms = this->timeout * 1000;
     config.query = query.c_str();
     esp_http_client_handle_t client = esp_http_client_init(&config);
+    // 连接使用IP地址，Host仍为域名，以便经过反向代理
+    std::string host_header = this->host + ":" + std::to_string(this->port);
+    ESP_ERROR_CHECK(esp_http_client_set_header(client, "Host", host_header.c_str()));
     ESP_ERROR_CHECK(esp_http_client_set_method(client, HTTP_METHOD_POST));
     ESP_ERROR_CHECK(esp_http_client_set_header(client, "Authorization", authorization.c_str()));
     ESP_ERROR_CHECK(esp_http_client_set_post_field(client, line.c_str(), strlen(line.c_str())));
     auto err = esp_http_client_perform(client);
     if (err != ESP_OK) {
         ESP_LOGE(Influxdb::LOG_TAG, "HTTP POST request failed: %s", esp_err_to_name(err));
+        // 地址可能已变化
+        if (ESP_ERR_HTTP_CONNECT == err) {
+            resolver::Resolver::Refresh(this->host);
+        }
     } else {
         auto status = esp_http_client_get_status_code(client);
         if (status != 204) {
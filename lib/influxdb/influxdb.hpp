@@ -6,6 +6,7 @@
 #include "esp_http_client.h"
 
 #include "influxdb_point.hpp"
+#include "influxdb_tls.hpp"
 
 namespace cubestone_wang 
 {
@@ -23,8 +24,17 @@ class Influxdb
                  const std::string &token,
                  const std::string &org,
                  const std::string &bucket,
-                 const uint8_t &timeout=5);
+                 const uint8_t &timeout=5,
+                 const bool &tls=false,
+                 const std::string &ca_cert="");
+        ~Influxdb();
+        Influxdb(const Influxdb &) = delete;
+        Influxdb &operator=(const Influxdb &) = delete;
         bool WritePoint(const Point &point);
+        /**
+         * @brief 输出HTTPS连接的握手统计
+         */
+        void LogStatistics() const;
     private:
         std::string host;
         std::uint16_t port;
@@ -32,6 +42,9 @@ class Influxdb
         std::string org;
         std::string bucket;
         uint8_t timeout;
+        // 使用HTTPS时保持的连接，否则为nullptr
+        InfluxdbTLS *tls_connection;
+        bool write_tls(const std::string &line, const std::string &query, const std::string &authorization);
 };
 
 }
@@ -13,6 +13,20 @@ namespace influxdb
 
 using namespace utils;
 
+// 二进制格式的字段号
+enum Field : uint8_t {
+    FIELD_HOST = 1,
+    FIELD_PORT = 2,
+    FIELD_TOKEN = 3,
+    FIELD_ORG = 4,
+    FIELD_BUCKET = 5,
+    FIELD_TIMEOUT = 6,
+    FIELD_UDP_PORT = 7,
+    FIELD_UDP_SEQUENCE = 8,
+    FIELD_TLS = 9,
+    FIELD_CA_CERT = 10,
+};
+
 const char *const Config::LOG_TAG = "INFLUXDB_CONFIG";
 const uint16_t Config::default_port = 8086;
 const std::string Config::default_org = "default";
@@ -24,9 +38,13 @@ void Config::Reset()
     Port = default_port;
     Org = default_org;
     Timeout = default_timeout;
+    UDPPort = 0;
+    UDPSequence = true;
+    TLS = false;
+    CACert = "";
 }
 
-std::string Config::Dump()
+std::string Config::Dump() const
 {
     cJSON *json_root = cJSON_CreateObject();
     cJSON_AddStringToObject(json_root, "host", Host.c_str());
@@ -35,6 +53,10 @@ std::string Config::Dump()
     cJSON_AddStringToObject(json_root, "org", Org.c_str());
     cJSON_AddStringToObject(json_root, "bucket", Bucket.c_str());
     cJSON_AddNumberToObject(json_root, "timeout", Timeout);
+    cJSON_AddNumberToObject(json_root, "udp_port", UDPPort);
+    cJSON_AddBoolToObject(json_root, "udp_sequence", UDPSequence);
+    cJSON_AddBoolToObject(json_root, "tls", TLS);
+    cJSON_AddStringToObject(json_root, "ca_cert", CACert.c_str());
     char *json_data = cJSON_PrintUnformatted(json_root);
     std::string result = std::string(json_data);
     cJSON_free(json_data);
@@ -110,6 +132,46 @@ bool Config::Load(const char *const config_data)
     } else {
         Timeout = (uint8_t)json_item->valueint;
     }
+    json_item = cJSON_GetObjectItem(json_root, "udp_port");
+    if (NULL == json_item) {
+        UDPPort = 0;
+    } else if (cJSON_Number != json_item->type) {
+        ESP_LOGE(LOG_TAG, "udp_port error");
+        cJSON_Delete(json_root); 
+        return false;
+    } else {
+        UDPPort = (uint16_t)json_item->valueint;
+    }
+    json_item = cJSON_GetObjectItem(json_root, "udp_sequence");
+    if (NULL == json_item) {
+        UDPSequence = true;
+    } else if (!cJSON_IsBool(json_item)) {
+        ESP_LOGE(LOG_TAG, "udp_sequence error");
+        cJSON_Delete(json_root); 
+        return false;
+    } else {
+        UDPSequence = cJSON_IsTrue(json_item);
+    }
+    json_item = cJSON_GetObjectItem(json_root, "tls");
+    if (NULL == json_item) {
+        TLS = false;
+    } else if (!cJSON_IsBool(json_item)) {
+        ESP_LOGE(LOG_TAG, "tls error");
+        cJSON_Delete(json_root); 
+        return false;
+    } else {
+        TLS = cJSON_IsTrue(json_item);
+    }
+    json_item = cJSON_GetObjectItem(json_root, "ca_cert");
+    if (NULL == json_item) {
+        CACert = "";
+    } else if (cJSON_String != json_item->type) {
+        ESP_LOGE(LOG_TAG, "ca_cert error");
+        cJSON_Delete(json_root); 
+        return false;
+    } else {
+        CACert = json_item->valuestring;
+    }
     cJSON_Delete(json_root); 
     return true;
 }
@@ -123,6 +185,80 @@ bool Config::Load(const std::string &config_data)
     }
 }
 
+config::BaseConfig *Config::Clone() const
+{
+    return new Config(*this);
+}
+
+void Config::Encode(config::BinaryEncoder &encoder) const
+{
+    encoder.WriteString(FIELD_HOST, Host);
+    encoder.WriteUInt(FIELD_PORT, Port);
+    encoder.WriteString(FIELD_TOKEN, Token);
+    encoder.WriteString(FIELD_ORG, Org);
+    encoder.WriteString(FIELD_BUCKET, Bucket);
+    encoder.WriteUInt(FIELD_TIMEOUT, Timeout);
+    encoder.WriteUInt(FIELD_UDP_PORT, UDPPort);
+    encoder.WriteUInt(FIELD_UDP_SEQUENCE, UDPSequence ? 1 : 0);
+    encoder.WriteUInt(FIELD_TLS, TLS ? 1 : 0);
+    encoder.WriteString(FIELD_CA_CERT, CACert);
+}
+
+bool Config::Decode(config::BinaryDecoder &decoder, const uint8_t schema_version)
+{
+    uint32_t value;
+    bool result;
+    // 与JSON一致，未保存的bucket使用默认值
+    Bucket = default_bucket;
+    while (decoder.Next()) {
+        switch (decoder.GetField()) {
+            case FIELD_HOST:
+                result = decoder.GetString(Host);
+                break;
+            case FIELD_PORT:
+                result = decoder.GetUInt(value);
+                Port = (uint16_t)value;
+                break;
+            case FIELD_TOKEN:
+                result = decoder.GetString(Token);
+                break;
+            case FIELD_ORG:
+                result = decoder.GetString(Org);
+                break;
+            case FIELD_BUCKET:
+                result = decoder.GetString(Bucket);
+                break;
+            case FIELD_TIMEOUT:
+                result = decoder.GetUInt(value);
+                Timeout = (uint8_t)value;
+                break;
+            case FIELD_UDP_PORT:
+                result = decoder.GetUInt(value);
+                UDPPort = (uint16_t)value;
+                break;
+            case FIELD_UDP_SEQUENCE:
+                result = decoder.GetUInt(value);
+                UDPSequence = (0 != value);
+                break;
+            case FIELD_TLS:
+                result = decoder.GetUInt(value);
+                TLS = (0 != value);
+                break;
+            case FIELD_CA_CERT:
+                result = decoder.GetString(CACert);
+                break;
+            default:
+                result = true;
+                break;
+        }
+        if (false == result) {
+            ESP_LOGE(LOG_TAG, "field %u error", decoder.GetField());
+            return false;
+        }
+    }
+    return true;
+}
+
 }
 
 }
@@ -17,15 +17,26 @@ class Config: public config::BaseConfig
         // 日志标签
         static const char *const LOG_TAG;
         void Reset();
-        std::string Dump();
+        std::string Dump() const;
         bool Load(const char *const config_data);
         bool Load(const std::string &config_data);
+        void Encode(config::BinaryEncoder &encoder) const;
+        config::BaseConfig *Clone() const;
+        bool Decode(config::BinaryDecoder &decoder, const uint8_t schema_version);
         std::string Host;
         uint16_t Port;
         std::string Token;
         std::string Org;
         std::string Bucket;
         uint8_t Timeout;
+        // 非0时改为以UDP发送到Host的该端口
+        uint16_t UDPPort;
+        // UDP发送时是否增加seq字段
+        bool UDPSequence;
+        // 是否使用HTTPS
+        bool TLS;
+        // PEM格式的CA证书，为空时不校验服务器证书
+        std::string CACert;
     private:
         static const uint16_t default_port;
         static const std::string default_org;
@@ -0,0 +1,323 @@
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "resolver.hpp"
+
+#include "influxdb_tls.hpp"
+
+namespace cubestone_wang 
+{
+
+namespace influxdb
+{
+
+const char *const InfluxdbTLS::LOG_TAG = "INFLUXDB_TLS";
+
+sync::Mutex InfluxdbTLS::handshake_mutex(LOG_TAG);
+
+InfluxdbTLS *InfluxdbTLS::connecting = nullptr;
+
+InfluxdbTLS::InfluxdbTLS(const std::string &host,
+                         const uint16_t &port,
+                         const std::string &ca_cert,
+                         const uint8_t &timeout)
+{
+    this->host = host;
+    this->port = port;
+    this->timeout = timeout;
+    this->tls = nullptr;
+    this->session = nullptr;
+    this->certificate_received = false;
+    portMUX_INITIALIZE(&this->spinlock);
+    memset((void *)&this->statistics, 0, sizeof(this->statistics));
+    mbedtls_x509_crt_init(&this->ca);
+    this->ca_pinned = ("" != ca_cert);
+    this->ca_valid = false;
+    if (this->ca_pinned) {
+        // PEM格式的长度需包含结尾的'\0'
+        int ret = mbedtls_x509_crt_parse(&this->ca, (const unsigned char *)ca_cert.c_str(), ca_cert.length() + 1);
+        if (0 != ret) {
+            ESP_LOGE(InfluxdbTLS::LOG_TAG, "parse ca cert failed: -0x%x", -ret);
+        } else {
+            this->ca_valid = true;
+        }
+    }
+}
+
+InfluxdbTLS::~InfluxdbTLS()
+{
+    this->Close();
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+    if (nullptr != this->session) {
+        esp_tls_free_client_session(this->session);
+        this->session = nullptr;
+    }
+#endif
+    mbedtls_x509_crt_free(&this->ca);
+}
+
+esp_err_t InfluxdbTLS::attach(void *conf)
+{
+    auto ssl_conf = (mbedtls_ssl_config *)conf;
+    auto self = InfluxdbTLS::connecting;
+    mbedtls_ssl_conf_verify(ssl_conf, InfluxdbTLS::verify, self);
+    if (self->ca_valid) {
+        mbedtls_ssl_conf_ca_chain(ssl_conf, &self->ca, NULL);
+        mbedtls_ssl_conf_authmode(ssl_conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+    } else {
+        // 仍然解析证书以便调用verify，但不要求校验通过
+        mbedtls_ssl_conf_authmode(ssl_conf, MBEDTLS_SSL_VERIFY_OPTIONAL);
+    }
+    return ESP_OK;
+}
+
+int InfluxdbTLS::verify(void *ctx, mbedtls_x509_crt *crt, int depth, uint32_t *flags)
+{
+    auto self = (InfluxdbTLS *)ctx;
+    // 证书链中的每个证书各调用一次，depth为0的是服务器证书
+    if (0 == depth) {
+        self->certificate_received = true;
+    }
+    if (!self->ca_valid) {
+        *flags = 0;
+    }
+    return 0;
+}
+
+bool InfluxdbTLS::connect()
+{
+    std::string address;
+    esp_tls_cfg_t cfg;
+    int ret;
+    int64_t start_timestamp;
+    uint32_t elapsed;
+    bool resumed;
+    if (this->ca_pinned && !this->ca_valid) {
+        ESP_LOGE(InfluxdbTLS::LOG_TAG, "ca cert is invalid");
+        return false;
+    }
+    // 使用缓存的地址，证书校验及SNI仍使用域名
+    if (!resolver::Resolver::Resolve(this->host, address)) {
+        ESP_LOGE(InfluxdbTLS::LOG_TAG, "resolve %s failed", this->host.c_str());
+        return false;
+    }
+    memset((void *)&cfg, 0, sizeof(cfg));
+    cfg.timeout_ms = this->timeout * 1000;
+    cfg.common_name = this->host.c_str();
+    cfg.crt_bundle_attach = InfluxdbTLS::attach;
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+    cfg.client_session = this->session;
+#endif
+    this->tls = esp_tls_init();
+    if (nullptr == this->tls) {
+        ESP_LOGE(InfluxdbTLS::LOG_TAG, "init failed");
+        return false;
+    }
+    // 设置临界区
+    InfluxdbTLS::handshake_mutex.Lock();
+    InfluxdbTLS::connecting = this;
+    this->certificate_received = false;
+    start_timestamp = esp_timer_get_time();
+    ret = esp_tls_conn_new_sync(address.c_str(), address.length(), this->port, &cfg, this->tls);
+    elapsed = (uint32_t)(esp_timer_get_time() - start_timestamp);
+    InfluxdbTLS::connecting = nullptr;
+    // 退出临界区
+    InfluxdbTLS::handshake_mutex.Unlock();
+    if (1 != ret) {
+        ESP_LOGE(InfluxdbTLS::LOG_TAG, "connect to %s:%u failed", this->host.c_str(), this->port);
+        esp_tls_conn_destroy(this->tls);
+        this->tls = nullptr;
+        // 地址可能已变化
+        resolver::Resolver::Refresh(this->host);
+        portENTER_CRITICAL(&this->spinlock);
+        this->statistics.FailedHandshakes++;
+        portEXIT_CRITICAL(&this->spinlock);
+        return false;
+    }
+    // 恢复的会话不发送证书
+    resumed = !this->certificate_received;
+    portENTER_CRITICAL(&this->spinlock);
+    if (resumed) {
+        this->statistics.ResumedHandshakes++;
+        this->statistics.ResumedHandshakeTime += elapsed;
+    } else {
+        this->statistics.FullHandshakes++;
+        this->statistics.FullHandshakeTime += elapsed;
+    }
+    portEXIT_CRITICAL(&this->spinlock);
+    ESP_LOGI(InfluxdbTLS::LOG_TAG, "%s handshake, %lu ms", resumed ? "resumed" : "full", elapsed / 1000);
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+    // 保存新的票据，用于下次重新连接
+    auto session = esp_tls_get_client_session(this->tls);
+    if (nullptr != session) {
+        if (nullptr != this->session) {
+            esp_tls_free_client_session(this->session);
+        }
+        this->session = session;
+    }
+#endif
+    return true;
+}
+
+void InfluxdbTLS::Close()
+{
+    if (nullptr != this->tls) {
+        esp_tls_conn_destroy(this->tls);
+        this->tls = nullptr;
+    }
+}
+
+bool InfluxdbTLS::write(const std::string &data)
+{
+    size_t written = 0;
+    while (written < data.length()) {
+        ssize_t ret = esp_tls_conn_write(this->tls, data.data() + written, data.length() - written);
+        if (ESP_TLS_ERR_SSL_WANT_READ == ret || ESP_TLS_ERR_SSL_WANT_WRITE == ret) {
+            continue;
+        }
+        if (ret <= 0) {
+            ESP_LOGD(InfluxdbTLS::LOG_TAG, "write failed: %d", (int)ret);
+            return false;
+        }
+        written += ret;
+    }
+    return true;
+}
+
+bool InfluxdbTLS::read_response(int &status, bool &keep_alive)
+{
+    char buffer[MAX_HEADER_SIZE + 1];
+    size_t length = 0;
+    char *header_end = nullptr;
+    long content_length = -1;
+    // 读取到头部结束
+    while (nullptr == header_end) {
+        if (length >= MAX_HEADER_SIZE) {
+            ESP_LOGE(InfluxdbTLS::LOG_TAG, "header too long");
+            return false;
+        }
+        ssize_t ret = esp_tls_conn_read(this->tls, buffer + length, MAX_HEADER_SIZE - length);
+        if (ESP_TLS_ERR_SSL_WANT_READ == ret || ESP_TLS_ERR_SSL_WANT_WRITE == ret) {
+            continue;
+        }
+        if (ret <= 0) {
+            ESP_LOGD(InfluxdbTLS::LOG_TAG, "read failed: %d", (int)ret);
+            return false;
+        }
+        length += ret;
+        buffer[length] = '\0';
+        header_end = strstr(buffer, "\r\n\r\n");
+    }
+    if (1 != sscanf(buffer, "HTTP/1.%*d %d", &status)) {
+        ESP_LOGE(InfluxdbTLS::LOG_TAG, "invalid status line");
+        return false;
+    }
+    keep_alive = true;
+    *header_end = '\0';
+    for (char *line = strstr(buffer, "\r\n"); nullptr != line; line = strstr(line, "\r\n")) {
+        line += 2;
+        if (0 == strncasecmp(line, "Content-Length:", 15)) {
+            content_length = strtol(line + 15, nullptr, 10);
+        } else if (0 == strncasecmp(line, "Connection:", 11)) {
+            const char *value = line + 11 + strspn(line + 11, " ");
+            if (0 == strncasecmp(value, "close", 5)) {
+                keep_alive = false;
+            }
+        }
+    }
+    // 没有长度（例如分块编码）时无法确定应答结束的位置，读取后关闭连接
+    if (content_length < 0) {
+        keep_alive = keep_alive && (204 == status || 304 == status);
+        return true;
+    }
+    // 丢弃应答内容，以便继续复用连接
+    long remaining = content_length - (long)(buffer + length - (header_end + 4));
+    while (remaining > 0) {
+        ssize_t ret = esp_tls_conn_read(this->tls, buffer, remaining < (long)MAX_HEADER_SIZE ? remaining : MAX_HEADER_SIZE);
+        if (ESP_TLS_ERR_SSL_WANT_READ == ret || ESP_TLS_ERR_SSL_WANT_WRITE == ret) {
+            continue;
+        }
+        if (ret <= 0) {
+            keep_alive = false;
+            break;
+        }
+        remaining -= ret;
+    }
+    return true;
+}
+
+bool InfluxdbTLS::Post(const std::string &path,
+                       const std::string &authorization,
+                       const std::string &body,
+                       int &status)
+{
+    std::string request;
+    request.reserve(256 + body.length());
+    request += "POST " + path + " HTTP/1.1\r\n";
+    request += "Host: " + this->host + ":" + std::to_string(this->port) + "\r\n";
+    request += "Authorization: " + authorization + "\r\n";
+    request += "Content-Type: text/plain; charset=utf-8\r\n";
+    request += "Content-Length: " + std::to_string(body.length()) + "\r\n\r\n";
+    request += body;
+    for (int attempt = 0; attempt < 2; attempt++) {
+        bool reused = (nullptr != this->tls);
+        bool keep_alive = false;
+        if (!reused && !this->connect()) {
+            return false;
+        }
+        if (this->write(request) && this->read_response(status, keep_alive)) {
+            portENTER_CRITICAL(&this->spinlock);
+            this->statistics.Requests++;
+            portEXIT_CRITICAL(&this->spinlock);
+            if (!keep_alive) {
+                this->Close();
+            }
+            return true;
+        }
+        this->Close();
+        // 新建的连接失败时不再重试
+        if (!reused) {
+            return false;
+        }
+        portENTER_CRITICAL(&this->spinlock);
+        this->statistics.Retries++;
+        portEXIT_CRITICAL(&this->spinlock);
+    }
+    return false;
+}
+
+InfluxdbTLS::Statistics InfluxdbTLS::GetStatistics() const
+{
+    Statistics result;
+    portENTER_CRITICAL(&this->spinlock);
+    result = this->statistics;
+    portEXIT_CRITICAL(&this->spinlock);
+    return result;
+}
+
+void InfluxdbTLS::LogStatistics() const
+{
+    auto statistics = this->GetStatistics();
+    ESP_LOGI(InfluxdbTLS::LOG_TAG, "requests %lu, retries %lu, handshakes full %lu / resumed %lu / failed %lu",
+             statistics.Requests,
+             statistics.Retries,
+             statistics.FullHandshakes,
+             statistics.ResumedHandshakes,
+             statistics.FailedHandshakes);
+    if (statistics.FullHandshakes > 0) {
+        ESP_LOGI(InfluxdbTLS::LOG_TAG, "full handshake avg %llu ms",
+                 statistics.FullHandshakeTime / statistics.FullHandshakes / 1000);
+    }
+    if (statistics.ResumedHandshakes > 0) {
+        ESP_LOGI(InfluxdbTLS::LOG_TAG, "resumed handshake avg %llu ms",
+                 statistics.ResumedHandshakeTime / statistics.ResumedHandshakes / 1000);
+    }
+}
+
+}
+
+}
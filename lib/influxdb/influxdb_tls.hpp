@@ -0,0 +1,107 @@
+#ifndef _influxdb_tls_hpp_
+#define _influxdb_tls_hpp_
+
+#include <string>
+
+#include "freertos/FreeRTOS.h"
+#include "esp_tls.h"
+#include "mbedtls/ssl.h"
+#include "mbedtls/x509_crt.h"
+
+#include "mutex.hpp"
+
+namespace cubestone_wang 
+{
+
+namespace influxdb
+{
+
+/*
+  HTTPS连接类
+  保持一个TLS连接，多次请求复用同一连接（HTTP/1.1 keep-alive），不在每次写入时握手；
+  连接断开后重新连接时使用保存的会话票据恢复会话，只有票据失效时才完整握手；
+  指定CA证书时只信任该证书（固定CA），否则与sdkconfig中CONFIG_ESP_TLS_SKIP_SERVER_CERT_VERIFY一致，不校验证书；
+  完整握手时服务器发送证书，据此区分完整握手与恢复的会话并分别统计次数及耗时
+  请求只由上传任务调用，不加锁
+*/
+class InfluxdbTLS
+{
+    public:
+        // 日志标签
+        static const char *const LOG_TAG;
+        // 应答头部的最大长度（字节）
+        static const size_t MAX_HEADER_SIZE = 1024;
+        // 统计结果
+        struct Statistics {
+            uint32_t FullHandshakes;
+            uint32_t ResumedHandshakes;
+            uint32_t FailedHandshakes;
+            uint32_t Requests;
+            uint32_t Retries;               // 复用的连接已断开，重新连接后重试的次数
+            uint64_t FullHandshakeTime;     // 微秒
+            uint64_t ResumedHandshakeTime;  // 微秒
+        };
+        /**
+         * @brief 构造，不立即连接
+         *
+         * @param host 域名，用于SNI及证书校验
+         * @param port 端口
+         * @param ca_cert PEM格式的CA证书，为空时不校验证书
+         * @param timeout 超时时间（秒）
+         */
+        InfluxdbTLS(const std::string &host,
+                    const uint16_t &port,
+                    const std::string &ca_cert,
+                    const uint8_t &timeout=5);
+        ~InfluxdbTLS();
+        InfluxdbTLS(const InfluxdbTLS &) = delete;
+        InfluxdbTLS &operator=(const InfluxdbTLS &) = delete;
+        /**
+         * @brief 发送POST请求并读取应答
+         * 复用的连接已被服务器关闭时重新连接后重试一次，InfluxDB按序列及时间戳覆盖写入，重复写入无副作用
+         *
+         * @param path 路径及查询参数
+         * @param authorization Authorization头部
+         * @param body 请求内容
+         * @param status 应答的状态码
+         */
+        bool Post(const std::string &path,
+                  const std::string &authorization,
+                  const std::string &body,
+                  int &status);
+        /**
+         * @brief 关闭连接，保留会话票据
+         */
+        void Close();
+        Statistics GetStatistics() const;
+        void LogStatistics() const;
+    private:
+        std::string host;
+        uint16_t port;
+        uint8_t timeout;
+        // 是否指定了CA证书，指定但解析失败时不连接
+        bool ca_pinned;
+        bool ca_valid;
+        mbedtls_x509_crt ca;
+        esp_tls_t *tls;
+        esp_tls_client_session_t *session;
+        // 当前握手中是否收到了服务器证书
+        bool certificate_received;
+        // 保护统计数据，可在其他任务中读取
+        mutable portMUX_TYPE spinlock;
+        Statistics statistics;
+        // esp-tls的配置回调没有参数，握手期间通过connecting传递当前连接，需串行执行
+        static sync::Mutex handshake_mutex;
+        static InfluxdbTLS *connecting;
+        static esp_err_t attach(void *conf);
+        static int verify(void *ctx, mbedtls_x509_crt *crt, int depth, uint32_t *flags);
+        bool connect();
+        bool write(const std::string &data);
+        bool read_response(int &status, bool &keep_alive);
+};
+
+}
+
+}
+
+#endif // _influxdb_tls_hpp_
@@ -0,0 +1,151 @@
+#include <errno.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "lwip/sockets.h"
+
+#include "resolver.hpp"
+
+#include "influxdb_udp.hpp"
+
+namespace cubestone_wang 
+{
+
+namespace influxdb
+{
+
+const char *const InfluxdbUDP::LOG_TAG = "INFLUXDB_UDP";
+
+InfluxdbUDP::InfluxdbUDP(const std::string &host,
+                         const uint16_t &port,
+                         const bool &sequence,
+                         const size_t &payload_size)
+{
+    this->host = host;
+    this->port = port;
+    this->sequence = sequence;
+    this->payload_size = payload_size;
+    this->next_sequence = 0;
+    this->payload.reserve(payload_size);
+    this->payload_lines = 0;
+    portMUX_INITIALIZE(&this->spinlock);
+    memset((void *)&this->statistics, 0, sizeof(this->statistics));
+    this->sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (this->sock < 0) {
+        ESP_LOGE(InfluxdbUDP::LOG_TAG, "create socket failed, errno %d", errno);
+    }
+}
+
+InfluxdbUDP::~InfluxdbUDP()
+{
+    if (this->sock >= 0) {
+        close(this->sock);
+    }
+}
+
+bool InfluxdbUDP::WritePoint(const Point &point)
+{
+    bool result = true;
+    std::string line;
+    if (this->sequence) {
+        Point sequenced_point(point);
+        sequenced_point.AddField("seq", (long long)this->next_sequence);
+        line = sequenced_point.ToLineProtocol();
+    } else {
+        line = point.ToLineProtocol();
+    }
+    this->next_sequence++;
+    if (line.length() > this->payload_size) {
+        ESP_LOGE(InfluxdbUDP::LOG_TAG, "line too long: %u", line.length());
+        portENTER_CRITICAL(&this->spinlock);
+        this->statistics.Errors++;
+        portEXIT_CRITICAL(&this->spinlock);
+        return false;
+    }
+    // 行之间以换行分隔
+    size_t length = this->payload.length() + (this->payload_lines > 0 ? 1 : 0) + line.length();
+    if (length > this->payload_size) {
+        result = this->send();
+    }
+    if (this->payload_lines > 0) {
+        this->payload += '\n';
+    }
+    this->payload += line;
+    this->payload_lines++;
+    return result;
+}
+
+bool InfluxdbUDP::Flush()
+{
+    if (0 == this->payload_lines) {
+        return true;
+    }
+    return this->send();
+}
+
+bool InfluxdbUDP::send()
+{
+    bool result = false;
+    std::string address;
+    struct sockaddr_in destination;
+    if (this->sock < 0) {
+        goto DONE;
+    }
+    // 使用缓存的地址，不在每次发送时解析
+    if (!resolver::Resolver::Resolve(this->host, address)) {
+        ESP_LOGE(InfluxdbUDP::LOG_TAG, "resolve %s failed", this->host.c_str());
+        goto DONE;
+    }
+    memset((void *)&destination, 0, sizeof(destination));
+    destination.sin_family = AF_INET;
+    destination.sin_port = htons(this->port);
+    inet_pton(AF_INET, address.c_str(), &destination.sin_addr);
+    // 不等待发送缓冲区，满时丢弃
+    if (sendto(this->sock,
+               this->payload.data(),
+               this->payload.length(),
+               MSG_DONTWAIT,
+               (struct sockaddr *)&destination,
+               sizeof(destination)) < 0) {
+        ESP_LOGE(InfluxdbUDP::LOG_TAG, "send failed, errno %d", errno);
+        goto DONE;
+    }
+    result = true;
+DONE:
+    portENTER_CRITICAL(&this->spinlock);
+    if (result) {
+        this->statistics.Datagrams++;
+        this->statistics.Lines += this->payload_lines;
+        this->statistics.Bytes += this->payload.length();
+    } else {
+        this->statistics.Errors++;
+    }
+    portEXIT_CRITICAL(&this->spinlock);
+    // 失败时也丢弃，不重发
+    this->payload.clear();
+    this->payload_lines = 0;
+    return result;
+}
+
+InfluxdbUDP::Statistics InfluxdbUDP::GetStatistics() const
+{
+    Statistics result;
+    portENTER_CRITICAL(&this->spinlock);
+    result = this->statistics;
+    portEXIT_CRITICAL(&this->spinlock);
+    return result;
+}
+
+void InfluxdbUDP::LogStatistics() const
+{
+    auto statistics = this->GetStatistics();
+    ESP_LOGI(InfluxdbUDP::LOG_TAG, "datagrams %lu, lines %lu, bytes %llu, errors %lu",
+             statistics.Datagrams,
+             statistics.Lines,
+             statistics.Bytes,
+             statistics.Errors);
+}
+
+}
+
+}
@@ -0,0 +1,82 @@
+#ifndef _influxdb_udp_hpp_
+#define _influxdb_udp_hpp_
+
+#include <string>
+
+#include "freertos/FreeRTOS.h"
+
+#include "influxdb_point.hpp"
+
+namespace cubestone_wang 
+{
+
+namespace influxdb
+{
+
+/*
+  UDP上传类
+  将行协议数据按行合并到不超过一个MTU的数据报中发送，不建立连接也不等待应答，适合局域网内的Telegraf socket_listener；
+  开启序号时每行增加递增的seq字段，接收端可据此统计丢失；写入只由上传任务调用，不加锁
+*/
+class InfluxdbUDP
+{
+    public:
+        // 日志标签
+        static const char *const LOG_TAG;
+        // 以太网MTU减去IP及UDP头部
+        static const size_t DEFAULT_PAYLOAD_SIZE = 1472;
+        // 统计结果
+        struct Statistics {
+            uint32_t Datagrams;
+            uint32_t Lines;
+            uint64_t Bytes;
+            uint32_t Errors;        // 发送失败的数据报数
+        };
+        /**
+         * @brief 构造
+         *
+         * @param host 域名或IPv4地址
+         * @param port 端口
+         * @param sequence 是否增加seq字段
+         * @param payload_size 数据报的最大长度（字节）
+         */
+        InfluxdbUDP(const std::string &host,
+                    const uint16_t &port,
+                    const bool &sequence=true,
+                    const size_t &payload_size=DEFAULT_PAYLOAD_SIZE);
+        ~InfluxdbUDP();
+        InfluxdbUDP(const InfluxdbUDP &) = delete;
+        InfluxdbUDP &operator=(const InfluxdbUDP &) = delete;
+        /**
+         * @brief 加入当前数据报，放不下时先发送当前数据报
+         *
+         * @param point 数据
+         */
+        bool WritePoint(const Point &point);
+        /**
+         * @brief 发送当前数据报
+         */
+        bool Flush();
+        Statistics GetStatistics() const;
+        void LogStatistics() const;
+    private:
+        std::string host;
+        uint16_t port;
+        bool sequence;
+        size_t payload_size;
+        int sock;
+        uint64_t next_sequence;
+        // 当前数据报，容量为payload_size
+        std::string payload;
+        uint32_t payload_lines;
+        // 保护统计数据，可在其他任务中读取
+        mutable portMUX_TYPE spinlock;
+        Statistics statistics;
+        bool send();
+};
+
+}
+
+}
+
+#endif // _influxdb_udp_hpp_
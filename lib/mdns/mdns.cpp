@@ -40,25 +40,24 @@ bool MDNS::Start(const std::string &hostname,
     if (0 < instance_name.length()) {
         ESP_ERROR_CHECK(mdns_instance_name_set(instance_name.c_str()));
     }
-    Service service;
-    for (uint32_t index=0; index<services.size(); index++) {
-        service = services[index];
-        ESP_ERROR_CHECK(mdns_service_add(NULL,
-                                         service.Type.c_str(),
-                                         service.Proto.c_str(),
-                                         service.Port,
-                                         NULL, 
-                                         0));
-        for (uint32_t sub_index=0; sub_index<service.Txt.size(); sub_index++) {
-            ESP_ERROR_CHECK(mdns_service_txt_item_set(service.Type.c_str(),
-                                                      service.Proto.c_str(),
-                                                      service.Txt[sub_index].Key.c_str(),
-                                                      service.Txt[sub_index].Key.c_str()));
+    for (auto &service : services) {
+        // 以实例名区分同类型的服务（如指标接口与其他_http服务），实例名相同时添加失败，跳过该服务
+        std::vector<mdns_txt_item_t> txt_items;
+        for (auto &txt : service.Txt) {
+            txt_items.push_back({txt.Key.c_str(), txt.Value.c_str()});
         }
-        if (0 < service.InstanceName.length()) {
-            ESP_ERROR_CHECK(mdns_service_instance_name_set(service.Type.c_str(),
-                                                           service.Proto.c_str(),
-                                                           service.InstanceName.c_str()));
+        auto err = mdns_service_add(0 < service.InstanceName.length() ? service.InstanceName.c_str() : NULL,
+                                    service.Type.c_str(),
+                                    service.Proto.c_str(),
+                                    service.Port,
+                                    txt_items.data(),
+                                    txt_items.size());
+        if (ESP_OK != err) {
+            ESP_LOGE(LOG_TAG, "add %s.%s:%u failed, %s",
+                     service.Type.c_str(),
+                     service.Proto.c_str(),
+                     service.Port,
+                     esp_err_to_name(err));
         }
     }
     start_flag = true;
@@ -14,27 +14,59 @@ namespace cubestone_wang
 namespace mdns
 {
 
+// 二进制格式的字段号
+enum Field : uint8_t {
+    FIELD_HOSTNAME = 1,
+    FIELD_INSTANCE_NAME = 2,
+    FIELD_SERVICES = 3,
+    FIELD_METRICS_PORT = 4,
+    // 服务列表中的每一项
+    FIELD_SERVICE = 1,
+    // 服务的各字段
+    FIELD_SERVICE_INSTANCE_NAME = 1,
+    FIELD_SERVICE_TYPE = 2,
+    FIELD_SERVICE_PROTO = 3,
+    FIELD_SERVICE_PORT = 4,
+    FIELD_SERVICE_TXT = 5,
+    // TXT记录的各字段
+    FIELD_TXT_KEY = 1,
+    FIELD_TXT_VALUE = 2,
+};
+
 const char *const Config::LOG_TAG = "MDNS_CONFIG";
 
 const char *const Config::default_instance_name = "";
 
+const uint16_t Config::default_metrics_port = 80;
+
 Config::Config()
 {
     uint8_t mac_address[6];
+    char buffer[13] = {0};
     ESP_ERROR_CHECK(esp_read_mac(mac_address, ESP_MAC_WIFI_STA));
-    default_hostname = new char[13];
-    memset(default_hostname, 0, sizeof(char) * 13); 
-    sprintf(default_hostname, 
+    sprintf(buffer, 
             "esp32_%02x%02x%02x", 
             mac_address[3],
             mac_address[4],
             mac_address[5]);
-    MDNS::Service service;
+    default_hostname = buffer;
 }
 
-Config::~Config()
+// 指标接口，见MetricsServer；以TXT记录path=/metrics识别，已存在时只同步端口，否则加入，其他_http服务不受影响
+void Config::add_metrics_service()
 {
-    delete[] default_hostname;
+    for (auto &service : services) {
+        if ("_http" != service.Type || "_tcp" != service.Proto) {
+            continue;
+        }
+        for (auto &txt : service.Txt) {
+            if ("path" == txt.Key && "/metrics" == txt.Value) {
+                service.Port = MetricsPort;
+                return;
+            }
+        }
+    }
+    services.push_back({"", "_http", "_tcp", MetricsPort, {{"path", "/metrics"}}});
 }
 
 void Config::Reset()
@@ -43,14 +75,17 @@ void Config::Reset()
     InstanceName = default_instance_name;
     services.clear();
     services = default_services;
+    MetricsPort = default_metrics_port;
+    add_metrics_service();
 }
 
-std::string Config::Dump()
+std::string Config::Dump() const
 {
     cJSON *json_root = cJSON_CreateObject();
     cJSON *json_item, *json_sub_item, *json_child_item;
     cJSON_AddStringToObject(json_root, "hostname", Hostname.c_str());
     cJSON_AddStringToObject(json_root, "instance_name", InstanceName.c_str());
+    cJSON_AddNumberToObject(json_root, "metrics_port", MetricsPort);
     if (0 < services.size()) {
         json_item = cJSON_AddArrayToObject(json_root, "services");
         for (auto index=0; index<services.size(); index++) {
@@ -110,6 +145,16 @@ bool Config::Load(const char *const config_data)
     } else {
         InstanceName = json_item->valuestring;
     }
+    json_item = cJSON_GetObjectItem(json_root, "metrics_port");
+    if (NULL == json_item) {
+        MetricsPort = default_metrics_port;
+    } else if (cJSON_Number != json_item->type || json_item->valueint <= 0 || json_item->valueint > UINT16_MAX) {
+        ESP_LOGE(LOG_TAG, "metrics_port error");
+        cJSON_Delete(json_root); 
+        return false;
+    } else {
+        MetricsPort = (uint16_t)json_item->valueint;
+    }
     json_item = cJSON_GetObjectItem(json_root, "services");
     if (NULL == json_item) {
         // 不做任何操作
@@ -216,6 +261,8 @@ bool Config::Load(const char *const config_data)
         }
     }
     cJSON_Delete(json_root); 
+    // 旧版本的JSON中没有指标接口
+    add_metrics_service();
     return true;
 }
 
@@ -228,6 +275,134 @@ bool Config::Load(const std::string &config_data)
     }
 }
 
+config::BaseConfig *Config::Clone() const
+{
+    return new Config(*this);
+}
+
+uint8_t Config::GetSchemaVersion() const
+{
+    return 3;
+}
+
+void Config::Encode(config::BinaryEncoder &encoder) const
+{
+    encoder.WriteString(FIELD_HOSTNAME, Hostname);
+    encoder.WriteString(FIELD_INSTANCE_NAME, InstanceName);
+    encoder.WriteUInt(FIELD_METRICS_PORT, MetricsPort);
+    config::BinaryEncoder services_encoder;
+    for (auto &service : services) {
+        config::BinaryEncoder service_encoder;
+        service_encoder.WriteString(FIELD_SERVICE_INSTANCE_NAME, service.InstanceName);
+        service_encoder.WriteString(FIELD_SERVICE_TYPE, service.Type);
+        service_encoder.WriteString(FIELD_SERVICE_PROTO, service.Proto);
+        service_encoder.WriteUInt(FIELD_SERVICE_PORT, service.Port);
+        for (auto &txt : service.Txt) {
+            config::BinaryEncoder txt_encoder;
+            txt_encoder.WriteString(FIELD_TXT_KEY, txt.Key);
+            txt_encoder.WriteString(FIELD_TXT_VALUE, txt.Value);
+            service_encoder.WriteMessage(FIELD_SERVICE_TXT, txt_encoder);
+        }
+        services_encoder.WriteMessage(FIELD_SERVICE, service_encoder);
+    }
+    encoder.WriteMessage(FIELD_SERVICES, services_encoder);
+}
+
+static bool decode_txt(config::BinaryDecoder &decoder, MDNS::TxtItem &txt_item)
+{
+    bool result = true;
+    while (result && decoder.Next()) {
+        switch (decoder.GetField()) {
+            case FIELD_TXT_KEY:
+                result = decoder.GetString(txt_item.Key);
+                break;
+            case FIELD_TXT_VALUE:
+                result = decoder.GetString(txt_item.Value);
+                break;
+            default:
+                break;
+        }
+    }
+    return result && !decoder.IsError();
+}
+
+static bool decode_service(config::BinaryDecoder &decoder, MDNS::Service &service)
+{
+    config::BinaryDecoder txt_decoder(nullptr, 0);
+    uint32_t value;
+    bool result = true;
+    while (result && decoder.Next()) {
+        switch (decoder.GetField()) {
+            case FIELD_SERVICE_INSTANCE_NAME:
+                result = decoder.GetString(service.InstanceName);
+                break;
+            case FIELD_SERVICE_TYPE:
+                result = decoder.GetString(service.Type);
+                break;
+            case FIELD_SERVICE_PROTO:
+                result = decoder.GetString(service.Proto);
+                break;
+            case FIELD_SERVICE_PORT:
+                result = decoder.GetUInt(value);
+                service.Port = (uint16_t)value;
+                break;
+            case FIELD_SERVICE_TXT:
+                {
+                    MDNS::TxtItem txt_item;
+                    result = decoder.GetMessage(txt_decoder) && decode_txt(txt_decoder, txt_item);
+                    service.Txt.push_back(txt_item);
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    return result && !decoder.IsError();
+}
+
+bool Config::Decode(config::BinaryDecoder &decoder, const uint8_t schema_version)
+{
+    config::BinaryDecoder services_decoder(nullptr, 0), service_decoder(nullptr, 0);
+    uint32_t value;
+    bool result;
+    while (decoder.Next()) {
+        switch (decoder.GetField()) {
+            case FIELD_HOSTNAME:
+                result = decoder.GetString(Hostname);
+                break;
+            case FIELD_INSTANCE_NAME:
+                result = decoder.GetString(InstanceName);
+                break;
+            case FIELD_METRICS_PORT:
+                result = decoder.GetUInt(value) && 0 < value && value <= UINT16_MAX;
+                MetricsPort = (uint16_t)value;
+                break;
+            case FIELD_SERVICES:
+                result = decoder.GetMessage(services_decoder);
+                services.clear();
+                while (result && services_decoder.Next()) {
+                    MDNS::Service service;
+                    result = FIELD_SERVICE == services_decoder.GetField()
+                             && services_decoder.GetMessage(service_decoder)
+                             && decode_service(service_decoder, service);
+                    services.push_back(service);
+                }
+                result = result && !services_decoder.IsError();
+                break;
+            default:
+                result = true;
+                break;
+        }
+        if (false == result) {
+            ESP_LOGE(LOG_TAG, "field %u error", decoder.GetField());
+            return false;
+        }
+    }
+    // 旧版本的数据中没有指标接口或端口
+    add_metrics_service();
+    return true;
+}
+
 }
 
 }
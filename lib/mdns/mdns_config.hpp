@@ -19,18 +19,27 @@ class Config: public config::BaseConfig
         // 日志标签
         static const char *const LOG_TAG;
         Config();
-        virtual ~Config();
         void Reset();
-        std::string Dump();
+        std::string Dump() const;
         bool Load(const char *const config_data);
         bool Load(const std::string &config_data);
+        void Encode(config::BinaryEncoder &encoder) const;
+        config::BaseConfig *Clone() const;
+        // 2: 默认服务中加入指标接口
+        // 3: 加入指标接口端口
+        uint8_t GetSchemaVersion() const;
+        bool Decode(config::BinaryDecoder &decoder, const uint8_t schema_version);
         std::string Hostname;
         std::string InstanceName;
         std::vector<MDNS::Service> services;
+        // 指标接口端口，MetricsServer与_http服务共用
+        uint16_t MetricsPort;
     private:
-        char *default_hostname;
+        std::string default_hostname;
         static const char *const default_instance_name;
         std::vector<MDNS::Service> default_services;
+        static const uint16_t default_metrics_port;
+        void add_metrics_service();
 };
 
 }
@@ -0,0 +1,258 @@
+#include <stdarg.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "boot_sequence.hpp"
+#include "system.hpp"
+#include "task_placement.hpp"
+
+#include "metrics_server.hpp"
+
+namespace cubestone_wang
+{
+
+namespace metrics
+{
+
+using namespace system;
+
+const char *const MetricsServer::LOG_TAG = "METRICS_SERVER";
+
+sync::Mutex MetricsServer::mutex(LOG_TAG);
+
+httpd_handle_t MetricsServer::server = nullptr;
+
+MetricsServer::Gauge MetricsServer::gauges[MetricsServer::MAX_GAUGE_COUNT] = {};
+
+uint8_t MetricsServer::gauge_count = 0;
+
+portMUX_TYPE MetricsServer::spinlock = portMUX_INITIALIZER_UNLOCKED;
+
+MetricsServer::Value MetricsServer::pending_values[MetricsServer::MAX_GAUGE_COUNT] = {};
+
+MetricsServer::Value MetricsServer::published_values[MetricsServer::MAX_GAUGE_COUNT] = {};
+
+time_t MetricsServer::published_timestamp = 0;
+
+uint32_t MetricsServer::request_count = 0;
+
+char MetricsServer::buffer[MetricsServer::BUFFER_SIZE];
+
+// 向缓冲区追加内容，空间不足时返回false
+static bool append(char *buffer, const size_t size, size_t &length, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(buffer + length, size - length, format, args);
+    va_end(args);
+    if (written < 0 || (size_t)written >= size - length) {
+        return false;
+    }
+    length += written;
+    return true;
+}
+
+MetricsServer::Handle_t MetricsServer::Add(const char *const name, const char *const help)
+{
+    Handle_t handle = INVALID_HANDLE;
+    // 设置临界区
+    mutex.Lock();
+    if (nullptr != server) {
+        ESP_LOGE(LOG_TAG, "add %s after start", name);
+    } else if (gauge_count >= MAX_GAUGE_COUNT) {
+        ESP_LOGE(LOG_TAG, "too many gauges, max is %u", MAX_GAUGE_COUNT);
+    } else {
+        gauges[gauge_count] = {name, help};
+        gauge_count++;
+        handle = gauge_count;
+    }
+    // 退出临界区
+    mutex.Unlock();
+    return handle;
+}
+
+void MetricsServer::Set(const Handle_t handle, const double value)
+{
+    if (INVALID_HANDLE == handle || handle > MAX_GAUGE_COUNT) {
+        return;
+    }
+    portENTER_CRITICAL(&spinlock);
+    pending_values[handle - 1] = {value, true};
+    portEXIT_CRITICAL(&spinlock);
+}
+
+void MetricsServer::Publish(const time_t timestamp)
+{
+    portENTER_CRITICAL(&spinlock);
+    memcpy(published_values, pending_values, sizeof(published_values));
+    published_timestamp = timestamp;
+    portEXIT_CRITICAL(&spinlock);
+}
+
+size_t MetricsServer::copy_snapshot(Value *values, time_t &timestamp, uint32_t &count)
+{
+    // 启动后不再登记，数量不变
+    size_t gauge_number = gauge_count;
+    portENTER_CRITICAL(&spinlock);
+    memcpy(values, published_values, sizeof(Value) * gauge_number);
+    timestamp = published_timestamp;
+    count = ++request_count;
+    portEXIT_CRITICAL(&spinlock);
+    return gauge_number;
+}
+
+esp_err_t MetricsServer::metrics_handler(httpd_req_t *request)
+{
+    Value values[MAX_GAUGE_COUNT];
+    time_t timestamp;
+    uint32_t count;
+    size_t length = 0;
+    bool result = true;
+    size_t gauge_number = copy_snapshot(values, timestamp, count);
+    for (size_t index = 0; index < gauge_number && result; index++) {
+        if (false == values[index].Valid) {
+            continue;
+        }
+        result = append(buffer, BUFFER_SIZE, length,
+                        "# HELP %s %s\n# TYPE %s gauge\n%s %.2f\n",
+                        gauges[index].Name, gauges[index].Help,
+                        gauges[index].Name,
+                        gauges[index].Name, values[index].Value);
+    }
+    result = result && append(buffer, BUFFER_SIZE, length,
+                              "# HELP device_uptime_seconds Time since boot.\n"
+                              "# TYPE device_uptime_seconds gauge\n"
+                              "device_uptime_seconds %lld\n"
+                              "# HELP device_free_heap_bytes Current free heap size.\n"
+                              "# TYPE device_free_heap_bytes gauge\n"
+                              "device_free_heap_bytes %lu\n"
+                              "# HELP device_min_free_heap_bytes Minimum free heap size since boot.\n"
+                              "# TYPE device_min_free_heap_bytes gauge\n"
+                              "device_min_free_heap_bytes %lu\n"
+                              "# HELP device_sample_timestamp_seconds Time of the latest sample.\n"
+                              "# TYPE device_sample_timestamp_seconds gauge\n"
+                              "device_sample_timestamp_seconds %lld\n"
+                              "# HELP metrics_requests_total Requests served by the metrics server.\n"
+                              "# TYPE metrics_requests_total counter\n"
+                              "metrics_requests_total %lu\n",
+                              esp_timer_get_time() / 1000000,
+                              System::GetCurrentFreeHeapSize(),
+                              System::GetCurrentMinimumFreeHeapSize(),
+                              (long long)timestamp,
+                              count);
+    if (false == result) {
+        ESP_LOGE(LOG_TAG, "buffer is too small");
+        return httpd_resp_send_500(request);
+    }
+    httpd_resp_set_type(request, "text/plain; version=0.0.4");
+    return httpd_resp_send(request, buffer, length);
+}
+
+esp_err_t MetricsServer::latest_handler(httpd_req_t *request)
+{
+    Value values[MAX_GAUGE_COUNT];
+    time_t timestamp;
+    uint32_t count;
+    size_t length = 0;
+    bool result;
+    size_t gauge_number = copy_snapshot(values, timestamp, count);
+    result = append(buffer, BUFFER_SIZE, length,
+                    "{\"timestamp\":%lld,\"uptime\":%lld,\"free_heap\":%lu,\"min_free_heap\":%lu,\"values\":{",
+                    (long long)timestamp,
+                    esp_timer_get_time() / 1000000,
+                    System::GetCurrentFreeHeapSize(),
+                    System::GetCurrentMinimumFreeHeapSize());
+    bool first = true;
+    for (size_t index = 0; index < gauge_number && result; index++) {
+        if (false == values[index].Valid) {
+            continue;
+        }
+        result = append(buffer, BUFFER_SIZE, length, "%s\"%s\":%.2f",
+                        first ? "" : ",", gauges[index].Name, values[index].Value);
+        first = false;
+    }
+    result = result && append(buffer, BUFFER_SIZE, length, "}}");
+    if (false == result) {
+        ESP_LOGE(LOG_TAG, "buffer is too small");
+        return httpd_resp_send_500(request);
+    }
+    httpd_resp_set_type(request, "application/json");
+    return httpd_resp_send(request, buffer, length);
+}
+
+esp_err_t MetricsServer::boot_handler(httpd_req_t *request)
+{
+    auto timeline = boot::BootSequence::ExportTimeline();
+    httpd_resp_set_type(request, "application/json");
+    return httpd_resp_send(request, timeline.c_str(), timeline.length());
+}
+
+bool MetricsServer::Start(const uint16_t port)
+{
+    bool result = true;
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    httpd_uri_t metrics_uri = {};
+    httpd_uri_t latest_uri = {};
+    httpd_uri_t boot_uri = {};
+    auto &placement = task_placement::TaskPlacement::Get(task_placement::TaskPlacement::TaskType::HTTPD);
+    esp_err_t err;
+    // 设置临界区
+    mutex.Lock();
+    if (nullptr != server) {
+        ESP_LOGI(LOG_TAG, "this has been started");
+        result = false;
+        goto DONE;
+    }
+    config.server_port = port;
+    config.max_uri_handlers = 3;
+    // 空闲连接过多时关闭最久未使用的连接，避免抓取端不断开连接时拒绝新请求
+    config.lru_purge_enable = true;
+    config.core_id = placement.CoreID;
+    config.task_priority = placement.Priority;
+    config.stack_size = placement.StackDepth;
+    err = httpd_start(&server, &config);
+    if (ESP_OK != err) {
+        ESP_LOGE(LOG_TAG, "start failed, the reason is %d", err);
+        server = nullptr;
+        result = false;
+        goto DONE;
+    }
+    metrics_uri.uri = "/metrics";
+    metrics_uri.method = HTTP_GET;
+    metrics_uri.handler = metrics_handler;
+    ESP_ERROR_CHECK(httpd_register_uri_handler(server, &metrics_uri));
+    latest_uri.uri = "/api/latest";
+    latest_uri.method = HTTP_GET;
+    latest_uri.handler = latest_handler;
+    ESP_ERROR_CHECK(httpd_register_uri_handler(server, &latest_uri));
+    boot_uri.uri = "/api/boot";
+    boot_uri.method = HTTP_GET;
+    boot_uri.handler = boot_handler;
+    ESP_ERROR_CHECK(httpd_register_uri_handler(server, &boot_uri));
+    ESP_LOGD(LOG_TAG, "listen on %u", port);
+DONE:
+    // 退出临界区
+    mutex.Unlock();
+    return result;
+}
+
+void MetricsServer::Stop()
+{
+    // 设置临界区
+    mutex.Lock();
+    if (nullptr == server) {
+        ESP_LOGD(LOG_TAG, "this has been stopped");
+    } else {
+        httpd_stop(server);
+        server = nullptr;
+    }
+    // 退出临界区
+    mutex.Unlock();
+}
+
+}
+
+}
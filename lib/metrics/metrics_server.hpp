@@ -0,0 +1,97 @@
+#ifndef _metrics_server_hpp_
+#define _metrics_server_hpp_
+
+#include <time.h>
+
+#include "esp_http_server.h"
+#include "freertos/FreeRTOS.h"
+
+#include "mutex.hpp"
+
+namespace cubestone_wang
+{
+
+namespace metrics
+{
+
+/*
+  指标服务类
+  基于esp_http_server提供/metrics（Prometheus文本格式）及/api/latest（JSON）两个接口，
+  返回最近一次发布的指标快照及设备运行状况；指标在启动前登记，名称等需为静态字符串，
+  响应在预先分配的缓冲区中格式化，处理请求时不分配堆内存；
+  另提供/api/boot返回启动时间线（JSON），请求很少，直接使用BootSequence导出的字符串
+*/
+class MetricsServer
+{
+    public:
+        // 指标句柄
+        typedef uint8_t Handle_t;
+        static const Handle_t INVALID_HANDLE = 0;
+        // 指标最大数量
+        static const uint8_t MAX_GAUGE_COUNT = 24;
+        // 响应缓冲区大小（字节）
+        static const size_t BUFFER_SIZE = 4096;
+        // 日志标签
+        static const char *const LOG_TAG;
+        /**
+         * @brief 登记指标，需在Start之前调用
+         *
+         * @param name 名称，同时用作JSON的键，需为静态字符串
+         * @param help 说明，需为静态字符串
+         */
+        static Handle_t Add(const char *const name, const char *const help);
+        /**
+         * @brief 设置指标的值，Publish后才对外可见
+         *
+         * @param handle 句柄
+         * @param value 值
+         */
+        static void Set(const Handle_t handle, const double value);
+        /**
+         * @brief 发布已设置的值，作为一次完整的快照
+         *
+         * @param timestamp 采样时间戳（秒）
+         */
+        static void Publish(const time_t timestamp);
+        /**
+         * @brief 启动
+         *
+         * @param port 端口
+         */
+        static bool Start(const uint16_t port=80);
+        /**
+         * @brief 停止
+         */
+        static void Stop();
+    private:
+        struct Gauge {
+            const char *Name;
+            const char *Help;
+        };
+        struct Value {
+            double Value;
+            bool Valid;
+        };
+        static sync::Mutex mutex;
+        static httpd_handle_t server;
+        static Gauge gauges[MAX_GAUGE_COUNT];
+        static uint8_t gauge_count;
+        // 保护以下快照数据
+        static portMUX_TYPE spinlock;
+        static Value pending_values[MAX_GAUGE_COUNT];
+        static Value published_values[MAX_GAUGE_COUNT];
+        static time_t published_timestamp;
+        static uint32_t request_count;
+        // 处理请求在httpd任务中依次执行，共用同一缓冲区
+        static char buffer[BUFFER_SIZE];
+        static size_t copy_snapshot(Value *values, time_t &timestamp, uint32_t &count);
+        static esp_err_t metrics_handler(httpd_req_t *request);
+        static esp_err_t latest_handler(httpd_req_t *request);
+        static esp_err_t boot_handler(httpd_req_t *request);
+};
+
+}
+
+}
+
+#endif // _metrics_server_hpp_
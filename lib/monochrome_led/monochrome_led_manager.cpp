@@ -2,15 +2,18 @@
 #include <string>
 
 #include "esp_log.h"
+#include "esp_sleep.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
 
 #include "system.hpp"
+#include "timer.hpp"
 
 #include "monochrome_led_manager.hpp"
 
-namespace cubestone_wang 
+namespace cubestone_wang
 {
 
 namespace monochrome_led
@@ -18,28 +21,266 @@ namespace monochrome_led
 
 using namespace std;
 using namespace system;
+using namespace timer;
+
+// LEDC速度模式
+static const ledc_mode_t LEDC_MODE = LEDC_LOW_SPEED_MODE;
+// 常亮、渐变、呼吸使用的PWM定时器，其余定时器用于闪烁
+static const ledc_timer_t PWM_TIMER = LEDC_TIMER_0;
+static const ledc_timer_bit_t PWM_DUTY_RESOLUTION = LEDC_TIMER_10_BIT;
+static const uint32_t PWM_MAX_DUTY = (1 << PWM_DUTY_RESOLUTION) - 1;
+static const uint32_t PWM_FREQUENCY = 1000;
+// 低速模式时钟使用RTC8M，light sleep期间可保持输出
+static const uint64_t SLOW_CLOCK_FREQUENCY = 8000000;
+// 分频系数为10位整数加8位小数
+static const uint64_t MAX_CLOCK_DIVIDER = (1 << 18) - 1;
 
 const char *const MonochromeLEDManager::LOG_TAG = "MONOCHROME_LED_MANAGER";
 
 bool MonochromeLEDManager::start_flag = false;
 
-SemaphoreHandle_t MonochromeLEDManager::mutex = xSemaphoreCreateMutex();
+bool MonochromeLEDManager::ledc_init_flag = false;
+
+uint32_t MonochromeLEDManager::ledc_channel_mask = 0;
+
+MonochromeLEDManager::BlinkTimer MonochromeLEDManager::blink_timers[LEDC_TIMER_MAX] = {};
+
+uint32_t MonochromeLEDManager::wakeup_count = 0;
+
+sync::Mutex MonochromeLEDManager::mutex("led_manager");
+
+const MonochromeLEDManager::Handle_t MonochromeLEDManager::INVALID_HANDLE = 0;
 
-map<string, MonochromeLEDManager::MonochromeLED *> MonochromeLEDManager::monochrome_led_map = map<string, MonochromeLEDManager::MonochromeLED *>();
+vector<MonochromeLEDManager::MonochromeLED *> MonochromeLEDManager::monochrome_leds;
+
+vector<uint16_t> MonochromeLEDManager::generations;
+
+map<string, MonochromeLEDManager::Handle_t> MonochromeLEDManager::name_to_handle;
+
+Timer::Signal_t MonochromeLEDManager::process_signal = Timer::INVALID_SIGNAL;
+
+Timer::Handle_t MonochromeLEDManager::timer_handle = Timer::INVALID_HANDLE;
+
+bool MonochromeLEDManager::ledc_init()
+{
+    if (ledc_init_flag) {
+        return true;
+    }
+    ledc_timer_config_t timer_config = {};
+    timer_config.speed_mode = LEDC_MODE;
+    timer_config.duty_resolution = PWM_DUTY_RESOLUTION;
+    timer_config.timer_num = PWM_TIMER;
+    timer_config.freq_hz = PWM_FREQUENCY;
+    timer_config.clk_cfg = LEDC_USE_RTC8M_CLK;
+    auto err = ledc_timer_config(&timer_config);
+    if (ESP_OK != err) {
+        ESP_LOGE(LOG_TAG, "config timer failed, the reason is %s", esp_err_to_name(err));
+        return false;
+    }
+    err = ledc_fade_func_install(0);
+    if (ESP_OK != err) {
+        ESP_LOGE(LOG_TAG, "install fade failed, the reason is %s", esp_err_to_name(err));
+        return false;
+    }
+    // light sleep期间保持RTC8M时钟，LEDC继续输出
+    ESP_ERROR_CHECK(esp_sleep_pd_config(ESP_PD_DOMAIN_RTC8M, ESP_PD_OPTION_ON));
+    ledc_init_flag = true;
+    return true;
+}
 
-TaskHandle_t MonochromeLEDManager::task_handler = nullptr;
+bool IRAM_ATTR MonochromeLEDManager::ledc_fade_end_callback(const ledc_cb_param_t *param, void *user_arg)
+{
+    BaseType_t task_woken = pdFALSE;
+    if (LEDC_FADE_END_EVT != param->event) {
+        return false;
+    }
+    ((MonochromeLED *)user_arg)->fade_done = true;
+    if (start_flag) {
+        Timer::RaiseFromISR(process_signal, &task_woken);
+    }
+    return task_woken == pdTRUE;
+}
 
-void MonochromeLEDManager::Add(const string& name, const gpio_num_t pin, const bool reverse_on_off)
+ledc_timer_t MonochromeLEDManager::acquire_blink_timer(const uint32_t period)
 {
+    uint64_t ticks = SLOW_CLOCK_FREQUENCY / 1000 * period;
+    uint32_t duty_resolution = 0;
+    uint64_t clock_divider;
+    for (int timer = 0; timer < LEDC_TIMER_MAX; timer++) {
+        if (PWM_TIMER != timer
+            && 0 < blink_timers[timer].reference_count
+            && period == blink_timers[timer].period) {
+            blink_timers[timer].reference_count++;
+            return (ledc_timer_t)timer;
+        }
+    }
+    // 周期 = 分频系数 * 2^占空比分辨率 / 时钟频率，优先使用最大的分辨率
+    while (duty_resolution < LEDC_TIMER_20_BIT && (ticks >> (duty_resolution + 1)) > 0) {
+        duty_resolution++;
+    }
+    clock_divider = (ticks << 8) >> duty_resolution;
+    if (clock_divider > MAX_CLOCK_DIVIDER) {
+        ESP_LOGW(LOG_TAG, "blink period %lu ms is too long for LEDC", period);
+        return LEDC_TIMER_MAX;
+    }
+    for (int timer = 0; timer < LEDC_TIMER_MAX; timer++) {
+        if (PWM_TIMER == timer || 0 < blink_timers[timer].reference_count) {
+            continue;
+        }
+        // 低速模式下LEDC_APB_CLK表示使用ledc_init中设置的全局慢速时钟
+        auto err = ledc_timer_set(LEDC_MODE, (ledc_timer_t)timer, clock_divider, duty_resolution, LEDC_APB_CLK);
+        if (ESP_OK != err) {
+            ESP_LOGE(LOG_TAG, "set timer failed, the reason is %s", esp_err_to_name(err));
+            return LEDC_TIMER_MAX;
+        }
+        ESP_ERROR_CHECK(ledc_timer_rst(LEDC_MODE, (ledc_timer_t)timer));
+        blink_timers[timer].period = period;
+        blink_timers[timer].duty_resolution = duty_resolution;
+        blink_timers[timer].reference_count = 1;
+        return (ledc_timer_t)timer;
+    }
+    ESP_LOGW(LOG_TAG, "no free LEDC timer for blink period %lu ms", period);
+    return LEDC_TIMER_MAX;
+}
+
+void MonochromeLEDManager::release_blink_timer(ledc_timer_t &timer)
+{
+    if (LEDC_TIMER_MAX == timer) {
+        return;
+    }
+    if (0 < blink_timers[timer].reference_count) {
+        blink_timers[timer].reference_count--;
+    }
+    timer = LEDC_TIMER_MAX;
+}
+
+void MonochromeLEDManager::set_level(MonochromeLED *monochrome_led, const bool on)
+{
+    if (LEDC_CHANNEL_MAX == monochrome_led->channel) {
+        monochrome_led->last_gpio_level = on ? monochrome_led->GPIO_LEVEL_ON : monochrome_led->GPIO_LEVEL_OFF;
+        ESP_ERROR_CHECK(gpio_set_level(monochrome_led->pin, monochrome_led->last_gpio_level));
+    } else {
+        // 通道输出已按reverse_on_off反转，空闲电平即亮灭
+        monochrome_led->last_gpio_level = on ? monochrome_led->GPIO_LEVEL_ON : monochrome_led->GPIO_LEVEL_OFF;
+        ESP_ERROR_CHECK(ledc_stop(LEDC_MODE, monochrome_led->channel, on ? 1 : 0));
+    }
+}
+
+void MonochromeLEDManager::apply(MonochromeLED *monochrome_led, const Mode last_mode)
+{
+    auto channel = monochrome_led->channel;
+    monochrome_led->software = false;
+    if (LEDC_CHANNEL_MAX != channel && (Mode::FADE == last_mode || Mode::BREATHE == last_mode)) {
+        // 渐变进行中时设置占空比会阻塞到渐变结束，先停止渐变，占空比保持在当前值
+        auto err = ledc_fade_stop(LEDC_MODE, channel);
+        if (ESP_OK != err) {
+            ESP_LOGW(LOG_TAG, "%s stop fade failed, the reason is %s", monochrome_led->name.c_str(), esp_err_to_name(err));
+        }
+    }
+    if (Mode::BLINK != monochrome_led->mode) {
+        release_blink_timer(monochrome_led->blink_timer);
+    }
+    switch (monochrome_led->mode) {
+        case Mode::OFF:
+            set_level(monochrome_led, false);
+            return;
+        case Mode::ON:
+            set_level(monochrome_led, true);
+            return;
+        case Mode::BLINK:
+            if (LEDC_CHANNEL_MAX != channel) {
+                auto period = monochrome_led->on + monochrome_led->off;
+                auto timer = acquire_blink_timer(period);
+                release_blink_timer(monochrome_led->blink_timer);
+                monochrome_led->blink_timer = timer;
+                if (LEDC_TIMER_MAX != timer) {
+                    uint32_t duty = ((uint64_t)monochrome_led->on << blink_timers[timer].duty_resolution) / period;
+                    ESP_ERROR_CHECK(ledc_bind_channel_timer(LEDC_MODE, channel, timer));
+                    ESP_ERROR_CHECK(ledc_set_duty_with_hpoint(LEDC_MODE, channel, duty, 0));
+                    ESP_ERROR_CHECK(ledc_update_duty(LEDC_MODE, channel));
+                    return;
+                }
+            }
+            break;
+        case Mode::FADE:
+            if (LEDC_CHANNEL_MAX == channel) {
+                set_level(monochrome_led, monochrome_led->brightness >= 50);
+                return;
+            }
+            ESP_ERROR_CHECK(ledc_bind_channel_timer(LEDC_MODE, channel, PWM_TIMER));
+            if (Mode::FADE != last_mode && Mode::BREATHE != last_mode) {
+                // 从当前亮灭状态开始渐变
+                ESP_ERROR_CHECK(ledc_set_duty(LEDC_MODE, channel, Mode::ON == last_mode ? PWM_MAX_DUTY : 0));
+                ESP_ERROR_CHECK(ledc_update_duty(LEDC_MODE, channel));
+            }
+            ESP_ERROR_CHECK(ledc_set_fade_time_and_start(LEDC_MODE,
+                                                         channel,
+                                                         PWM_MAX_DUTY * monochrome_led->brightness / 100,
+                                                         monochrome_led->duration,
+                                                         LEDC_FADE_NO_WAIT));
+            return;
+        case Mode::BREATHE:
+            if (LEDC_CHANNEL_MAX == channel) {
+                break;
+            }
+            ESP_ERROR_CHECK(ledc_bind_channel_timer(LEDC_MODE, channel, PWM_TIMER));
+            ESP_ERROR_CHECK(ledc_set_duty(LEDC_MODE, channel, 0));
+            ESP_ERROR_CHECK(ledc_update_duty(LEDC_MODE, channel));
+            monochrome_led->fade_up = true;
+            monochrome_led->fade_done = false;
+            ESP_ERROR_CHECK(ledc_set_fade_time_and_start(LEDC_MODE,
+                                                         channel,
+                                                         PWM_MAX_DUTY,
+                                                         monochrome_led->duration / 2,
+                                                         LEDC_FADE_NO_WAIT));
+            return;
+        case Mode::PULSE:
+            break;
+    }
+    // 闪烁及呼吸无法由LEDC实现时、以及脉冲由任务在每次切换时刻处理
+    monochrome_led->software = true;
+    set_level(monochrome_led, true);
+    monochrome_led->next_change_timestamp = esp_timer_get_time()
+                                            + (Mode::PULSE == monochrome_led->mode ? monochrome_led->pulse_on : monochrome_led->on) * (int64_t)1000;
+}
+
+void MonochromeLEDManager::set_mode(MonochromeLED *monochrome_led, const Mode mode)
+{
+    // 脉冲期间只记录，结束后生效
+    if (Mode::PULSE == monochrome_led->mode) {
+        monochrome_led->restore_mode = mode;
+        return;
+    }
+    auto last_mode = monochrome_led->mode;
+    monochrome_led->mode = mode;
+    apply(monochrome_led, last_mode);
+    notify();
+}
+
+void MonochromeLEDManager::notify()
+{
+    // 尚未执行的处理会读取最新的设置，多次触发只执行一次
+    if (start_flag) {
+        Timer::Raise(process_signal);
+    }
+}
+
+MonochromeLEDManager::Handle_t MonochromeLEDManager::Add(const string& name,
+                                                         const gpio_num_t pin,
+                                                         const bool reverse_on_off,
+                                                         const bool use_ledc)
+{
+    Handle_t handle;
     // 设置临界区
-    xSemaphoreTake(mutex, portMAX_DELAY);
-    if (monochrome_led_map.count(name) > 0) {
+    mutex.Lock();
+    if (name_to_handle.count(name) > 0) {
         ESP_LOGE(LOG_TAG, "%s monochrome LED have been exist", name.c_str());
         // 退出临界区
-        xSemaphoreGive(mutex);
-        return;
+        mutex.Unlock();
+        return INVALID_HANDLE;
     }
     auto monochrome_led = new MonochromeLED();
+    monochrome_led->name = name;
     monochrome_led->pin = pin;
     if (reverse_on_off) {
         monochrome_led->GPIO_LEVEL_ON = 0;
@@ -48,59 +289,159 @@ void MonochromeLEDManager::Add(const string& name, const gpio_num_t pin, const b
         monochrome_led->GPIO_LEVEL_ON = 1;
         monochrome_led->GPIO_LEVEL_OFF = 0;
     }
-    ESP_ERROR_CHECK(gpio_reset_pin(monochrome_led->pin));
-    ESP_ERROR_CHECK(gpio_set_intr_type(monochrome_led->pin, GPIO_INTR_DISABLE));
-    ESP_ERROR_CHECK(gpio_set_direction(monochrome_led->pin, GPIO_MODE_OUTPUT));
-    ESP_ERROR_CHECK(gpio_set_level(monochrome_led->pin, monochrome_led->GPIO_LEVEL_OFF));
+    monochrome_led->mode = Mode::OFF;
     monochrome_led->on = 0;
     monochrome_led->off = 100;
+    monochrome_led->brightness = 0;
+    monochrome_led->duration = 0;
+    monochrome_led->pulse_count = 0;
+    monochrome_led->pulse_on = 0;
+    monochrome_led->pulse_off = 0;
+    monochrome_led->restore_mode = Mode::OFF;
+    monochrome_led->channel = LEDC_CHANNEL_MAX;
+    monochrome_led->blink_timer = LEDC_TIMER_MAX;
+    monochrome_led->software = false;
+    monochrome_led->fade_up = false;
+    monochrome_led->fade_done = false;
     monochrome_led->last_gpio_level = monochrome_led->GPIO_LEVEL_OFF;
-    monochrome_led->last_on = 0;
-    monochrome_led->last_off = 0;
-    monochrome_led->last_change_timestamp = 0;
-    monochrome_led_map[name] = monochrome_led;
-    ESP_LOGD(LOG_TAG, "%s add", name.c_str());
+    monochrome_led->next_change_timestamp = 0;
+    // 分配空闲的LEDC通道
+    if (use_ledc && ledc_init()) {
+        for (int channel = 0; channel < LEDC_CHANNEL_MAX; channel++) {
+            if (0 == (ledc_channel_mask & (1 << channel))) {
+                monochrome_led->channel = (ledc_channel_t)channel;
+                break;
+            }
+        }
+        if (LEDC_CHANNEL_MAX == monochrome_led->channel) {
+            ESP_LOGW(LOG_TAG, "%s no free LEDC channel", name.c_str());
+        }
+    }
+    if (LEDC_CHANNEL_MAX != monochrome_led->channel) {
+        ledc_channel_config_t channel_config = {};
+        channel_config.gpio_num = pin;
+        channel_config.speed_mode = LEDC_MODE;
+        channel_config.channel = monochrome_led->channel;
+        channel_config.intr_type = LEDC_INTR_DISABLE;
+        channel_config.timer_sel = PWM_TIMER;
+        channel_config.duty = 0;
+        channel_config.hpoint = 0;
+        channel_config.flags.output_invert = reverse_on_off ? 1 : 0;
+        ESP_ERROR_CHECK(ledc_channel_config(&channel_config));
+        ESP_ERROR_CHECK(ledc_stop(LEDC_MODE, monochrome_led->channel, 0));
+        ledc_cbs_t callbacks = {};
+        callbacks.fade_cb = ledc_fade_end_callback;
+        ESP_ERROR_CHECK(ledc_cb_register(LEDC_MODE, monochrome_led->channel, &callbacks, monochrome_led));
+        // light sleep期间保持GPIO连接到LEDC
+        ESP_ERROR_CHECK(gpio_sleep_sel_dis(pin));
+        ledc_channel_mask |= (1 << monochrome_led->channel);
+    } else {
+        ESP_ERROR_CHECK(gpio_reset_pin(monochrome_led->pin));
+        ESP_ERROR_CHECK(gpio_set_intr_type(monochrome_led->pin, GPIO_INTR_DISABLE));
+        ESP_ERROR_CHECK(gpio_set_direction(monochrome_led->pin, GPIO_MODE_OUTPUT));
+        ESP_ERROR_CHECK(gpio_set_level(monochrome_led->pin, monochrome_led->GPIO_LEVEL_OFF));
+    }
+    // 优先复用已删除的位置
+    size_t index;
+    for (index = 0; index < monochrome_leds.size(); index++) {
+        if (nullptr == monochrome_leds[index]) {
+            break;
+        }
+    }
+    if (index >= monochrome_leds.size()) {
+        monochrome_leds.push_back(monochrome_led);
+        generations.push_back(1);
+    } else {
+        monochrome_leds[index] = monochrome_led;
+    }
+    handle = (static_cast<Handle_t>(generations[index]) << 16) | (index + 1);
+    name_to_handle[name] = handle;
+    ESP_LOGD(LOG_TAG, "%s add, channel %d", name.c_str(), monochrome_led->channel);
     // 退出临界区
-    xSemaphoreGive(mutex);
+    mutex.Unlock();
+    return handle;
 }
 
 void MonochromeLEDManager::Del(const string& name)
 {
     // 设置临界区
-    xSemaphoreTake(mutex, portMAX_DELAY);
-    if (monochrome_led_map.count(name) == 0) {
+    mutex.Lock();
+    auto iter = name_to_handle.find(name);
+    if (iter == name_to_handle.end()) {
         ESP_LOGE(LOG_TAG, "%s can't be found", name.c_str());
         // 退出临界区
-        xSemaphoreGive(mutex);
+        mutex.Unlock();
         return;
     }
-    monochrome_led_map.erase(name);
+    auto index = (iter->second & 0xffff) - 1;
+    auto monochrome_led = monochrome_leds[index];
+    if (LEDC_CHANNEL_MAX != monochrome_led->channel) {
+        ledc_cbs_t callbacks = {};
+        ESP_ERROR_CHECK(ledc_cb_register(LEDC_MODE, monochrome_led->channel, &callbacks, nullptr));
+        ESP_ERROR_CHECK(ledc_stop(LEDC_MODE, monochrome_led->channel, 0));
+        release_blink_timer(monochrome_led->blink_timer);
+        ledc_channel_mask &= ~(1 << monochrome_led->channel);
+    }
+    ESP_ERROR_CHECK(gpio_reset_pin(monochrome_led->pin));
+    monochrome_leds[index] = nullptr;
+    generations[index]++;
+    name_to_handle.erase(iter);
+    delete monochrome_led;
     ESP_LOGD(LOG_TAG, "%s del", name.c_str());
     // 退出临界区
-    xSemaphoreGive(mutex);
+    mutex.Unlock();
 }
 
-bool MonochromeLEDManager::Start(const UBaseType_t task_priority, const uint32_t stack_depth)
-{  
-    // 判断是否已经启动  
+bool MonochromeLEDManager::Start()
+{
+    // 判断是否已经启动
     // 设置临界区
-    xSemaphoreTake(mutex, portMAX_DELAY);
+    mutex.Lock();
     if (start_flag == true) {
         ESP_LOGI(LOG_TAG, "this has been started");
         // 退出临界区
-        xSemaphoreGive(mutex);
+        mutex.Unlock();
         return false;
     }
-    start_flag = true;
-    auto err = xTaskCreate(run_task, 
-                           "monochrome_led", 
-                           stack_depth, 
-                           nullptr, 
-                           task_priority, 
-                           &task_handler);
+    // 信号不能删除，再次启动时沿用
+    if (Timer::INVALID_SIGNAL == process_signal) {
+        process_signal = Timer::AddSignal(process);
+    }
+    auto result = Timer::INVALID_SIGNAL != process_signal;
+    if (result) {
+        start_flag = true;
+        Timer::Raise(process_signal);
+    }
     // 退出临界区
-    xSemaphoreGive(mutex);
-    return err == pdPASS;
+    mutex.Unlock();
+    return result;
+}
+
+MonochromeLEDManager::Handle_t MonochromeLEDManager::GetHandle(const string& name)
+{
+    Handle_t handle = INVALID_HANDLE;
+    // 设置临界区
+    mutex.Lock();
+    auto iter = name_to_handle.find(name);
+    if (iter != name_to_handle.end()) {
+        handle = iter->second;
+    }
+    // 退出临界区
+    mutex.Unlock();
+    return handle;
+}
+
+MonochromeLEDManager::MonochromeLED *MonochromeLEDManager::get(const Handle_t handle)
+{
+    uint32_t index = (handle & 0xffff);
+    if (0 == index || index > monochrome_leds.size()) {
+        return nullptr;
+    }
+    // 已删除或位置已被复用时代数不一致
+    if (generations[index - 1] != (handle >> 16)) {
+        return nullptr;
+    }
+    return monochrome_leds[index - 1];
 }
 
 void MonochromeLEDManager::SetOn(const string& name)
@@ -114,143 +455,292 @@ void MonochromeLEDManager::SetOff(const string& name)
 }
 
 void MonochromeLEDManager::SetBlink(const string& name, const uint32_t on, const uint32_t off)
-{   
-    // 设置临界区
-    xSemaphoreTake(mutex, portMAX_DELAY);
-    auto iter = monochrome_led_map.find(name);  
-    if(iter == monochrome_led_map.end()) {
+{
+    auto handle = GetHandle(name);
+    if (INVALID_HANDLE == handle) {
         ESP_LOGE(LOG_TAG, "%s can't be found", name.c_str());
-        // 退出临界区
-        xSemaphoreGive(mutex);
         return;
     }
-    auto monochrome_led = iter->second;
-    if (on == 0 && off == 0)
-    {
-        ESP_LOGE(LOG_TAG, "%s off %% 50 must equal to 0, set error", name.c_str());
-        // 退出临界区
-        xSemaphoreGive(mutex);
+    MonochromeLEDManager::SetBlink(handle, on, off);
+}
+
+void MonochromeLEDManager::SetFade(const string& name, const uint8_t brightness, const uint32_t duration)
+{
+    auto handle = GetHandle(name);
+    if (INVALID_HANDLE == handle) {
+        ESP_LOGE(LOG_TAG, "%s can't be found", name.c_str());
         return;
     }
-    if (on % 50 != 0)
-    {
-        ESP_LOGE(LOG_TAG, "%s on %% 50 must equal to 0, set error", name.c_str());
+    MonochromeLEDManager::SetFade(handle, brightness, duration);
+}
+
+void MonochromeLEDManager::SetBreathe(const string& name, const uint32_t period)
+{
+    auto handle = GetHandle(name);
+    if (INVALID_HANDLE == handle) {
+        ESP_LOGE(LOG_TAG, "%s can't be found", name.c_str());
+        return;
+    }
+    MonochromeLEDManager::SetBreathe(handle, period);
+}
+
+void MonochromeLEDManager::SetPulse(const string& name, const uint32_t count, const uint32_t on, const uint32_t off)
+{
+    auto handle = GetHandle(name);
+    if (INVALID_HANDLE == handle) {
+        ESP_LOGE(LOG_TAG, "%s can't be found", name.c_str());
+        return;
+    }
+    MonochromeLEDManager::SetPulse(handle, count, on, off);
+}
+
+void MonochromeLEDManager::SetOn(const Handle_t handle)
+{
+    MonochromeLEDManager::SetBlink(handle, 100, 0);
+}
+
+void MonochromeLEDManager::SetOff(const Handle_t handle)
+{
+    MonochromeLEDManager::SetBlink(handle, 0, 100);
+}
+
+void MonochromeLEDManager::SetBlink(const Handle_t handle, const uint32_t on, const uint32_t off)
+{
+    Mode current_mode, mode;
+    // 设置临界区
+    mutex.Lock();
+    auto monochrome_led = get(handle);
+    if (nullptr == monochrome_led) {
+        ESP_LOGE(LOG_TAG, "handle %lu can't be found", handle);
         // 退出临界区
-        xSemaphoreGive(mutex);
+        mutex.Unlock();
         return;
     }
-    if (off % 50 != 0)
+    if (on == 0 && off == 0)
     {
-        ESP_LOGE(LOG_TAG, "%s off %% 50 must equal to 0, set error", name.c_str());
+        ESP_LOGE(LOG_TAG, "%s on and off can't be 0 at the same time, set error", monochrome_led->name.c_str());
         // 退出临界区
-        xSemaphoreGive(mutex);
+        mutex.Unlock();
         return;
     }
-    monochrome_led->on = on;
-    monochrome_led->off = off;
+    current_mode = Mode::PULSE == monochrome_led->mode ? monochrome_led->restore_mode : monochrome_led->mode;
     if (off == 0) {
-        ESP_LOGD(LOG_TAG, "%s always on", name.c_str());
+        mode = Mode::ON;
+        ESP_LOGD(LOG_TAG, "%s always on", monochrome_led->name.c_str());
     } else if (on == 0) {
-        ESP_LOGD(LOG_TAG, "%s always off", name.c_str());
+        mode = Mode::OFF;
+        ESP_LOGD(LOG_TAG, "%s always off", monochrome_led->name.c_str());
     } else {
-        ESP_LOGD(LOG_TAG, "%s blink, on %lu ms, off %lu ms", 
-                 name.c_str(),
-                 monochrome_led->on,
-                 monochrome_led->off);
+        mode = Mode::BLINK;
+        ESP_LOGD(LOG_TAG, "%s blink, on %lu ms, off %lu ms", monochrome_led->name.c_str(), on, off);
+    }
+    // 与当前设置相同时不重新设置，避免打断闪烁相位
+    if (current_mode != mode
+        || (Mode::BLINK == mode && (monochrome_led->on != on || monochrome_led->off != off))) {
+        monochrome_led->on = on;
+        monochrome_led->off = off;
+        set_mode(monochrome_led, mode);
+    }
+    // 退出临界区
+    mutex.Unlock();
+}
+
+void MonochromeLEDManager::SetFade(const Handle_t handle, const uint8_t brightness, const uint32_t duration)
+{
+    // 设置临界区
+    mutex.Lock();
+    auto monochrome_led = get(handle);
+    if (nullptr == monochrome_led) {
+        ESP_LOGE(LOG_TAG, "handle %lu can't be found", handle);
+        // 退出临界区
+        mutex.Unlock();
+        return;
+    }
+    monochrome_led->brightness = brightness > 100 ? 100 : brightness;
+    monochrome_led->duration = duration;
+    ESP_LOGD(LOG_TAG, "%s fade to %u%% in %lu ms", monochrome_led->name.c_str(), monochrome_led->brightness, duration);
+    set_mode(monochrome_led, Mode::FADE);
+    // 退出临界区
+    mutex.Unlock();
+}
+
+void MonochromeLEDManager::SetBreathe(const Handle_t handle, const uint32_t period)
+{
+    // 设置临界区
+    mutex.Lock();
+    auto monochrome_led = get(handle);
+    if (nullptr == monochrome_led) {
+        ESP_LOGE(LOG_TAG, "handle %lu can't be found", handle);
+        // 退出临界区
+        mutex.Unlock();
+        return;
+    }
+    if (period < 2) {
+        ESP_LOGE(LOG_TAG, "%s period is too short, set error", monochrome_led->name.c_str());
+        // 退出临界区
+        mutex.Unlock();
+        return;
+    }
+    auto current_mode = Mode::PULSE == monochrome_led->mode ? monochrome_led->restore_mode : monochrome_led->mode;
+    if (Mode::BREATHE != current_mode || monochrome_led->duration != period) {
+        monochrome_led->duration = period;
+        // 软件方式下以半个周期亮灭闪烁
+        monochrome_led->on = period / 2;
+        monochrome_led->off = period - period / 2;
+        ESP_LOGD(LOG_TAG, "%s breathe, period %lu ms", monochrome_led->name.c_str(), period);
+        set_mode(monochrome_led, Mode::BREATHE);
     }
     // 退出临界区
-    xSemaphoreGive(mutex);
+    mutex.Unlock();
+}
+
+void MonochromeLEDManager::SetPulse(const Handle_t handle, const uint32_t count, const uint32_t on, const uint32_t off)
+{
+    // 设置临界区
+    mutex.Lock();
+    auto monochrome_led = get(handle);
+    if (nullptr == monochrome_led) {
+        ESP_LOGE(LOG_TAG, "handle %lu can't be found", handle);
+        // 退出临界区
+        mutex.Unlock();
+        return;
+    }
+    if (count == 0 || on == 0) {
+        ESP_LOGE(LOG_TAG, "%s count and on can't be 0, set error", monochrome_led->name.c_str());
+        // 退出临界区
+        mutex.Unlock();
+        return;
+    }
+    auto last_mode = monochrome_led->mode;
+    // 脉冲期间再次设置时只重新开始计数
+    if (Mode::PULSE != last_mode) {
+        monochrome_led->restore_mode = last_mode;
+    }
+    monochrome_led->mode = Mode::PULSE;
+    monochrome_led->pulse_count = count;
+    monochrome_led->pulse_on = on;
+    monochrome_led->pulse_off = off;
+    ESP_LOGD(LOG_TAG, "%s pulse %lu times, on %lu ms, off %lu ms", monochrome_led->name.c_str(), count, on, off);
+    apply(monochrome_led, last_mode);
+    notify();
+    // 退出临界区
+    mutex.Unlock();
+}
+
+uint32_t MonochromeLEDManager::GetWakeupCount()
+{
+    return wakeup_count;
+}
+
+void MonochromeLEDManager::timer_callback(void *)
+{
+    // 设置临界区
+    mutex.Lock();
+    // 事件已触发，句柄失效
+    timer_handle = Timer::INVALID_HANDLE;
+    // 退出临界区
+    mutex.Unlock();
+    process(nullptr);
 }
 
-void MonochromeLEDManager::run_task(void *) 
+void MonochromeLEDManager::process(void *)
 {
-    ESP_LOGD(LOG_TAG, "running");
-    uint32_t current_timestamp = esp_log_timestamp();;
-    uint32_t timestamp_interval;
-    for (auto iter = monochrome_led_map.begin(); iter != monochrome_led_map.end(); iter++) 
+    int64_t current_timestamp;
+    int64_t next_timestamp;
+    // 设置临界区
+    mutex.Lock();
+    if (!start_flag) {
+        // 退出临界区
+        mutex.Unlock();
+        return;
+    }
+    wakeup_count++;
+    current_timestamp = esp_timer_get_time();
+    next_timestamp = INT64_MAX;
+    // 处理每一个灯
+    for (auto monochrome_led : monochrome_leds)
     {
-        iter->second->last_change_timestamp = current_timestamp;
-    }
-    while (true) 
-    {   
-        // 设置临界区
-        xSemaphoreTake(mutex, portMAX_DELAY);
-        // 处理每一个灯
-        for (auto iter = monochrome_led_map.begin(); iter != monochrome_led_map.end(); iter++) 
-        {
-            auto monochrome_led = iter->second;
-            if (monochrome_led->last_on == monochrome_led->on 
-                && monochrome_led->last_off == monochrome_led->off
-                && monochrome_led->on != 0
-                && monochrome_led->off != 0) {
-                // 还是之前的设置, 则计算等待时间进行处理，只需要处理闪烁的情况
-                current_timestamp = esp_log_timestamp();
-                if (current_timestamp >= monochrome_led->last_change_timestamp) {
-                    timestamp_interval = current_timestamp - monochrome_led->last_change_timestamp;
-                } else {
-                    // 处理时间戳溢出问题
-                    timestamp_interval = UINT32_MAX - monochrome_led->last_change_timestamp + current_timestamp;
+        if (nullptr == monochrome_led) {
+            continue;
+        }
+        if (Mode::BREATHE == monochrome_led->mode && !monochrome_led->software && monochrome_led->fade_done) {
+            // 呼吸时每半个周期切换一次渐变方向
+            monochrome_led->fade_done = false;
+            monochrome_led->fade_up = !monochrome_led->fade_up;
+            ESP_ERROR_CHECK(ledc_set_fade_time_and_start(LEDC_MODE,
+                                                         monochrome_led->channel,
+                                                         monochrome_led->fade_up ? PWM_MAX_DUTY : 0,
+                                                         monochrome_led->duration / 2,
+                                                         LEDC_FADE_NO_WAIT));
+            continue;
+        }
+        if (!monochrome_led->software) {
+            continue;
+        }
+        if (current_timestamp >= monochrome_led->next_change_timestamp) {
+            int64_t interval;
+            bool is_pulse = Mode::PULSE == monochrome_led->mode;
+            if (monochrome_led->last_gpio_level == monochrome_led->GPIO_LEVEL_ON) {
+                set_level(monochrome_led, false);
+                interval = (is_pulse ? monochrome_led->pulse_off : monochrome_led->off) * (int64_t)1000;
+                if (is_pulse && monochrome_led->pulse_count > 0) {
+                    monochrome_led->pulse_count--;
                 }
-                if (monochrome_led->last_gpio_level == monochrome_led->GPIO_LEVEL_ON) {
-                    // 之前是亮的，看是否需要切换到灭
-                    if (timestamp_interval >= monochrome_led->on) {
-                        ESP_ERROR_CHECK(gpio_set_level(monochrome_led->pin, monochrome_led->GPIO_LEVEL_OFF));
-                        monochrome_led->last_gpio_level = monochrome_led->GPIO_LEVEL_OFF;
-                        monochrome_led->last_change_timestamp = esp_log_timestamp();
-                    }
-                } else {
-                    // 之前是灭的，看是否需要切换到亮
-                    if (timestamp_interval >= monochrome_led->off) {
-                        ESP_ERROR_CHECK(gpio_set_level(monochrome_led->pin, monochrome_led->GPIO_LEVEL_ON));
-                        monochrome_led->last_gpio_level = monochrome_led->GPIO_LEVEL_ON;
-                        monochrome_led->last_change_timestamp = esp_log_timestamp();
-                    }
+            } else if (is_pulse && 0 == monochrome_led->pulse_count) {
+                // 脉冲结束，恢复之前的状态
+                monochrome_led->mode = monochrome_led->restore_mode;
+                apply(monochrome_led, Mode::PULSE);
+                if (!monochrome_led->software) {
+                    continue;
                 }
+                interval = 0;
             } else {
-                // 变成新的设置了
-                if (monochrome_led->off == 0) {
-                    // 常亮
-                    if (monochrome_led->last_gpio_level == monochrome_led->GPIO_LEVEL_OFF) {
-                        ESP_ERROR_CHECK(gpio_set_level(monochrome_led->pin, monochrome_led->GPIO_LEVEL_ON));
-                        monochrome_led->last_gpio_level = monochrome_led->GPIO_LEVEL_ON;
-                    }
-                } else if (monochrome_led->on == 0) {
-                    // 常灭
-                    if (monochrome_led->last_gpio_level == monochrome_led->GPIO_LEVEL_ON) {
-                        ESP_ERROR_CHECK(gpio_set_level(monochrome_led->pin, monochrome_led->GPIO_LEVEL_OFF));
-                        monochrome_led->last_gpio_level = monochrome_led->GPIO_LEVEL_OFF;
-                    }
-                } else {
-                    // 闪烁
-                    ESP_ERROR_CHECK(gpio_set_level(monochrome_led->pin, monochrome_led->GPIO_LEVEL_ON));
-                    monochrome_led->last_gpio_level = monochrome_led->GPIO_LEVEL_ON;
-                    monochrome_led->last_change_timestamp = esp_log_timestamp();
-                }
-                monochrome_led->last_on = monochrome_led->on;
-                monochrome_led->last_off = monochrome_led->off;
+                set_level(monochrome_led, true);
+                interval = (is_pulse ? monochrome_led->pulse_on : monochrome_led->on) * (int64_t)1000;
+            }
+            monochrome_led->next_change_timestamp += interval;
+            // 落后时从当前时刻重新计算
+            if (interval > 0 && monochrome_led->next_change_timestamp <= current_timestamp) {
+                monochrome_led->next_change_timestamp = current_timestamp + interval;
             }
         }
-        // 退出临界区
-        xSemaphoreGive(mutex);
-        //休眠至下一处理周期
-        System::Sleep(10);
+        if (monochrome_led->next_change_timestamp < next_timestamp) {
+            next_timestamp = monochrome_led->next_change_timestamp;
+        }
     }
+    // 在下一次切换时刻再次处理，设置改变时另行投递
+    if (INT64_MAX == next_timestamp) {
+        if (Timer::INVALID_HANDLE != timer_handle) {
+            Timer::Del(timer_handle);
+            timer_handle = Timer::INVALID_HANDLE;
+        }
+    } else {
+        // 向上取整，保证不会提前处理
+        uint32_t delay = next_timestamp > current_timestamp ? (next_timestamp - current_timestamp + 999) / 1000 : 0;
+        if (Timer::INVALID_HANDLE == timer_handle || !Timer::Reschedule(timer_handle, delay)) {
+            timer_handle = Timer::AddOneShotEvent(delay, timer_callback);
+        }
+    }
+    // 退出临界区
+    mutex.Unlock();
 }
 
 void MonochromeLEDManager::Stop()
 {
     // 设置临界区
-    xSemaphoreTake(mutex, portMAX_DELAY);
-    if (start_flag == false) { 
+    mutex.Lock();
+    if (start_flag == false) {
         ESP_LOGD(LOG_TAG, "this has been stopped");
         goto DONE;
     }
-    vTaskDelete(task_handler);
-    task_handler = nullptr;
+    if (Timer::INVALID_HANDLE != timer_handle) {
+        Timer::Del(timer_handle);
+        timer_handle = Timer::INVALID_HANDLE;
+    }
 DONE:
     start_flag = false;
     // 退出临界区
-    xSemaphoreGive(mutex);
+    mutex.Unlock();
     return;
 }
 
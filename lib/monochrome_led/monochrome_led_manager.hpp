@@ -3,13 +3,18 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 #include "driver/gpio.h"
+#include "driver/ledc.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
 
-namespace cubestone_wang 
+#include "timer.hpp"
+#include "mutex.hpp"
+
+namespace cubestone_wang
 {
 
 namespace monochrome_led
@@ -17,82 +22,181 @@ namespace monochrome_led
 
 using namespace std;
 
-// 单色LED管理类
+/*
+  单色LED管理类
+  优先使用LEDC外设输出常亮、常灭、闪烁、渐变、呼吸效果，稳定状态下不需要CPU参与，
+  LEDC通道或定时器不足时回退到软件方式，在下一次电平切换时刻由定时器执行处理
+*/
 class MonochromeLEDManager
 {
     public:
+        /**
+         * @brief 句柄定义，INVALID_HANDLE表示无效
+         * 低16位为位置+1，高16位为该位置的代数，删除后旧句柄失效
+         */
+        typedef uint32_t Handle_t;
+        static const Handle_t INVALID_HANDLE;
         /**
          * @brief 添加
-         * 
+         *
          * @param name 名称
          * @param gpio_num_t GPIO
          * @param reverse_on_off 是否反转亮灭
+         * @param use_ledc 是否使用LEDC外设
+         * @return 句柄，失败时返回INVALID_HANDLE
          */
-        static void Add(const string& name, const gpio_num_t pin, const bool reverse_on_off=false);
+        static Handle_t Add(const string& name,
+                            const gpio_num_t pin,
+                            const bool reverse_on_off=false,
+                            const bool use_ledc=true);
         /**
          * @brief 删除
-         * 
+         *
          * @param name 名称
          */
         static void Del(const string& name);
         /**
-         * @brief 启动
-         * 
-         * @param task_priority 任务优先级
-         * @param stack_depth 任务栈深度
+         * @brief 根据名称获取句柄，找不到时返回INVALID_HANDLE
+         *
+         * @param name 名称
          */
-        static bool Start(const UBaseType_t task_priority=1, const uint32_t stack_depth=3072);
+        static Handle_t GetHandle(const string& name);
+        /**
+         * @brief 启动，处理在定时器的调度任务中执行，不再创建单独的任务
+         */
+        static bool Start();
         /**
          * @brief 停止
          */
         static void Stop();
         /**
          * @brief 点亮LED
-         * 
+         *
          * @param name 名称
          */
         static void SetOn(const string& name);
         /**
          * @brief 熄灭LED
-         * 
+         *
          * @param name 名称
          */
         static void SetOff(const string& name);
         /**
          * @brief 闪烁LED
-         * 
+         *
          * @param name 名称
          * @param on 亮（毫秒）
          * @param off 灭（毫秒）
          */
         static void SetBlink(const string& name, const uint32_t on=100, const uint32_t off=100);
         /**
-         * @brief 闪烁LED
-         * 
+         * @brief 渐变至指定亮度，未使用LEDC时亮度不小于50直接点亮，否则熄灭
+         *
          * @param name 名称
+         * @param brightness 亮度（0~100）
+         * @param duration 渐变时间（毫秒）
+         */
+        static void SetFade(const string& name, const uint8_t brightness, const uint32_t duration=1000);
+        /**
+         * @brief 呼吸LED，未使用LEDC时以半个周期亮灭闪烁
+         *
+         * @param name 名称
+         * @param period 呼吸周期（毫秒）
+         */
+        static void SetBreathe(const string& name, const uint32_t period=2000);
+        /**
+         * @brief 闪烁指定次数后恢复之前的状态，期间的其他设置在结束后生效
+         *
+         * @param name 名称
+         * @param count 次数
          * @param on 亮（毫秒）
          * @param off 灭（毫秒）
          */
+        static void SetPulse(const string& name, const uint32_t count, const uint32_t on=200, const uint32_t off=200);
+        /*
+          以下为使用句柄的版本，省去按名称查找
+        */
+        static void SetOn(const Handle_t handle);
+        static void SetOff(const Handle_t handle);
+        static void SetBlink(const Handle_t handle, const uint32_t on=100, const uint32_t off=100);
+        static void SetFade(const Handle_t handle, const uint8_t brightness, const uint32_t duration=1000);
+        static void SetBreathe(const Handle_t handle, const uint32_t period=2000);
+        static void SetPulse(const Handle_t handle, const uint32_t count, const uint32_t on=200, const uint32_t off=200);
+        /**
+         * @brief 获取处理次数
+         */
+        static uint32_t GetWakeupCount();
         // 日志标签
         static const char *const LOG_TAG;
     private:
+        enum class Mode {
+            OFF,
+            ON,
+            BLINK,
+            FADE,
+            BREATHE,
+            PULSE,
+        };
         // 单色LED类
         class MonochromeLED
-        {   
+        {
             public:
+                string name;
                 uint32_t GPIO_LEVEL_ON, GPIO_LEVEL_OFF;
-                gpio_num_t pin;                            
-                uint32_t on, off;   
+                gpio_num_t pin;
+                Mode mode;
+                uint32_t on, off;
+                uint8_t brightness;
+                uint32_t duration;
+                // 脉冲剩余次数及亮灭时间，结束后恢复为restore_mode
+                uint32_t pulse_count;
+                uint32_t pulse_on, pulse_off;
+                Mode restore_mode;
+                // LEDC通道，LEDC_CHANNEL_MAX表示直接控制GPIO
+                ledc_channel_t channel;
+                // 闪烁使用的LEDC定时器，LEDC_TIMER_MAX表示未使用
+                ledc_timer_t blink_timer;
+                // 当前效果是否由任务软件实现
+                bool software;
+                // 呼吸时当前是否为变亮过程
+                bool fade_up;
+                // 渐变结束标志，由中断设置
+                volatile bool fade_done;
                 uint32_t last_gpio_level;
-                uint32_t last_on;
-                uint32_t last_off;
-                uint32_t last_change_timestamp;      
+                // 软件方式下次切换电平的时间（微秒）
+                int64_t next_change_timestamp;
+        };
+        // 闪烁用的LEDC定时器
+        struct BlinkTimer {
+            uint32_t period;
+            uint32_t duty_resolution;
+            uint32_t reference_count;
         };
-        static void run_task(void *);
+        static void process(void *);
+        static void timer_callback(void *);
+        static bool ledc_init();
+        static bool ledc_fade_end_callback(const ledc_cb_param_t *param, void *user_arg);
+        static ledc_timer_t acquire_blink_timer(const uint32_t period);
+        static void release_blink_timer(ledc_timer_t &timer);
+        static void apply(MonochromeLED *monochrome_led, const Mode last_mode);
+        static void set_level(MonochromeLED *monochrome_led, const bool on);
+        static void set_mode(MonochromeLED *monochrome_led, const Mode mode);
+        static void notify();
         static bool start_flag;
-        static SemaphoreHandle_t mutex;
-        static map<string, MonochromeLED *> monochrome_led_map;
-        static TaskHandle_t task_handler;
+        static bool ledc_init_flag;
+        static uint32_t ledc_channel_mask;
+        static BlinkTimer blink_timers[LEDC_TIMER_MAX];
+        static uint32_t wakeup_count;
+        static sync::Mutex mutex;
+        static MonochromeLED *get(const Handle_t handle);
+        static vector<MonochromeLED *> monochrome_leds;
+        // 各位置的代数，每次删除后递增，防止旧句柄误用新添加的LED
+        static vector<uint16_t> generations;
+        static map<string, Handle_t> name_to_handle;
+        // 触发处理的信号，不占用投递队列，执行前多次触发只执行一次
+        static timer::Timer::Signal_t process_signal;
+        // 下一次电平切换时刻的一次性事件
+        static timer::Timer::Handle_t timer_handle;
 };
 
 }
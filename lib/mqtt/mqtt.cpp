@@ -0,0 +1,330 @@
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "task_placement.hpp"
+
+#include "mqtt.hpp"
+
+namespace cubestone_wang 
+{
+
+namespace mqtt
+{
+
+using namespace timer;
+
+const char *const MQTT::LOG_TAG = "MQTT";
+
+sync::Mutex MQTT::mutex(LOG_TAG);
+
+esp_mqtt_client_handle_t MQTT::client = nullptr;
+
+std::string MQTT::uri;
+std::string MQTT::client_id;
+std::string MQTT::username;
+std::string MQTT::password;
+std::string MQTT::data_topic;
+std::string MQTT::latest_topic;
+uint8_t MQTT::qos = 1;
+bool MQTT::retain = true;
+uint8_t MQTT::batch_size = 1;
+
+MQTT::Message MQTT::batch = {"", 0};
+
+Timer::Handle_t MQTT::batch_timer_handle = Timer::INVALID_HANDLE;
+
+std::deque<MQTT::Message> MQTT::offline_messages;
+
+size_t MQTT::offline_bytes = 0;
+
+std::atomic<bool> MQTT::connected(false);
+
+portMUX_TYPE MQTT::spinlock = portMUX_INITIALIZER_UNLOCKED;
+
+MQTT::Statistics MQTT::statistics = {};
+
+int64_t MQTT::start_timestamp = 0;
+
+bool MQTT::Start(const std::string &uri,
+                 const std::string &client_id,
+                 const std::string &username,
+                 const std::string &password,
+                 const std::string &topic,
+                 const uint8_t qos,
+                 const bool retain,
+                 const uint8_t batch_size,
+                 const uint16_t keepalive)
+{
+    bool result = false;
+    esp_mqtt_client_config_t config;
+    auto &placement = task_placement::TaskPlacement::Get(task_placement::TaskPlacement::TaskType::MQTT);
+    // 设置临界区
+    mutex.Lock();
+    if (nullptr != client) {
+        ESP_LOGW(LOG_TAG, "already started");
+        result = true;
+        goto DONE;
+    }
+    MQTT::uri = uri;
+    MQTT::client_id = client_id;
+    MQTT::username = username;
+    MQTT::password = password;
+    MQTT::data_topic = topic + "/data";
+    MQTT::latest_topic = topic + "/latest";
+    MQTT::qos = qos > 1 ? 1 : qos;
+    MQTT::retain = retain;
+    MQTT::batch_size = batch_size < 1 ? 1 : batch_size;
+    memset((void *)&config, 0, sizeof(config));
+    config.broker.address.uri = MQTT::uri.c_str();
+    if ("" != MQTT::client_id) {
+        config.credentials.client_id = MQTT::client_id.c_str();
+    }
+    if ("" != MQTT::username) {
+        config.credentials.username = MQTT::username.c_str();
+    }
+    if ("" != MQTT::password) {
+        config.credentials.authentication.password = MQTT::password.c_str();
+    }
+    config.session.keepalive = keepalive;
+    // QoS 1时由服务器保留会话，重连后继续投递未确认的消息
+    config.session.disable_clean_session = (MQTT::qos > 0);
+    // 核心由sdkconfig决定，见TaskPlacement
+    config.task.priority = placement.Priority;
+    config.task.stack_size = placement.StackDepth;
+    client = esp_mqtt_client_init(&config);
+    if (nullptr == client) {
+        ESP_LOGE(LOG_TAG, "init failed");
+        goto DONE;
+    }
+    ESP_ERROR_CHECK(esp_mqtt_client_register_event(client, MQTT_EVENT_ANY, MQTT::event_handler, nullptr));
+    if (ESP_OK != esp_mqtt_client_start(client)) {
+        ESP_LOGE(LOG_TAG, "start failed");
+        esp_mqtt_client_destroy(client);
+        client = nullptr;
+        goto DONE;
+    }
+    portENTER_CRITICAL(&spinlock);
+    statistics = {};
+    // 保留启动前缓存的消息
+    statistics.Buffered = offline_messages.size();
+    statistics.BufferedBytes = offline_bytes;
+    portEXIT_CRITICAL(&spinlock);
+    start_timestamp = esp_timer_get_time();
+    result = true;
+DONE:
+    // 退出临界区
+    mutex.Unlock();
+    return result;
+}
+
+void MQTT::Stop()
+{
+    // 设置临界区
+    mutex.Lock();
+    // 连接时立即发布未满的批次，否则转入缓存；在重启任务中执行，可以等待网络
+    flush(false);
+    if (nullptr != client) {
+        esp_mqtt_client_stop(client);
+        esp_mqtt_client_destroy(client);
+        client = nullptr;
+        connected = false;
+    }
+    // 退出临界区
+    mutex.Unlock();
+}
+
+bool MQTT::IsConnected()
+{
+    return connected;
+}
+
+bool MQTT::send(const Message &message, const bool enqueue)
+{
+    int msg_id;
+    if (enqueue) {
+        // 放入发件箱由MQTT任务发送，不阻塞调用者
+        msg_id = esp_mqtt_client_enqueue(client,
+                                         data_topic.c_str(),
+                                         message.Payload.c_str(),
+                                         message.Payload.length(),
+                                         qos,
+                                         0,
+                                         true);
+    } else {
+        msg_id = esp_mqtt_client_publish(client,
+                                         data_topic.c_str(),
+                                         message.Payload.c_str(),
+                                         message.Payload.length(),
+                                         qos,
+                                         0);
+    }
+    if (msg_id < 0) {
+        return false;
+    }
+    portENTER_CRITICAL(&spinlock);
+    statistics.Samples += message.SampleCount;
+    statistics.Messages++;
+    statistics.PayloadBytes += message.Payload.length();
+    portEXIT_CRITICAL(&spinlock);
+    return true;
+}
+
+void MQTT::buffer(Message &message)
+{
+    uint32_t dropped = 0;
+    if (message.Payload.length() > OFFLINE_BUFFER_BYTES) {
+        // 单条超出时直接丢弃，不挤掉已缓存的消息
+        dropped = message.SampleCount;
+    } else {
+        // 按数量及字节数丢弃最早的消息
+        while (!offline_messages.empty()
+               && (offline_messages.size() >= OFFLINE_BUFFER_SIZE
+                   || offline_bytes + message.Payload.length() > OFFLINE_BUFFER_BYTES)) {
+            dropped += offline_messages.front().SampleCount;
+            offline_bytes -= offline_messages.front().Payload.length();
+            offline_messages.pop_front();
+        }
+        offline_bytes += message.Payload.length();
+        offline_messages.push_back(std::move(message));
+    }
+    portENTER_CRITICAL(&spinlock);
+    statistics.Dropped += dropped;
+    statistics.Buffered = offline_messages.size();
+    statistics.BufferedBytes = offline_bytes;
+    portEXIT_CRITICAL(&spinlock);
+}
+
+bool MQTT::Publish(const std::string &line)
+{
+    sync::LockGuard lock(mutex);
+    // 启动前及连接前同样加入批次，满后缓存，连接后补发
+    if (0 != batch.SampleCount) {
+        batch.Payload.push_back('\n');
+    }
+    batch.Payload.append(line);
+    batch.SampleCount++;
+    if (batch.SampleCount < batch_size) {
+        // 第一个采样加入时开始计时
+        if (1 == batch.SampleCount && Timer::INVALID_HANDLE == batch_timer_handle) {
+            batch_timer_handle = Timer::AddOneShotEvent(BATCH_MAX_AGE, batch_timer_callback);
+        }
+        return true;
+    }
+    // 只放入发件箱，持有互斥锁期间不等待网络，避免阻塞等待该锁的定时器调度任务
+    flush(true);
+    return true;
+}
+
+void MQTT::batch_timer_callback(void *)
+{
+    // 设置临界区
+    mutex.Lock();
+    batch_timer_handle = Timer::INVALID_HANDLE;
+    // 在定时器调度任务中执行，只放入发件箱，不等待网络
+    flush(true);
+    // 退出临界区
+    mutex.Unlock();
+}
+
+void MQTT::flush(const bool enqueue)
+{
+    // 调用者已设置临界区
+    if (Timer::INVALID_HANDLE != batch_timer_handle) {
+        Timer::Del(batch_timer_handle);
+        batch_timer_handle = Timer::INVALID_HANDLE;
+    }
+    if (0 == batch.SampleCount) {
+        return;
+    }
+    Message message = std::move(batch);
+    batch = {"", 0};
+    if (!connected) {
+        buffer(message);
+        return;
+    }
+    // 先按顺序补发断开期间缓存的消息
+    while (!offline_messages.empty()) {
+        if (!send(offline_messages.front(), enqueue)) {
+            buffer(message);
+            return;
+        }
+        offline_bytes -= offline_messages.front().Payload.length();
+        offline_messages.pop_front();
+    }
+    portENTER_CRITICAL(&spinlock);
+    statistics.Buffered = 0;
+    statistics.BufferedBytes = 0;
+    portEXIT_CRITICAL(&spinlock);
+    if (!send(message, enqueue)) {
+        buffer(message);
+        return;
+    }
+    // 保留消息只需要最新的一条，即批次的最后一行，失败时不重发
+    if (retain) {
+        auto position = message.Payload.rfind('\n');
+        auto latest = (std::string::npos == position) ? message.Payload : message.Payload.substr(position + 1);
+        if (enqueue) {
+            esp_mqtt_client_enqueue(client, latest_topic.c_str(), latest.c_str(), latest.length(), 0, 1, true);
+        } else {
+            esp_mqtt_client_publish(client, latest_topic.c_str(), latest.c_str(), latest.length(), 0, 1);
+        }
+    }
+}
+
+MQTT::Statistics MQTT::GetStatistics()
+{
+    Statistics result;
+    portENTER_CRITICAL(&spinlock);
+    result = statistics;
+    portEXIT_CRITICAL(&spinlock);
+    result.Elapsed = esp_timer_get_time() - start_timestamp;
+    return result;
+}
+
+void MQTT::LogStatistics()
+{
+    auto result = GetStatistics();
+    ESP_LOGI(LOG_TAG, "samples %lu, messages %lu, acknowledged %lu, dropped %lu, buffered %lu (%lu B), connect %lu",
+             result.Samples, result.Messages, result.Acknowledged, result.Dropped,
+             result.Buffered, result.BufferedBytes, result.ConnectCount);
+    if (0 == result.Samples || result.Elapsed <= 0) {
+        return;
+    }
+    ESP_LOGI(LOG_TAG, "%.3f messages/s, %llu bytes/sample",
+             result.Messages * 1000000.0 / result.Elapsed,
+             result.PayloadBytes / result.Samples);
+}
+
+void MQTT::event_handler(void *args, esp_event_base_t base, int32_t event_id, void *event_data)
+{
+    auto event = (esp_mqtt_event_handle_t)event_data;
+    switch ((esp_mqtt_event_id_t)event_id) {
+        case MQTT_EVENT_CONNECTED:
+            ESP_LOGI(LOG_TAG, "connected, session present %d", event->session_present);
+            connected = true;
+            portENTER_CRITICAL(&spinlock);
+            statistics.ConnectCount++;
+            portEXIT_CRITICAL(&spinlock);
+            break;
+        case MQTT_EVENT_DISCONNECTED:
+            ESP_LOGW(LOG_TAG, "disconnected");
+            connected = false;
+            break;
+        case MQTT_EVENT_PUBLISHED:
+            portENTER_CRITICAL(&spinlock);
+            statistics.Acknowledged++;
+            portEXIT_CRITICAL(&spinlock);
+            break;
+        case MQTT_EVENT_ERROR:
+            ESP_LOGE(LOG_TAG, "error");
+            break;
+        default:
+            break;
+    }
+}
+
+}
+
+}
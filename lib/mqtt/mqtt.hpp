@@ -0,0 +1,131 @@
+#ifndef _mqtt_hpp_
+#define _mqtt_hpp_
+
+#include <atomic>
+#include <deque>
+#include <string>
+
+#include "freertos/FreeRTOS.h"
+#include "esp_event.h"
+#include "mqtt_client.h"
+
+#include "mutex.hpp"
+#include "timer.hpp"
+
+namespace cubestone_wang 
+{
+
+namespace mqtt
+{
+
+/*
+  MQTT上传类
+  保持一个持久会话（QoS 1时不清除会话），采样以InfluxDB行协议编码，按批次合并为一条消息发布到{topic}/data，
+  同时可将最新一条以保留消息发布到{topic}/latest；断开期间的消息缓存在内存中，超出数量或字节数时丢弃最早的，
+  重新连接后在下一次发布时按顺序补发；未满的批次在BATCH_MAX_AGE后或停止时发布，不会一直滞留
+*/
+class MQTT
+{
+    public:
+        // 日志标签
+        static const char *const LOG_TAG;
+        // 断开期间最多缓存的消息数
+        static const size_t OFFLINE_BUFFER_SIZE = 32;
+        // 断开期间最多缓存的字节数（消息内容），批次较大时以此为准
+        static const size_t OFFLINE_BUFFER_BYTES = 16384;
+        // 批次中第一个采样加入后最长等待时间（毫秒），超时后不等批次满直接发布
+        static const uint32_t BATCH_MAX_AGE = 30000;
+        // 统计结果
+        struct Statistics {
+            uint32_t Samples;           // 已发布的采样数
+            uint32_t Messages;          // 已发布的消息数
+            uint32_t Acknowledged;      // 已确认的消息数（QoS 1）
+            uint32_t Dropped;           // 缓存已满或发布失败丢弃的采样数
+            uint32_t Buffered;          // 当前缓存的消息数
+            uint32_t BufferedBytes;     // 当前缓存的字节数
+            uint32_t ConnectCount;
+            uint64_t PayloadBytes;      // 已发布的数据消息长度之和
+            int64_t Elapsed;            // 启动后的时间（微秒）
+        };
+        /**
+         * @brief 启动，不等待连接完成
+         *
+         * @param uri 服务器地址，例如mqtt://broker.local:1883
+         * @param client_id 客户端ID，为空时由客户端按MAC地址生成
+         * @param username 用户名，可为空
+         * @param password 密码，可为空
+         * @param topic 主题前缀
+         * @param qos 0或1
+         * @param retain 是否发布保留的最新数据
+         * @param batch_size 每条消息包含的采样数
+         * @param keepalive 心跳间隔（秒）
+         */
+        static bool Start(const std::string &uri,
+                          const std::string &client_id,
+                          const std::string &username,
+                          const std::string &password,
+                          const std::string &topic,
+                          const uint8_t qos=1,
+                          const bool retain=true,
+                          const uint8_t batch_size=1,
+                          const uint16_t keepalive=60);
+        // 停止前发布未满的批次，未连接时留在缓存中
+        static void Stop();
+        /**
+         * @brief 是否已连接
+         */
+        static bool IsConnected();
+        /**
+         * @brief 加入当前批次，达到批次大小时放入发件箱由MQTT任务发送（不等待网络），启动前或未连接时缓存
+         *
+         * @param line 一条行协议数据
+         * @return 发布失败且无法缓存时返回false
+         */
+        static bool Publish(const std::string &line);
+        /**
+         * @brief 获取统计结果
+         */
+        static Statistics GetStatistics();
+        /**
+         * @brief 输出每秒消息数及每个采样的字节数
+         */
+        static void LogStatistics();
+    private:
+        struct Message {
+            std::string Payload;
+            uint8_t SampleCount;
+        };
+        static sync::Mutex mutex;
+        static esp_mqtt_client_handle_t client;
+        // 客户端保存配置中字符串的指针，需在运行期间保持有效
+        static std::string uri;
+        static std::string client_id;
+        static std::string username;
+        static std::string password;
+        static std::string data_topic;
+        static std::string latest_topic;
+        static uint8_t qos;
+        static bool retain;
+        static uint8_t batch_size;
+        // 当前批次
+        static Message batch;
+        static timer::Timer::Handle_t batch_timer_handle;
+        static std::deque<Message> offline_messages;
+        static size_t offline_bytes;
+        static std::atomic<bool> connected;
+        // 保护统计数据，事件回调运行在MQTT任务中
+        static portMUX_TYPE spinlock;
+        static Statistics statistics;
+        static int64_t start_timestamp;
+        static bool send(const Message &message, const bool enqueue);
+        static void buffer(Message &message);
+        static void flush(const bool enqueue);
+        static void batch_timer_callback(void *);
+        static void event_handler(void *args, esp_event_base_t base, int32_t event_id, void *event_data);
+};
+
+}
+
+}
+
+#endif // _mqtt_hpp_
@@ -0,0 +1,233 @@
+#include "cJSON.h"
+#include "esp_log.h"
+
+#include "mqtt_config.hpp"
+
+namespace cubestone_wang 
+{
+
+namespace mqtt
+{
+
+// 二进制格式的字段号
+enum Field : uint8_t {
+    FIELD_ENABLE = 1,
+    FIELD_URI = 2,
+    FIELD_CLIENT_ID = 3,
+    FIELD_USERNAME = 4,
+    FIELD_PASSWORD = 5,
+    FIELD_TOPIC = 6,
+    FIELD_QOS = 7,
+    FIELD_RETAIN = 8,
+    FIELD_BATCH_SIZE = 9,
+    FIELD_KEEPALIVE = 10,
+};
+
+const char *const Config::LOG_TAG = "MQTT_CONFIG";
+const std::string Config::default_topic = "sensor";
+const uint8_t Config::default_qos = 1;
+const bool Config::default_retain = true;
+const uint8_t Config::default_batch_size = 1;
+const uint16_t Config::default_keepalive = 60;
+
+void Config::Reset()
+{
+    Enable = false;
+    URI = "";
+    ClientID = "";
+    Username = "";
+    Password = "";
+    Topic = default_topic;
+    QoS = default_qos;
+    Retain = default_retain;
+    BatchSize = default_batch_size;
+    Keepalive = default_keepalive;
+}
+
+std::string Config::Dump() const
+{
+    cJSON *json_root = cJSON_CreateObject();
+    cJSON_AddBoolToObject(json_root, "enable", Enable);
+    cJSON_AddStringToObject(json_root, "uri", URI.c_str());
+    cJSON_AddStringToObject(json_root, "client_id", ClientID.c_str());
+    cJSON_AddStringToObject(json_root, "username", Username.c_str());
+    cJSON_AddStringToObject(json_root, "password", Password.c_str());
+    cJSON_AddStringToObject(json_root, "topic", Topic.c_str());
+    cJSON_AddNumberToObject(json_root, "qos", QoS);
+    cJSON_AddBoolToObject(json_root, "retain", Retain);
+    cJSON_AddNumberToObject(json_root, "batch_size", BatchSize);
+    cJSON_AddNumberToObject(json_root, "keepalive", Keepalive);
+    char *json_data = cJSON_PrintUnformatted(json_root);
+    std::string result = std::string(json_data);
+    cJSON_free(json_data);
+    cJSON_Delete(json_root); 
+    return result;
+}
+
+bool Config::Load(const char *const config_data)
+{
+    Reset();
+    if (nullptr == config_data) {
+        return true;
+    }
+    cJSON *json_root = cJSON_Parse(config_data);
+    if (NULL == json_root) {   
+        return true;
+    }
+    // 字符串字段，未设置时保持默认值
+    const struct {
+        const char *Name;
+        std::string *Value;
+    } string_items[] = {
+        {"uri", &URI},
+        {"client_id", &ClientID},
+        {"username", &Username},
+        {"password", &Password},
+        {"topic", &Topic},
+    };
+    cJSON *json_item;
+    json_item = cJSON_GetObjectItem(json_root, "enable");
+    if (NULL != json_item) {
+        if (!cJSON_IsBool(json_item)) {
+            ESP_LOGE(LOG_TAG, "enable error");
+            cJSON_Delete(json_root); 
+            return false;
+        }
+        Enable = cJSON_IsTrue(json_item);
+    }
+    for (auto &string_item : string_items) {
+        json_item = cJSON_GetObjectItem(json_root, string_item.Name);
+        if (NULL == json_item) {
+            continue;
+        }
+        if (cJSON_String != json_item->type) {
+            ESP_LOGE(LOG_TAG, "%s error", string_item.Name);
+            cJSON_Delete(json_root); 
+            return false;
+        }
+        *string_item.Value = json_item->valuestring;
+    }
+    json_item = cJSON_GetObjectItem(json_root, "qos");
+    if (NULL != json_item) {
+        if (cJSON_Number != json_item->type || json_item->valueint < 0 || json_item->valueint > 1) {
+            ESP_LOGE(LOG_TAG, "qos error");
+            cJSON_Delete(json_root); 
+            return false;
+        }
+        QoS = (uint8_t)json_item->valueint;
+    }
+    json_item = cJSON_GetObjectItem(json_root, "retain");
+    if (NULL != json_item) {
+        if (!cJSON_IsBool(json_item)) {
+            ESP_LOGE(LOG_TAG, "retain error");
+            cJSON_Delete(json_root); 
+            return false;
+        }
+        Retain = cJSON_IsTrue(json_item);
+    }
+    json_item = cJSON_GetObjectItem(json_root, "batch_size");
+    if (NULL != json_item) {
+        if (cJSON_Number != json_item->type || json_item->valueint < 1 || json_item->valueint > 255) {
+            ESP_LOGE(LOG_TAG, "batch_size error");
+            cJSON_Delete(json_root); 
+            return false;
+        }
+        BatchSize = (uint8_t)json_item->valueint;
+    }
+    json_item = cJSON_GetObjectItem(json_root, "keepalive");
+    if (NULL != json_item) {
+        if (cJSON_Number != json_item->type) {
+            ESP_LOGE(LOG_TAG, "keepalive error");
+            cJSON_Delete(json_root); 
+            return false;
+        }
+        Keepalive = (uint16_t)json_item->valueint;
+    }
+    cJSON_Delete(json_root); 
+    return true;
+}
+
+bool Config::Load(const std::string &config_data)
+{
+    if ("" == config_data) {
+        return Load(nullptr);
+    } else {
+        return Load(config_data.c_str());
+    }
+}
+
+config::BaseConfig *Config::Clone() const
+{
+    return new Config(*this);
+}
+
+void Config::Encode(config::BinaryEncoder &encoder) const
+{
+    encoder.WriteUInt(FIELD_ENABLE, Enable ? 1 : 0);
+    encoder.WriteString(FIELD_URI, URI);
+    encoder.WriteString(FIELD_CLIENT_ID, ClientID);
+    encoder.WriteString(FIELD_USERNAME, Username);
+    encoder.WriteString(FIELD_PASSWORD, Password);
+    encoder.WriteString(FIELD_TOPIC, Topic);
+    encoder.WriteUInt(FIELD_QOS, QoS);
+    encoder.WriteUInt(FIELD_RETAIN, Retain ? 1 : 0);
+    encoder.WriteUInt(FIELD_BATCH_SIZE, BatchSize);
+    encoder.WriteUInt(FIELD_KEEPALIVE, Keepalive);
+}
+
+bool Config::Decode(config::BinaryDecoder &decoder, const uint8_t schema_version)
+{
+    uint32_t value;
+    bool result;
+    while (decoder.Next()) {
+        switch (decoder.GetField()) {
+            case FIELD_ENABLE:
+                result = decoder.GetUInt(value);
+                Enable = (0 != value);
+                break;
+            case FIELD_URI:
+                result = decoder.GetString(URI);
+                break;
+            case FIELD_CLIENT_ID:
+                result = decoder.GetString(ClientID);
+                break;
+            case FIELD_USERNAME:
+                result = decoder.GetString(Username);
+                break;
+            case FIELD_PASSWORD:
+                result = decoder.GetString(Password);
+                break;
+            case FIELD_TOPIC:
+                result = decoder.GetString(Topic);
+                break;
+            case FIELD_QOS:
+                result = decoder.GetUInt(value);
+                QoS = (uint8_t)value;
+                break;
+            case FIELD_RETAIN:
+                result = decoder.GetUInt(value);
+                Retain = (0 != value);
+                break;
+            case FIELD_BATCH_SIZE:
+                result = decoder.GetUInt(value);
+                BatchSize = (uint8_t)value;
+                break;
+            case FIELD_KEEPALIVE:
+                result = decoder.GetUInt(value);
+                Keepalive = (uint16_t)value;
+                break;
+            default:
+                result = true;
+                break;
+        }
+        if (false == result) {
+            ESP_LOGE(LOG_TAG, "field %u error", decoder.GetField());
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+}
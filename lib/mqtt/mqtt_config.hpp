@@ -0,0 +1,56 @@
+#ifndef _mqtt_config_hpp_
+#define _mqtt_config_hpp_
+
+#include <string>
+
+#include "base_config.hpp"
+
+namespace cubestone_wang 
+{
+
+namespace mqtt
+{
+
+class Config: public config::BaseConfig
+{
+    public:
+        // 日志标签
+        static const char *const LOG_TAG;
+        void Reset();
+        std::string Dump() const;
+        bool Load(const char *const config_data);
+        bool Load(const std::string &config_data);
+        void Encode(config::BinaryEncoder &encoder) const;
+        config::BaseConfig *Clone() const;
+        bool Decode(config::BinaryDecoder &decoder, const uint8_t schema_version);
+        // 是否使用MQTT代替InfluxDB上传
+        bool Enable;
+        // 例如mqtt://broker.local:1883
+        std::string URI;
+        // 为空时由客户端按MAC地址生成
+        std::string ClientID;
+        std::string Username;
+        std::string Password;
+        // 数据发布到{Topic}/data，最新一条保留在{Topic}/latest
+        std::string Topic;
+        // 0或1
+        uint8_t QoS;
+        // 是否发布保留的最新数据
+        bool Retain;
+        // 每条消息包含的采样数
+        uint8_t BatchSize;
+        // 秒
+        uint16_t Keepalive;
+    private:
+        static const std::string default_topic;
+        static const uint8_t default_qos;
+        static const bool default_retain;
+        static const uint8_t default_batch_size;
+        static const uint16_t default_keepalive;
+};
+
+}
+
+}
+
+#endif // _mqtt_config_hpp_
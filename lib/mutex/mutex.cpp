@@ -0,0 +1,213 @@
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "mutex.hpp"
+
+namespace cubestone_wang
+{
+
+namespace sync
+{
+
+const char *const Mutex::LOG_TAG = "MUTEX";
+
+#if MUTEX_STATISTICS_ENABLE
+
+Mutex *Mutex::head = nullptr;
+
+SemaphoreHandle_t Mutex::list_mutex()
+{
+    // 互斥锁多为其他文件中的静态成员，链表的锁在首次使用时创建，避免初始化顺序问题
+    static SemaphoreHandle_t mutex = xSemaphoreCreateMutex();
+    return mutex;
+}
+
+Mutex::Mutex(const std::string &name, const bool recursive)
+    : name(name), recursive(recursive), next(nullptr), depth(0), lock_timestamp(0),
+      lock_count(0), contention_count(0), total_wait_time(0), max_wait_time(0), total_hold_time(0), max_hold_time(0)
+{
+    portMUX_INITIALIZE(&spinlock);
+    handle = recursive ? xSemaphoreCreateRecursiveMutex() : xSemaphoreCreateMutex();
+    // 设置临界区
+    xSemaphoreTake(list_mutex(), portMAX_DELAY);
+    next = head;
+    head = this;
+    // 退出临界区
+    xSemaphoreGive(list_mutex());
+}
+
+Mutex::~Mutex()
+{
+    // 设置临界区
+    xSemaphoreTake(list_mutex(), portMAX_DELAY);
+    for (Mutex **iter = &head; nullptr != *iter; iter = &(*iter)->next) {
+        if (this == *iter) {
+            *iter = next;
+            break;
+        }
+    }
+    // 退出临界区
+    xSemaphoreGive(list_mutex());
+    vSemaphoreDelete(handle);
+}
+
+void Mutex::Lock()
+{
+    int64_t start_timestamp = esp_timer_get_time();
+    bool contended = false;
+    if (recursive) {
+        if (pdTRUE != xSemaphoreTakeRecursive(handle, 0)) {
+            contended = true;
+            xSemaphoreTakeRecursive(handle, portMAX_DELAY);
+        }
+    } else {
+        if (pdTRUE != xSemaphoreTake(handle, 0)) {
+            contended = true;
+            xSemaphoreTake(handle, portMAX_DELAY);
+        }
+    }
+    if (++depth > 1) {
+        return;
+    }
+    lock_timestamp = esp_timer_get_time();
+    uint32_t wait_time = (uint32_t)(lock_timestamp - start_timestamp);
+    portENTER_CRITICAL(&spinlock);
+    lock_count++;
+    if (contended) {
+        contention_count++;
+    }
+    total_wait_time += wait_time;
+    if (wait_time > max_wait_time) {
+        max_wait_time = wait_time;
+    }
+    portEXIT_CRITICAL(&spinlock);
+}
+
+void Mutex::Unlock()
+{
+    if (0 == --depth) {
+        uint32_t hold_time = (uint32_t)(esp_timer_get_time() - lock_timestamp);
+        portENTER_CRITICAL(&spinlock);
+        total_hold_time += hold_time;
+        if (hold_time > max_hold_time) {
+            max_hold_time = hold_time;
+        }
+        portEXIT_CRITICAL(&spinlock);
+    }
+    if (recursive) {
+        xSemaphoreGiveRecursive(handle);
+    } else {
+        xSemaphoreGive(handle);
+    }
+}
+
+std::vector<Mutex::Statistics> Mutex::GetStatistics()
+{
+    std::vector<Statistics> statistics_list;
+    // 设置临界区
+    xSemaphoreTake(list_mutex(), portMAX_DELAY);
+    for (Mutex *mutex = head; nullptr != mutex; mutex = mutex->next) {
+        Statistics statistics;
+        statistics.Name = mutex->name;
+        portENTER_CRITICAL(&mutex->spinlock);
+        statistics.LockCount = mutex->lock_count;
+        statistics.ContentionCount = mutex->contention_count;
+        statistics.TotalWaitTime = mutex->total_wait_time;
+        statistics.MaxWaitTime = mutex->max_wait_time;
+        statistics.TotalHoldTime = mutex->total_hold_time;
+        statistics.MaxHoldTime = mutex->max_hold_time;
+        portEXIT_CRITICAL(&mutex->spinlock);
+        statistics_list.push_back(statistics);
+    }
+    // 退出临界区
+    xSemaphoreGive(list_mutex());
+    return statistics_list;
+}
+
+void Mutex::LogStatistics()
+{
+    auto statistics_list = GetStatistics();
+    ESP_LOGI(LOG_TAG, "            name     count  contended  avg wait  max wait  avg hold  max hold (us)");
+    for (auto &statistics : statistics_list) {
+        if (0 == statistics.LockCount) {
+            continue;
+        }
+        ESP_LOGI(LOG_TAG, "%16s  %8lu  %9lu  %8llu  %8lu  %8llu  %8lu",
+                 statistics.Name.c_str(),
+                 statistics.LockCount,
+                 statistics.ContentionCount,
+                 statistics.TotalWaitTime / statistics.LockCount,
+                 statistics.MaxWaitTime,
+                 statistics.TotalHoldTime / statistics.LockCount,
+                 statistics.MaxHoldTime);
+    }
+}
+
+void Mutex::ResetStatistics()
+{
+    // 设置临界区
+    xSemaphoreTake(list_mutex(), portMAX_DELAY);
+    for (Mutex *mutex = head; nullptr != mutex; mutex = mutex->next) {
+        portENTER_CRITICAL(&mutex->spinlock);
+        mutex->lock_count = 0;
+        mutex->contention_count = 0;
+        mutex->total_wait_time = 0;
+        mutex->max_wait_time = 0;
+        mutex->total_hold_time = 0;
+        mutex->max_hold_time = 0;
+        portEXIT_CRITICAL(&mutex->spinlock);
+    }
+    // 退出临界区
+    xSemaphoreGive(list_mutex());
+}
+
+#else
+
+Mutex::Mutex(const std::string &name, const bool recursive)
+    : name(name), recursive(recursive)
+{
+    handle = recursive ? xSemaphoreCreateRecursiveMutex() : xSemaphoreCreateMutex();
+}
+
+Mutex::~Mutex()
+{
+    vSemaphoreDelete(handle);
+}
+
+void Mutex::Lock()
+{
+    if (recursive) {
+        xSemaphoreTakeRecursive(handle, portMAX_DELAY);
+    } else {
+        xSemaphoreTake(handle, portMAX_DELAY);
+    }
+}
+
+void Mutex::Unlock()
+{
+    if (recursive) {
+        xSemaphoreGiveRecursive(handle);
+    } else {
+        xSemaphoreGive(handle);
+    }
+}
+
+std::vector<Mutex::Statistics> Mutex::GetStatistics()
+{
+    return std::vector<Statistics>();
+}
+
+void Mutex::LogStatistics()
+{
+    ESP_LOGI(LOG_TAG, "statistics is disabled, build with MUTEX_STATISTICS_ENABLE=1");
+}
+
+void Mutex::ResetStatistics()
+{
+}
+
+#endif
+
+}
+
+}
@@ -0,0 +1,119 @@
+#ifndef _mutex_hpp_
+#define _mutex_hpp_
+
+#include <string>
+#include <vector>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+// 是否统计互斥锁的获取次数、等待时间及持有时间，可在build_flags中以-DMUTEX_STATISTICS_ENABLE=0关闭
+#ifndef MUTEX_STATISTICS_ENABLE
+#define MUTEX_STATISTICS_ENABLE 1
+#endif
+
+namespace cubestone_wang
+{
+
+namespace sync
+{
+
+/*
+  互斥锁类
+  封装FreeRTOS互斥锁，开启统计时记录每个锁的获取次数、竞争次数、总/最大等待时间及总/最大持有时间（微秒），
+  所有实例登记在同一链表中，可统一输出；关闭统计时仅为xSemaphoreTake/xSemaphoreGive
+  递归锁只在最外层计算等待及持有时间
+*/
+class Mutex
+{
+    public:
+        // 统计结果
+        struct Statistics {
+            std::string Name;
+            uint32_t LockCount;         // 获取次数（最外层）
+            uint32_t ContentionCount;   // 获取时已被其他任务持有的次数
+            uint64_t TotalWaitTime;     // 微秒
+            uint32_t MaxWaitTime;       // 微秒
+            uint64_t TotalHoldTime;     // 微秒
+            uint32_t MaxHoldTime;       // 微秒
+        };
+        // 日志标签
+        static const char *const LOG_TAG;
+        /**
+         * @brief 构造
+         *
+         * @param name 名称，用于输出统计结果
+         * @param recursive 是否为递归锁
+         */
+        explicit Mutex(const std::string &name, const bool recursive=false);
+        ~Mutex();
+        Mutex(const Mutex &) = delete;
+        Mutex &operator=(const Mutex &) = delete;
+        /**
+         * @brief 获取，一直等待
+         */
+        void Lock();
+        /**
+         * @brief 释放
+         */
+        void Unlock();
+        /**
+         * @brief 获取所有互斥锁的统计结果
+         */
+        static std::vector<Statistics> GetStatistics();
+        /**
+         * @brief 输出所有互斥锁的统计结果
+         */
+        static void LogStatistics();
+        /**
+         * @brief 清零所有互斥锁的统计结果
+         */
+        static void ResetStatistics();
+    private:
+        std::string name;
+        bool recursive;
+        SemaphoreHandle_t handle;
+#if MUTEX_STATISTICS_ENABLE
+        static SemaphoreHandle_t list_mutex();
+        static Mutex *head;
+        Mutex *next;
+        // 保护统计数据
+        portMUX_TYPE spinlock;
+        // 递归深度及最外层获取的时间，只由持有者访问
+        uint32_t depth;
+        int64_t lock_timestamp;
+        uint32_t lock_count;
+        uint32_t contention_count;
+        uint64_t total_wait_time;
+        uint32_t max_wait_time;
+        uint64_t total_hold_time;
+        uint32_t max_hold_time;
+#endif
+};
+
+/*
+  作用域锁
+  构造时获取，析构时释放
+*/
+class LockGuard
+{
+    public:
+        explicit LockGuard(Mutex &mutex) : mutex(mutex)
+        {
+            this->mutex.Lock();
+        }
+        ~LockGuard()
+        {
+            this->mutex.Unlock();
+        }
+        LockGuard(const LockGuard &) = delete;
+        LockGuard &operator=(const LockGuard &) = delete;
+    private:
+        Mutex &mutex;
+};
+
+}
+
+}
+
+#endif // _mutex_hpp_
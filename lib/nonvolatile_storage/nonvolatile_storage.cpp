@@ -13,19 +13,25 @@ namespace nonvolatile_storage
 
 const char *const NonvolatileStorage::LOG_TAG = "NVS";
 
-SemaphoreHandle_t NonvolatileStorage::mutex = xSemaphoreCreateMutex();
+sync::Mutex NonvolatileStorage::mutex("nvs");
 
 bool NonvolatileStorage::init_flag = false;
 
+std::map<std::string, nvs_handle_t> NonvolatileStorage::handles;
+
+bool NonvolatileStorage::cache_enable = false;
+
+std::map<std::string, std::string> NonvolatileStorage::cache;
+
 void NonvolatileStorage::Init() 
 {
     // 判断是否已经执行过 
     // 设置临界区
-    xSemaphoreTake(mutex, portMAX_DELAY);
+    mutex.Lock();
     if (init_flag == true) {
         ESP_LOGD(LOG_TAG, " it have been inited");
         // 退出临界区
-        xSemaphoreGive(mutex);return;
+        mutex.Unlock();return;
     }
     init_flag = true;
     // 初始化数据
@@ -37,24 +43,59 @@ void NonvolatileStorage::Init()
     }
     ESP_ERROR_CHECK(ret);
     // 退出临界区
-    xSemaphoreGive(mutex);
+    mutex.Unlock();
     return;
 }
 
-std::string NonvolatileStorage::ReadString(const std::string &ns, const std::string &key)
+nvs_handle_t NonvolatileStorage::get_handle(const std::string &ns)
 {
+    // 调用者已设置临界区
+    auto iter = handles.find(ns);
+    if (iter != handles.end()) {
+        return iter->second;
+    }
     nvs_handle_t handle;
+    ESP_ERROR_CHECK(nvs_open(ns.c_str(), NVS_READWRITE, &handle));
+    handles[ns] = handle;
+    return handle;
+}
+
+std::string NonvolatileStorage::get_cache_key(const std::string &ns, const std::string &key)
+{
+    return ns + "/" + key;
+}
+
+void NonvolatileStorage::SetCacheEnable(const bool enable)
+{
+    // 设置临界区
+    mutex.Lock();
+    cache_enable = enable;
+    if (false == enable) {
+        cache.clear();
+    }
+    // 退出临界区
+    mutex.Unlock();
+}
+
+std::string NonvolatileStorage::ReadString(const std::string &ns, const std::string &key)
+{
     std::string result;
-    uint32_t buffer_tmp_length;
-    size_t buffer_length;
-    char *buffer;
-    auto key_len = key + "_l";
+    size_t length = 0;
     esp_err_t err;
+    nvs_handle_t handle;
     NonvolatileStorage::Init();
     // 设置临界区
-    xSemaphoreTake(mutex, portMAX_DELAY);
-    ESP_ERROR_CHECK(nvs_open(ns.c_str(), NVS_READWRITE, &handle));
-    err = nvs_get_u32(handle, key_len.c_str(), &buffer_tmp_length);
+    mutex.Lock();
+    if (cache_enable) {
+        auto iter = cache.find(get_cache_key(ns, key));
+        if (iter != cache.end()) {
+            result = iter->second;
+            goto DONE;
+        }
+    }
+    handle = get_handle(ns);
+    // 直接查询长度（含结束符），不再读取单独保存的长度
+    err = nvs_get_str(handle, key.c_str(), nullptr, &length);
     if (ESP_OK != err) {
         if (ESP_ERR_NVS_NOT_FOUND != err) {
             ESP_LOGE(NonvolatileStorage::LOG_TAG, 
@@ -63,81 +104,203 @@ std::string NonvolatileStorage::ReadString(const std::string &ns, const std::str
         }
         goto DONE;
     }
-    buffer_length = (size_t)buffer_tmp_length;
-    ESP_LOGD(LOG_TAG, "read length: %d", buffer_length);
-    buffer = new char[buffer_length];
-    memset(buffer, 0, sizeof(char) * buffer_length); 
-    err = nvs_get_str(handle, key.c_str(), buffer, &buffer_length);
+    result.resize(length);
+    err = nvs_get_str(handle, key.c_str(), &result[0], &length);
+    if (ESP_OK != err) {
+        ESP_LOGE(NonvolatileStorage::LOG_TAG, 
+                 "error code->%d",
+                 err);
+        result.clear();
+        goto DONE;
+    }
+    // 去掉结束符
+    result.resize(length - 1);
+    ESP_LOGD(LOG_TAG, "read content: %s", result.c_str());
+    if (cache_enable) {
+        cache[get_cache_key(ns, key)] = result;
+    }
+DONE:
+    // 退出临界区
+    mutex.Unlock();
+    return result;
+}
+
+bool NonvolatileStorage::WriteString(const std::string &ns, const std::string &key, const char *const value)
+{
+    bool result = true;
+    nvs_handle_t handle;
+    esp_err_t err;
+    NonvolatileStorage::Init();
+    if (NVS_KEY_NAME_MAX_SIZE <= key.length()) {
+        ESP_LOGE(NonvolatileStorage::LOG_TAG, 
+                 "key(%s) >= max key size(%d)",
+                 key.c_str(),
+                 NVS_KEY_NAME_MAX_SIZE);
+        result = false;
+        return result;
+    }
+    // 设置临界区
+    mutex.Lock();
+    handle = get_handle(ns);
+    err = nvs_set_str(handle, key.c_str(), value);
+    if (ESP_OK != err) {
+        ESP_LOGE(NonvolatileStorage::LOG_TAG, 
+                 "error code->%d",
+                 err);
+        result = false;
+        cache.erase(get_cache_key(ns, key));
+        goto DONE;
+    }
+    // 删除旧版本保存的长度，不存在时不访问flash
+    nvs_erase_key(handle, (key + "_l").c_str());
+    ESP_ERROR_CHECK(nvs_commit(handle));
+    ESP_LOGD(LOG_TAG, "write content: %s", value);
+    if (cache_enable) {
+        cache[get_cache_key(ns, key)] = value;
+    }
+DONE:
+    // 退出临界区
+    mutex.Unlock();
+    return result;
+}
+
+bool NonvolatileStorage::WriteString(const std::string &ns, const std::string &key, const std::string &value)
+{
+    return NonvolatileStorage::WriteString(ns, key, value.c_str());
+}
+
+bool NonvolatileStorage::ReadBlob(const std::string &ns, const std::string &key, std::string &value)
+{
+    bool result = false;
+    nvs_handle_t handle;
+    size_t length = 0;
+    esp_err_t err;
+    NonvolatileStorage::Init();
+    // 设置临界区
+    mutex.Lock();
+    if (cache_enable) {
+        auto iter = cache.find(get_cache_key(ns, key));
+        if (iter != cache.end()) {
+            value = iter->second;
+            result = true;
+            goto DONE;
+        }
+    }
+    handle = get_handle(ns);
+    err = nvs_get_blob(handle, key.c_str(), nullptr, &length);
     if (ESP_OK != err) {
         if (ESP_ERR_NVS_NOT_FOUND != err) {
             ESP_LOGE(NonvolatileStorage::LOG_TAG, 
                      "error code->%d",
                      err);
         }
-        delete[] buffer;
         goto DONE;
     }
-    ESP_LOGD(LOG_TAG, "read content: %s", buffer);
-    result = std::string(buffer);
-    delete[] buffer;
+    value.resize(length);
+    err = nvs_get_blob(handle, key.c_str(), &value[0], &length);
+    if (ESP_OK != err) {
+        ESP_LOGE(NonvolatileStorage::LOG_TAG, 
+                 "error code->%d",
+                 err);
+        value.clear();
+        goto DONE;
+    }
+    ESP_LOGD(LOG_TAG, "read blob length: %d", length);
+    if (cache_enable) {
+        cache[get_cache_key(ns, key)] = value;
+    }
+    result = true;
 DONE:
-    nvs_close(handle);
     // 退出临界区
-    xSemaphoreGive(mutex);
+    mutex.Unlock();
     return result;
 }
 
-bool NonvolatileStorage::WriteString(const std::string &ns, const std::string &key, const char *const value)
+bool NonvolatileStorage::WriteBlob(const std::string &ns, const std::string &key, const std::string &value, const bool commit)
 {
     bool result = true;
     nvs_handle_t handle;
     esp_err_t err;
-    auto key_len = key + "_l";
     NonvolatileStorage::Init();
     if (NVS_KEY_NAME_MAX_SIZE <= key.length()) {
         ESP_LOGE(NonvolatileStorage::LOG_TAG, 
                  "key(%s) >= max key size(%d)",
                  key.c_str(),
                  NVS_KEY_NAME_MAX_SIZE);
-        result = false;
-        return result;
+        return false;
     }
     // 设置临界区
-    xSemaphoreTake(mutex, portMAX_DELAY);
-    ESP_ERROR_CHECK(nvs_open(ns.c_str(), NVS_READWRITE, &handle));
-    err = nvs_erase_key(handle, key_len.c_str());
-    if (ESP_OK != err && ESP_ERR_NVS_NOT_FOUND != err) {
+    mutex.Lock();
+    handle = get_handle(ns);
+    err = nvs_set_blob(handle, key.c_str(), value.data(), value.length());
+    if (ESP_OK != err) {
         ESP_LOGE(NonvolatileStorage::LOG_TAG, 
                  "error code->%d",
                  err);
         result = false;
+        cache.erase(get_cache_key(ns, key));
         goto DONE;
     }
+    if (commit) {
+        ESP_ERROR_CHECK(nvs_commit(handle));
+    }
+    ESP_LOGD(LOG_TAG, "write blob length: %d", value.length());
+    if (cache_enable) {
+        cache[get_cache_key(ns, key)] = value;
+    }
+DONE:
+    // 退出临界区
+    mutex.Unlock();
+    return result;
+}
+
+bool NonvolatileStorage::Commit(const std::string &ns)
+{
+    bool result = true;
+    esp_err_t err;
+    NonvolatileStorage::Init();
+    // 设置临界区
+    mutex.Lock();
+    err = nvs_commit(get_handle(ns));
+    if (ESP_OK != err) {
+        ESP_LOGE(NonvolatileStorage::LOG_TAG, 
+                 "error code->%d",
+                 err);
+        result = false;
+    }
+    // 退出临界区
+    mutex.Unlock();
+    return result;
+}
+
+bool NonvolatileStorage::Erase(const std::string &ns, const std::string &key)
+{
+    bool result = true;
+    nvs_handle_t handle;
+    esp_err_t err;
+    NonvolatileStorage::Init();
+    // 设置临界区
+    mutex.Lock();
+    cache.erase(get_cache_key(ns, key));
+    handle = get_handle(ns);
     err = nvs_erase_key(handle, key.c_str());
-    if (ESP_OK != err && ESP_ERR_NVS_NOT_FOUND != err) {
+    if (ESP_ERR_NVS_NOT_FOUND == err) {
+        goto DONE;
+    }
+    if (ESP_OK != err) {
         ESP_LOGE(NonvolatileStorage::LOG_TAG, 
                  "error code->%d",
                  err);
         result = false;
         goto DONE;
     }
-    ESP_ERROR_CHECK(nvs_set_u32(handle, key_len.c_str(), (uint32_t)(strlen(value)+1)));
-    ESP_ERROR_CHECK(nvs_set_str(handle, key.c_str(), value));
     ESP_ERROR_CHECK(nvs_commit(handle));
-    ESP_LOGD(LOG_TAG, "write length: %lu", (uint32_t)(strlen(value)+1));
-    ESP_LOGD(LOG_TAG, "write content: %s", value);
 DONE:
-    nvs_close(handle);
     // 退出临界区
-    xSemaphoreGive(mutex);
+    mutex.Unlock();
     return result;
 }
 
-bool NonvolatileStorage::WriteString(const std::string &ns, const std::string &key, const std::string &value)
-{
-    return NonvolatileStorage::WriteString(ns, key, value.c_str());
-}
-
 }
 
 }
@@ -1,10 +1,14 @@
 #ifndef _nonvolatile_storage_hpp_
 #define _nonvolatile_storage_hpp_
 
+#include <map>
 #include <string>
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
+#include "nvs.h"
+
+#include "mutex.hpp"
 
 namespace cubestone_wang 
 {
@@ -12,7 +16,11 @@ namespace cubestone_wang
 namespace nonvolatile_storage 
 {
 
-// 非易失存储类
+/*
+  非易失存储类
+  每个命名空间只打开一次并保持打开，每个值只占一个条目，读取时直接查询长度；
+  可开启RAM缓存，命中时不访问flash
+*/
 class NonvolatileStorage
 {
     public:
@@ -22,12 +30,56 @@ class NonvolatileStorage
         static void Init();
         // 日志标签
         static const char *const LOG_TAG;
+        /**
+         * @brief 开启或关闭读取缓存，关闭时清空
+         *
+         * @param enable 是否开启
+         */
+        static void SetCacheEnable(const bool enable);
         static std::string ReadString(const std::string &ns, const std::string &key);
         static bool WriteString(const std::string &ns, const std::string &key, const char *const value);
         static bool WriteString(const std::string &ns, const std::string &key, const std::string &value);
+        /**
+         * @brief 读取二进制数据
+         *
+         * @param ns 命名空间
+         * @param key 键
+         * @param value 数据
+         * @return 不存在或读取失败时返回false
+         */
+        static bool ReadBlob(const std::string &ns, const std::string &key, std::string &value);
+        /**
+         * @brief 写入二进制数据
+         *
+         * @param ns 命名空间
+         * @param key 键
+         * @param value 数据
+         * @param commit 是否立即提交，批量写入时可在最后调用Commit
+         */
+        static bool WriteBlob(const std::string &ns, const std::string &key, const std::string &value, const bool commit=true);
+        /**
+         * @brief 提交命名空间中未提交的写入
+         *
+         * @param ns 命名空间
+         */
+        static bool Commit(const std::string &ns);
+        /**
+         * @brief 删除键，键不存在时也返回true
+         *
+         * @param ns 命名空间
+         * @param key 键
+         */
+        static bool Erase(const std::string &ns, const std::string &key);
     private:
         static bool init_flag;
-        static SemaphoreHandle_t mutex;
+        static sync::Mutex mutex;
+        static nvs_handle_t get_handle(const std::string &ns);
+        static std::string get_cache_key(const std::string &ns, const std::string &key);
+        // 已打开的命名空间
+        static std::map<std::string, nvs_handle_t> handles;
+        static bool cache_enable;
+        // 键为 命名空间/键
+        static std::map<std::string, std::string> cache;
 };
 
 }
@@ -1,8 +1,14 @@
 #define SNTP_STARTUP_DELAY 0
+#include <string.h>
+#include <sys/time.h>
+
 #include "esp_log.h"
 #include "esp_sntp.h"
+#include "esp_timer.h"
 
+#include "nonvolatile_storage.hpp"
 #include "system.hpp"
+#include "timer.hpp"
 
 #include "ntp.hpp"
 
@@ -12,24 +18,152 @@ namespace cubestone_wang
 namespace ntp 
 {
 
+using namespace nonvolatile_storage;
 using namespace system;
+using namespace timer;
 
 const char *const NTP::LOG_TAG = "NTP";
 
+const char *const NTP::nvs_namespace = "NTP";
+const char *const NTP::record_key = "last_sync";
+
+const EventBits_t NTP::SYNC_BIT = BIT0;
+
+const int64_t NTP::MIN_DRIFT_INTERVAL = 600LL * 1000 * 1000;
+
 bool NTP::start_flag = false;
 
-SemaphoreHandle_t NTP::mutex = xSemaphoreCreateMutex();
+sync::Mutex NTP::mutex(LOG_TAG);
+
+EventGroupHandle_t NTP::event_group = xEventGroupCreate();
 
 std::vector<std::string *> NTP::server_name_list;
 
-bool NTP::Start(const std::vector<std::string> &server_name_list, const uint32_t wait_time)
+portMUX_TYPE NTP::spinlock = portMUX_INITIALIZER_UNLOCKED;
+
+bool NTP::synced = false;
+
+bool NTP::estimated = false;
+
+int64_t NTP::sync_epoch = 0;
+
+int64_t NTP::sync_uptime = 0;
+
+int32_t NTP::drift = 0;
+
+Timer::CallbackFunction_t NTP::first_sync_callback = nullptr;
+
+void *NTP::first_sync_callback_args = nullptr;
+
+void NTP::sync_callback(struct timeval *tv)
+{
+    int64_t uptime = esp_timer_get_time();
+    int64_t epoch = (int64_t)tv->tv_sec * 1000000 + tv->tv_usec;
+    int64_t offset = 0;
+    bool first = false;
+    Timer::CallbackFunction_t callback = nullptr;
+    void *callback_args = nullptr;
+    portENTER_CRITICAL(&spinlock);
+    if (true == synced) {
+        // 与上次同步后按本地时钟推算的时间比较
+        offset = epoch - (sync_epoch + (uptime - sync_uptime));
+        if (uptime - sync_uptime >= MIN_DRIFT_INTERVAL) {
+            drift = (int32_t)(offset * 1000000000LL / (uptime - sync_uptime));
+        }
+    } else {
+        first = true;
+        callback = first_sync_callback;
+        callback_args = first_sync_callback_args;
+    }
+    synced = true;
+    estimated = false;
+    sync_epoch = epoch;
+    sync_uptime = uptime;
+    portEXIT_CRITICAL(&spinlock);
+    xEventGroupSetBits(event_group, SYNC_BIT);
+    if (true == first) {
+        ESP_LOGI(LOG_TAG, "sync done, the current date/time is: %s", System::GetCurrentTimeStandardString().c_str());
+    } else {
+        ESP_LOGD(LOG_TAG, "sync done, offset: %lld us, drift: %ld ppb", offset, drift);
+    }
+    // 回调运行在lwIP任务中，由定时器任务写入NVS
+    Timer::Post(save_record);
+    if (nullptr != callback && !Timer::Post(callback, callback_args)) {
+        ESP_LOGE(LOG_TAG, "post first sync callback failed");
+    }
+}
+
+void NTP::SetFirstSyncCallbackFunction(const Timer::CallbackFunction_t func, void *args)
+{
+    portENTER_CRITICAL(&spinlock);
+    first_sync_callback = func;
+    first_sync_callback_args = args;
+    portEXIT_CRITICAL(&spinlock);
+}
+
+void NTP::save_record(void *args)
+{
+    Record record;
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    if (now.tv_sec < MIN_VALID_TIMESTAMP) {
+        return;
+    }
+    record.Epoch = (int64_t)now.tv_sec * 1000000 + now.tv_usec;
+    portENTER_CRITICAL(&spinlock);
+    record.Drift = drift;
+    portEXIT_CRITICAL(&spinlock);
+    NonvolatileStorage::WriteBlob(nvs_namespace, record_key, std::string((const char *)&record, sizeof(record)));
+}
+
+bool NTP::RestoreTime()
+{
+    Record record;
+    std::string data;
+    struct timeval now;
+    int64_t epoch;
+    bool has_record = NonvolatileStorage::ReadBlob(nvs_namespace, record_key, data) && sizeof(record) == data.length();
+    if (true == has_record) {
+        memcpy(&record, data.data(), sizeof(record));
+    }
+    gettimeofday(&now, NULL);
+    epoch = (int64_t)now.tv_sec * 1000000 + now.tv_usec;
+    if (now.tv_sec >= MIN_VALID_TIMESTAMP) {
+        // 软件重启后RTC时间仍在运行，按上次测得的漂移修正
+        if (true == has_record && epoch > record.Epoch) {
+            epoch += (epoch - record.Epoch) * record.Drift / 1000000000LL;
+        }
+    } else if (true == has_record) {
+        // 断电期间的时间无法得知，从上次保存的时间继续
+        epoch = record.Epoch;
+    } else {
+        ESP_LOGW(LOG_TAG, "no time to restore");
+        return false;
+    }
+    now.tv_sec = epoch / 1000000;
+    now.tv_usec = epoch % 1000000;
+    settimeofday(&now, NULL);
+    // 将时区设置为中国标准时间
+    setenv("TZ", "CST-8", 1);
+    tzset();
+    portENTER_CRITICAL(&spinlock);
+    if (false == synced) {
+        estimated = true;
+    }
+    if (true == has_record) {
+        drift = record.Drift;
+    }
+    portEXIT_CRITICAL(&spinlock);
+    ESP_LOGI(LOG_TAG, "restore estimated date/time: %s", System::GetCurrentTimeStandardString().c_str());
+    return true;
+}
+
+bool NTP::Start(const std::vector<std::string> &server_name_list)
 {
     // 设置临界区
     bool result = false;
-    sntp_sync_status_t status;
-    uint32_t current_time;
     uint8_t index;
-    xSemaphoreTake(mutex, portMAX_DELAY);
+    mutex.Lock();
     if (start_flag == true) {
         ESP_LOGI(LOG_TAG, "this has been started");
         result = false;
@@ -49,58 +183,91 @@ bool NTP::Start(const std::vector<std::string> &server_name_list, const uint32_t
     // 将时区设置为中国标准时间
     setenv("TZ", "CST-8", 1);
     tzset();
-    sntp_set_sync_mode(SNTP_SYNC_MODE_IMMED);
+    // 首次同步直接设置，估计的时间可能相差较大；之后逐渐调整
+    sntp_set_sync_mode(IsSynced() ? SNTP_SYNC_MODE_SMOOTH : SNTP_SYNC_MODE_IMMED);
+    sntp_set_time_sync_notification_cb([](struct timeval *tv) {
+        sntp_set_sync_mode(SNTP_SYNC_MODE_SMOOTH);
+        sync_callback(tv);
+    });
     sntp_setoperatingmode(SNTP_OPMODE_POLL);
     sntp_init();
-    current_time = esp_log_timestamp();
-    while (true) { 
-        status = sntp_get_sync_status();
-        if (SNTP_SYNC_STATUS_COMPLETED != status) {
-            if (esp_log_timestamp() > (current_time + wait_time * 1000)) {
-                result = false;
-                ESP_LOGE(LOG_TAG, "sync failed");
-                break;
-            } else {
-                System::Sleep(100);
-            }
-        } else {
-            result = true;
-            ESP_LOGD(LOG_TAG, "sync done");
-            break;
-        }
-    }
-    sntp_set_sync_mode(SNTP_SYNC_MODE_SMOOTH);
+    result = true;
+    ESP_LOGD(LOG_TAG, "sync in background");
 DONE:
     // 退出临界区
-    xSemaphoreGive(mutex);
-    if (!result) {
-        NTP::Stop();
-    }
+    mutex.Unlock();
     return result;
 }
 
 void NTP::Stop()
 {
     uint8_t index;
-    xSemaphoreTake(mutex, portMAX_DELAY);
+    mutex.Lock();
     if (start_flag == false) { 
         ESP_LOGD(LOG_TAG, "this has been stopped");
         goto DONE;
     }
     sntp_stop();
+    sntp_set_time_sync_notification_cb(NULL);
     for (index=0; index<NTP::server_name_list.size(); index++) {
         sntp_setservername(index, NULL);
         delete NTP::server_name_list[index];
         NTP::server_name_list[index] = nullptr;
     }
     NTP::server_name_list.clear();
+    // 重启前保存，断电后可从该时间继续
+    if (IsSynced()) {
+        save_record(nullptr);
+    }
 DONE:
     start_flag = false;
     // 退出临界区
-    xSemaphoreGive(mutex);
+    mutex.Unlock();
     return;
 }
 
+bool NTP::WaitForSync(const uint32_t timeout)
+{
+    TickType_t ticks = portMAX_DELAY == timeout ? portMAX_DELAY : pdMS_TO_TICKS(timeout);
+    EventBits_t bits = xEventGroupWaitBits(event_group, SYNC_BIT, pdFALSE, pdTRUE, ticks);
+    return 0 != (bits & SYNC_BIT);
+}
+
+bool NTP::IsSynced()
+{
+    bool result;
+    portENTER_CRITICAL(&spinlock);
+    result = synced;
+    portEXIT_CRITICAL(&spinlock);
+    return result;
+}
+
+bool NTP::IsEstimated()
+{
+    bool result;
+    portENTER_CRITICAL(&spinlock);
+    result = estimated;
+    portEXIT_CRITICAL(&spinlock);
+    return result;
+}
+
+time_t NTP::ToTimestamp(const int64_t uptime)
+{
+    int64_t epoch;
+    bool result;
+    portENTER_CRITICAL(&spinlock);
+    result = synced;
+    epoch = sync_epoch + (uptime - sync_uptime);
+    portEXIT_CRITICAL(&spinlock);
+    if (false == result) {
+        // 尚未同步时按当前的系统时间推算
+        struct timeval now;
+        gettimeofday(&now, NULL);
+        epoch = (int64_t)now.tv_sec * 1000000 + now.tv_usec - (esp_timer_get_time() - uptime);
+    }
+    return epoch / 1000000;
+}
+
 }
 
 }
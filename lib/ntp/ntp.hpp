@@ -5,7 +5,10 @@
 #include <vector>
 
 #include "freertos/FreeRTOS.h"
-#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+
+#include "mutex.hpp"
+#include "timer.hpp"
 
 namespace cubestone_wang 
 {
@@ -13,25 +16,89 @@ namespace cubestone_wang
 namespace ntp 
 {
 
+/*
+  NTP类
+  启动后在后台同步，不等待；每次同步后将当前时间及测得的时钟漂移保存到NVS，
+  启动时先由RestoreTime恢复估计的时间，同步完成前的时间均视为估计值
+*/
 class NTP
 {
     public:
+        // 早于该时间的时间戳视为无效（2020-01-01 00:00:00 UTC）
+        static const time_t MIN_VALID_TIMESTAMP = 1577836800;
         // 日志标签
         static const char *const LOG_TAG;
         /**
-         * @brief 启动
-         *
-         * @param wait_time 等待时间（秒）
+         * @brief 启动，不等待同步完成
          */
-        static bool Start(const std::vector<std::string> &server_name_list, const uint32_t wait_time=30);
+        static bool Start(const std::vector<std::string> &server_name_list);
         /**
-         * @brief 停止
+         * @brief 停止，保存当前时间
          */
         static void Stop();
+        /**
+         * @brief 恢复估计的时间
+         * 软件重启后RTC时间仍然有效，按漂移修正；断电后从上次保存的时间继续
+         *
+         * @return 是否得到有效的时间
+         */
+        static bool RestoreTime();
+        /**
+         * @brief 等待同步完成
+         *
+         * @param timeout 超时时间（毫秒）
+         */
+        static bool WaitForSync(const uint32_t timeout=portMAX_DELAY);
+        /**
+         * @brief 是否已同步
+         */
+        static bool IsSynced();
+        /**
+         * @brief 当前时间是否为尚未同步的估计值
+         */
+        static bool IsEstimated();
+        /**
+         * @brief 将启动后的时间换算为时间戳，同步后换算结果随之修正
+         *
+         * @param uptime 启动后的时间（微秒），即esp_timer_get_time()
+         * @return 时间戳（秒）
+         */
+        static time_t ToTimestamp(const int64_t uptime);
+        /**
+         * @brief 设置第一次同步完成后的回调函数，在定时器任务中执行
+         * 用于按估计的时间计算的定时在同步后重新计算
+         *
+         * @param func 回调函数，为nullptr时取消
+         * @param args 回调函数参数
+         */
+        static void SetFirstSyncCallbackFunction(const timer::Timer::CallbackFunction_t func, void *args=nullptr);
     private:
+        // 保存在NVS中的时间
+        struct Record {
+            int64_t Epoch;      // 保存时的时间（微秒）
+            int32_t Drift;      // 时钟漂移（ppb），正数表示本地时钟偏慢
+        };
+        static const char *const nvs_namespace;
+        static const char *const record_key;
+        static const EventBits_t SYNC_BIT;
+        // 两次同步间隔不小于该值（微秒）时才计算漂移，避免误差过大
+        static const int64_t MIN_DRIFT_INTERVAL;
         static bool start_flag;
-        static SemaphoreHandle_t mutex;
+        static sync::Mutex mutex;
+        static EventGroupHandle_t event_group;
         static std::vector<std::string *> server_name_list;
+        // 保护以下同步状态，同步回调运行在lwIP任务中
+        static portMUX_TYPE spinlock;
+        static bool synced;
+        static bool estimated;
+        // 上次同步时的NTP时间及启动后的时间（微秒）
+        static int64_t sync_epoch;
+        static int64_t sync_uptime;
+        static int32_t drift;
+        static timer::Timer::CallbackFunction_t first_sync_callback;
+        static void *first_sync_callback_args;
+        static void sync_callback(struct timeval *tv);
+        static void save_record(void *args);
 };
 
 }
@@ -11,6 +11,13 @@ namespace cubestone_wang
 namespace ntp
 {
 
+// 二进制格式的字段号
+enum Field : uint8_t {
+    FIELD_SERVER_NAME_LIST = 1,
+    // 列表中的每一项
+    FIELD_ITEM = 1,
+};
+
 const char *const Config::LOG_TAG = "NTP_CONFIG";
 
 void Config::Reset()
@@ -21,7 +28,7 @@ void Config::Reset()
     ServerNameList.push_back("ntp1.aliyun.com");
 }
 
-std::string Config::Dump()
+std::string Config::Dump() const
 {
     cJSON *json_root = cJSON_CreateObject();
     cJSON *json_item;
@@ -81,6 +88,51 @@ bool Config::Load(const std::string &config_data)
     }
 }
 
+config::BaseConfig *Config::Clone() const
+{
+    return new Config(*this);
+}
+
+void Config::Encode(config::BinaryEncoder &encoder) const
+{
+    config::BinaryEncoder list_encoder;
+    for (auto &server_name : ServerNameList) {
+        list_encoder.WriteString(FIELD_ITEM, server_name);
+    }
+    encoder.WriteMessage(FIELD_SERVER_NAME_LIST, list_encoder);
+}
+
+bool Config::Decode(config::BinaryDecoder &decoder, const uint8_t schema_version)
+{
+    config::BinaryDecoder list_decoder(nullptr, 0);
+    std::string server_name;
+    while (decoder.Next()) {
+        switch (decoder.GetField()) {
+            case FIELD_SERVER_NAME_LIST:
+                if (false == decoder.GetMessage(list_decoder)) {
+                    ESP_LOGE(LOG_TAG, "server_name_list error");
+                    return false;
+                }
+                ServerNameList.clear();
+                while (list_decoder.Next()) {
+                    if (FIELD_ITEM != list_decoder.GetField() || false == list_decoder.GetString(server_name)) {
+                        ESP_LOGE(LOG_TAG, "server_name_list %d error", ServerNameList.size());
+                        return false;
+                    }
+                    ServerNameList.push_back(server_name);
+                }
+                if (list_decoder.IsError()) {
+                    ESP_LOGE(LOG_TAG, "server_name_list error");
+                    return false;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    return true;
+}
+
 }
 
 }
@@ -0,0 +1,189 @@
+#include <string.h>
+#include <vector>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "lwip/netdb.h"
+#include "lwip/sockets.h"
+
+#include "task_placement.hpp"
+
+#include "resolver.hpp"
+
+namespace cubestone_wang
+{
+
+namespace resolver
+{
+
+const char *const Resolver::LOG_TAG = "RESOLVER";
+
+sync::Mutex Resolver::mutex(LOG_TAG);
+
+std::map<std::string, Resolver::Entry> Resolver::entries;
+
+TaskHandle_t Resolver::task_handler = nullptr;
+
+bool Resolver::lookup(const std::string &host, std::string &address)
+{
+    struct addrinfo hint;
+    struct addrinfo *res = NULL;
+    char buffer[INET_ADDRSTRLEN] = {0};
+    memset(&hint, 0, sizeof(hint));
+    // URL中的IPv6地址需加方括号，统一使用IPv4
+    hint.ai_family = AF_INET;
+    int64_t start_timestamp = esp_timer_get_time();
+    if (0 != getaddrinfo(host.c_str(), NULL, &hint, &res) || NULL == res) {
+        ESP_LOGW(LOG_TAG, "unknown domain %s", host.c_str());
+        return false;
+    }
+    inet_ntop(AF_INET, &((struct sockaddr_in *)res->ai_addr)->sin_addr, buffer, sizeof(buffer));
+    freeaddrinfo(res);
+    address = buffer;
+    ESP_LOGD(LOG_TAG, "%s -> %s, %lld ms", host.c_str(), buffer, (esp_timer_get_time() - start_timestamp) / 1000);
+    return true;
+}
+
+void Resolver::update(const std::string &host, const bool valid, const std::string &address)
+{
+    int64_t now = esp_timer_get_time();
+    // 设置临界区
+    mutex.Lock();
+    auto &entry = entries[host];
+    if (true == valid) {
+        entry.Address = address;
+        entry.Valid = true;
+        entry.ExpireTimestamp = now + TTL * 1000LL;
+    } else if (true == entry.Valid) {
+        // 后台刷新失败时保留旧地址，稍后重试
+        entry.ExpireTimestamp = now + NEGATIVE_TTL * 1000LL;
+    } else {
+        entry.Address = "";
+        entry.Valid = false;
+        entry.ExpireTimestamp = now + NEGATIVE_TTL * 1000LL;
+    }
+    if (0 == entry.LastUsedTimestamp) {
+        entry.LastUsedTimestamp = now;
+    }
+    // 退出临界区
+    mutex.Unlock();
+}
+
+void Resolver::start_task()
+{
+    // 调用者已设置临界区
+    if (nullptr != task_handler) {
+        return;
+    }
+    if (!task_placement::TaskPlacement::Create(task_placement::TaskPlacement::TaskType::RESOLVER,
+                                               run_task,
+                                               nullptr,
+                                               &task_handler)) {
+        task_handler = nullptr;
+    }
+}
+
+void Resolver::run_task(void *args)
+{
+    std::vector<std::string> hosts;
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(REFRESH_INTERVAL));
+        int64_t now = esp_timer_get_time();
+        hosts.clear();
+        // 设置临界区
+        mutex.Lock();
+        for (auto iter = entries.begin(); iter != entries.end();) {
+            auto &entry = iter->second;
+            if (now - entry.LastUsedTimestamp > IDLE_TIME * 1000LL) {
+                ESP_LOGD(LOG_TAG, "%s is idle, remove", iter->first.c_str());
+                iter = entries.erase(iter);
+                continue;
+            }
+            // 只刷新成功过的记录，失败的记录过期后由调用者重新解析
+            if (true == entry.Valid && entry.ExpireTimestamp - REFRESH_AHEAD * 1000LL <= now) {
+                hosts.push_back(iter->first);
+            }
+            iter++;
+        }
+        // 退出临界区
+        mutex.Unlock();
+        // 解析可能耗时数秒，不持有锁
+        for (auto &host : hosts) {
+            std::string address;
+            bool valid = lookup(host, address);
+            update(host, valid, address);
+        }
+    }
+}
+
+bool Resolver::Resolve(const std::string &host, std::string &address)
+{
+    struct in_addr addr4;
+    bool result = false;
+    bool found = false;
+    int64_t now = esp_timer_get_time();
+    if (1 == inet_pton(AF_INET, host.c_str(), &addr4)) {
+        address = host;
+        return true;
+    }
+    // 设置临界区
+    mutex.Lock();
+    start_task();
+    auto iter = entries.find(host);
+    if (iter != entries.end()) {
+        auto &entry = iter->second;
+        // 过期但有旧地址时先使用旧地址，由后台任务刷新
+        if (now < entry.ExpireTimestamp || true == entry.Valid) {
+            found = true;
+            result = entry.Valid;
+            address = entry.Address;
+            entry.LastUsedTimestamp = now;
+            if (now >= entry.ExpireTimestamp && nullptr != task_handler) {
+                xTaskNotifyGive(task_handler);
+            }
+        }
+    }
+    // 退出临界区
+    mutex.Unlock();
+    if (true == found) {
+        return result;
+    }
+    result = lookup(host, address);
+    update(host, result, address);
+    return result;
+}
+
+void Resolver::Refresh(const std::string &host)
+{
+    // 设置临界区
+    mutex.Lock();
+    auto iter = entries.find(host);
+    if (iter != entries.end()) {
+        iter->second.ExpireTimestamp = 0;
+        if (nullptr != task_handler) {
+            xTaskNotifyGive(task_handler);
+        }
+    }
+    // 退出临界区
+    mutex.Unlock();
+}
+
+void Resolver::LogCache()
+{
+    int64_t now = esp_timer_get_time();
+    // 设置临界区
+    mutex.Lock();
+    ESP_LOGI(LOG_TAG, "                          host          address  expire(s)");
+    for (auto &iter : entries) {
+        ESP_LOGI(LOG_TAG, "%30s  %15s  %9lld",
+                 iter.first.c_str(),
+                 iter.second.Valid ? iter.second.Address.c_str() : "-",
+                 (iter.second.ExpireTimestamp - now) / 1000000);
+    }
+    // 退出临界区
+    mutex.Unlock();
+}
+
+}
+
+}
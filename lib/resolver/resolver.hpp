@@ -0,0 +1,76 @@
+#ifndef _resolver_hpp_
+#define _resolver_hpp_
+
+#include <map>
+#include <string>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "mutex.hpp"
+
+namespace cubestone_wang
+{
+
+namespace resolver
+{
+
+/*
+  域名解析缓存类
+  缓存域名（包括.local的mDNS名称）解析得到的IPv4地址，成功的结果保存TTL时间，失败的结果保存较短的时间，
+  避免每次请求都重新解析；最近使用过的域名在过期前由后台任务重新解析，过期但仍有旧地址时先返回旧地址，
+  因此只有首次解析会阻塞调用者
+*/
+class Resolver
+{
+    public:
+        // 成功结果的有效时间（毫秒）
+        static const uint32_t TTL = 300000;
+        // 失败结果的有效时间（毫秒）
+        static const uint32_t NEGATIVE_TTL = 30000;
+        // 日志标签
+        static const char *const LOG_TAG;
+        /**
+         * @brief 解析域名，IP地址直接返回
+         *
+         * @param host 域名或IPv4地址
+         * @param address 解析得到的IPv4地址
+         */
+        static bool Resolve(const std::string &host, std::string &address);
+        /**
+         * @brief 连接失败等情况下使缓存过期，由后台任务重新解析
+         *
+         * @param host 域名
+         */
+        static void Refresh(const std::string &host);
+        /**
+         * @brief 输出缓存内容
+         */
+        static void LogCache();
+    private:
+        struct Entry {
+            std::string Address;
+            bool Valid;                 // 是否解析成功
+            int64_t ExpireTimestamp;    // 微秒
+            int64_t LastUsedTimestamp;  // 微秒
+        };
+        // 后台检查的间隔（毫秒）
+        static const uint32_t REFRESH_INTERVAL = 10000;
+        // 在过期前该时间内重新解析（毫秒）
+        static const uint32_t REFRESH_AHEAD = 30000;
+        // 超过该时间未使用的记录不再刷新并被删除（毫秒）
+        static const uint32_t IDLE_TIME = 600000;
+        static sync::Mutex mutex;
+        static std::map<std::string, Entry> entries;
+        static TaskHandle_t task_handler;
+        static bool lookup(const std::string &host, std::string &address);
+        static void update(const std::string &host, const bool valid, const std::string &address);
+        static void start_task();
+        static void run_task(void *args);
+};
+
+}
+
+}
+
+#endif // _resolver_hpp_
@@ -24,17 +24,14 @@ SemaphoreHandle_t ScheduledRestart::mutex = xSemaphoreCreateMutex();
 
 const std::string ScheduledRestart::name = "scheduled_restart";
 
-bool ScheduledRestart::Start(const DayType day_type, const uint8_t hour, const uint8_t minute)
+ScheduledRestart::DayType ScheduledRestart::day_type = ScheduledRestart::DayType::RESTART_DAY_TYPE_EVERY_DAY;
+
+uint8_t ScheduledRestart::hour = 0;
+
+uint8_t ScheduledRestart::minute = 0;
+
+uint32_t ScheduledRestart::get_delay()
 {
-    // 判断是否已经启动  
-    // 设置临界区
-    xSemaphoreTake(mutex, portMAX_DELAY);
-    if (true == start_flag) {
-        ESP_LOGI(LOG_TAG, "this has been started");
-        // 退出临界区
-        xSemaphoreGive(mutex);
-        return false;
-    }
     // 计算延迟时间
     uint32_t delay = 0;
     auto current_time_info = System::GetCurrentTime();
@@ -69,13 +66,35 @@ bool ScheduledRestart::Start(const DayType day_type, const uint8_t hour, const u
         }
     }
     ESP_LOGD(LOG_TAG, "delay: %lu mintues", delay);
-    delay = delay * 60 * 1000;
-    if (Timer::AddOneShotEvent(name, 
-                               delay,
-                               [](void *args){
-                                  System::Restart("scheduled restart", 3); 
-                               },
-                               nullptr)) {
+    return delay * 60 * 1000;
+}
+
+bool ScheduledRestart::add_event()
+{
+    // 调用者已设置临界区
+    return Timer::AddOneShotEvent(name, 
+                                  get_delay(),
+                                  [](void *args){
+                                     System::Restart("scheduled restart", 3); 
+                                  },
+                                  nullptr);
+}
+
+bool ScheduledRestart::Start(const DayType day_type, const uint8_t hour, const uint8_t minute)
+{
+    // 判断是否已经启动  
+    // 设置临界区
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    if (true == start_flag) {
+        ESP_LOGI(LOG_TAG, "this has been started");
+        // 退出临界区
+        xSemaphoreGive(mutex);
+        return false;
+    }
+    ScheduledRestart::day_type = day_type;
+    ScheduledRestart::hour = hour;
+    ScheduledRestart::minute = minute;
+    if (add_event()) {
         start_flag = true;
         // 退出临界区
         xSemaphoreGive(mutex);
@@ -88,6 +107,27 @@ bool ScheduledRestart::Start(const DayType day_type, const uint8_t hour, const u
     }
 }
 
+bool ScheduledRestart::Reschedule()
+{
+    bool result = false;
+    // 设置临界区
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    if (false == start_flag) {
+        ESP_LOGD(LOG_TAG, "this has been stopped");
+        goto DONE;
+    }
+    Timer::Del(name);
+    result = add_event();
+    if (false == result) {
+        ESP_LOGE(LOG_TAG, "reschedule failed");
+        start_flag = false;
+    }
+DONE:
+    // 退出临界区
+    xSemaphoreGive(mutex);
+    return result;
+}
+
 void ScheduledRestart::Stop()
 {
     // 设置临界区
@@ -29,10 +29,20 @@ class ScheduledRestart
         static const char *const LOG_TAG;
         static bool Start(const DayType day_type, const uint8_t hour, const uint8_t minute);
         static void Stop();
+        /**
+         * @brief 按当前时间重新计算重启时间，用于时间同步后修正按估计的时间计算的结果
+         */
+        static bool Reschedule();
     private:
         static bool start_flag;
         static SemaphoreHandle_t mutex;
         static const std::string name;
+        static DayType day_type;
+        static uint8_t hour;
+        static uint8_t minute;
+        // 距下一次重启的时间（毫秒）
+        static uint32_t get_delay();
+        static bool add_event();
 };
 
 }
@@ -13,6 +13,13 @@ namespace scheduled_restart
 
 using namespace system;
 
+// 二进制格式的字段号
+enum Field : uint8_t {
+    FIELD_DAY_TYPE = 1,
+    FIELD_HOUR = 2,
+    FIELD_MINUTE = 3,
+};
+
 const char *const Config::LOG_TAG = "SCHEDULED_RESTART_CONFIG";
 
 const ScheduledRestart::DayType Config::default_day_type = ScheduledRestart::DayType::RESTART_DAY_TYPE_EVERY_DAY; 
@@ -26,7 +33,7 @@ void Config::Reset()
     Minute = default_minute;
 }
 
-std::string Config::Dump()
+std::string Config::Dump() const
 {
     cJSON *json_root = cJSON_CreateObject();
     cJSON_AddNumberToObject(json_root, "day_type", static_cast<uint32_t>(DayType));
@@ -95,6 +102,51 @@ bool Config::Load(const std::string &config_data)
     }
 }
 
+config::BaseConfig *Config::Clone() const
+{
+    return new Config(*this);
+}
+
+void Config::Encode(config::BinaryEncoder &encoder) const
+{
+    encoder.WriteUInt(FIELD_DAY_TYPE, static_cast<uint32_t>(DayType));
+    encoder.WriteUInt(FIELD_HOUR, Hour);
+    encoder.WriteUInt(FIELD_MINUTE, Minute);
+}
+
+bool Config::Decode(config::BinaryDecoder &decoder, const uint8_t schema_version)
+{
+    uint32_t value;
+    while (decoder.Next()) {
+        switch (decoder.GetField()) {
+            case FIELD_DAY_TYPE:
+                if (false == decoder.GetUInt(value)) {
+                    ESP_LOGE(LOG_TAG, "day_type error");
+                    return false;
+                }
+                DayType = (ScheduledRestart::DayType)value;
+                break;
+            case FIELD_HOUR:
+                if (false == decoder.GetUInt(value)) {
+                    ESP_LOGE(LOG_TAG, "hour error");
+                    return false;
+                }
+                Hour = (uint8_t)value;
+                break;
+            case FIELD_MINUTE:
+                if (false == decoder.GetUInt(value)) {
+                    ESP_LOGE(LOG_TAG, "minute error");
+                    return false;
+                }
+                Minute = (uint8_t)value;
+                break;
+            default:
+                break;
+        }
+    }
+    return true;
+}
+
 }
 
 }
@@ -19,9 +19,12 @@ class Config: public config::BaseConfig
         // 日志标签
         static const char *const LOG_TAG;
         void Reset();
-        std::string Dump();
+        std::string Dump() const;
         bool Load(const char *const config_data);
         bool Load(const std::string &config_data);
+        void Encode(config::BinaryEncoder &encoder) const;
+        config::BaseConfig *Clone() const;
+        bool Decode(config::BinaryDecoder &decoder, const uint8_t schema_version);
         ScheduledRestart::DayType DayType;
         uint8_t Hour;
         uint8_t Minute;
@@ -17,8 +17,8 @@ using namespace system;
 const char *const CM1106::LOG_TAG = "CM1106";
 
 CM1106::CM1106(gpio_num_t rx, gpio_num_t tx, uart_port_t uart_num)
+    : mutex(LOG_TAG)
 {
-    this->mutex = xSemaphoreCreateMutex();
     this->uart_num = uart_num;
     uart_config_t uart_config;
     uart_config.baud_rate = 9600;
@@ -42,7 +42,7 @@ uint16_t CM1106::GetPPM()
 {
     uint16_t result_data;
     // 设置临界区
-    xSemaphoreTake(this->mutex, portMAX_DELAY);
+    this->mutex.Lock();
     uart_flush(this->uart_num);
     uint8_t data[8] = {
         0x11, 0x01, 0x01, 0xed, 0x00, 0x00, 0x00, 0x00
@@ -51,7 +51,7 @@ uint16_t CM1106::GetPPM()
     System::Sleep(25);
     this->read(data, 8);
     // 退出临界区
-    xSemaphoreGive(this->mutex);
+    this->mutex.Unlock();
     char buf[8*3];
     for (auto i = 0; i < 8; i++) {
         sprintf(buf+i*3, "%02x%s", data[i], i != (8 -1) ? " " : "");
@@ -72,7 +72,7 @@ uint16_t CM1106::GetPPM()
 void CM1106::Calibrate(uint16_t ppm)
 {
     // 设置临界区
-    xSemaphoreTake(this->mutex, portMAX_DELAY);
+    this->mutex.Lock();
     uart_flush(this->uart_num);
     uint8_t data[6] = {
         0x11, 0x03, 0x03, 0x00, 0x00, 0x00
@@ -88,7 +88,7 @@ void CM1106::Calibrate(uint16_t ppm)
     this->write(data, 6);
     System::Sleep(25);
     this->read(data, 4);
-    xSemaphoreGive(this->mutex);
+    this->mutex.Unlock();
     if (!(data[0] == 0x16 && data[1] == 0x01 && data[2] == 0x03 && data[3] == 0xe6)) {
         ESP_ERROR_CHECK(ESP_ERR_INVALID_CRC);
     }
@@ -6,6 +6,8 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
 
+#include "mutex.hpp"
+
 namespace cubestone_wang 
 {
 
@@ -23,7 +25,7 @@ class CM1106
         uint16_t GetPPM();
         void Calibrate(uint16_t ppm=400);
     private:
-        SemaphoreHandle_t mutex;
+        sync::Mutex mutex;
         uart_port_t uart_num;
         void write(uint8_t* data, const uint32_t data_length);
         void read(uint8_t* data, const uint32_t data_length);
@@ -15,8 +15,8 @@ uint8_t PM2005::device_address = 0x28;
 
 
 PM2005::PM2005(I2cMaster* i2c_master)
+    : mutex(LOG_TAG)
 {
-    this->mutex = xSemaphoreCreateMutex();
     this->i2c_master = i2c_master;
     uint8_t data[7] = {
         0x16, 0x07, 0x05, 0x00, 0x24, 0x00, 0x00
@@ -32,10 +32,10 @@ PM2005::Data PM2005::GetData()
     result_data.PM10 = 0;
     result_data.PM25 = 0;
     // 设置临界区
-    xSemaphoreTake(this->mutex, portMAX_DELAY);
+    this->mutex.Lock();
     this->i2c_master->Read(this->device_address, data, 22);
     // 退出临界区
-    xSemaphoreGive(this->mutex);
+    this->mutex.Unlock();
     char buf[22*3];
     for (auto i = 0; i < 22; i++) {
         sprintf(buf+i*3, "%02x%s", data[i], i != (22 -1) ? " " : "");
@@ -5,6 +5,7 @@
 #include "freertos/semphr.h"
 
 #include "i2c_master.hpp"
+#include "mutex.hpp"
 
 namespace cubestone_wang 
 {
@@ -31,7 +32,7 @@ class PM2005
          */
         Data GetData();
     private:
-        SemaphoreHandle_t mutex;
+        sync::Mutex mutex;
         I2cMaster* i2c_master;
         static uint8_t device_address;
 };
@@ -19,8 +19,8 @@ const char *const SGP30::LOG_TAG = "SGP30";
 uint8_t SGP30::device_address = 0x58;
 
 SGP30::SGP30(I2cMaster* i2c_master)
+    : mutex(LOG_TAG)
 {
-    this->mutex = xSemaphoreCreateMutex();
     this->i2c_master = i2c_master;
     uint8_t data[2] = {
         0x20,
@@ -38,7 +38,7 @@ SGP30::Data SGP30::GetData(float temperature, float humidity)
        0x00, 0x00, 0x00, 0x00, 0x00, 0x00
     };
     // 设置临界区
-    xSemaphoreTake(this->mutex, portMAX_DELAY);
+    this->mutex.Lock();
     data[0] = 0x20;
     data[1] = 0x61;
     data[2] = uint8_t(std::floor(absolute_humidity));
@@ -52,7 +52,7 @@ SGP30::Data SGP30::GetData(float temperature, float humidity)
     System::Sleep(25);
     this->i2c_master->Read(this->device_address, data, 6);
     // 退出临界区
-    xSemaphoreGive(this->mutex);
+    this->mutex.Unlock();
     char buf[6*3];
     for (auto i = 0; i < 6; i++) {
         sprintf(buf+i*3, "%02x%s", data[i], i != (6 -1) ? " " : "");
@@ -73,12 +73,12 @@ SGP30::Baseline SGP30::GetBaseline()
        0x20, 0x15, 0x00, 0x00, 0x00, 0x00
     };
     // 设置临界区
-    xSemaphoreTake(this->mutex, portMAX_DELAY);
+    this->mutex.Lock();
     this->i2c_master->Write(this->device_address, data, 2);
     System::Sleep(25);
     this->i2c_master->Read(this->device_address, data, 6);
     // 退出临界区
-    xSemaphoreGive(this->mutex);
+    this->mutex.Unlock();
     char buf[6*3];
     for (auto i = 0; i < 6; i++) {
         sprintf(buf+i*3, "%02x%s", data[i], i != (6 -1) ? " " : "");
@@ -104,10 +104,10 @@ void SGP30::SetBaseline(Baseline baseline)
     data[6] = uint8_t(baseline.TVOC & 0xff);
     data[7] = crc(data[2], data[3]);
     // 设置临界区
-    xSemaphoreTake(this->mutex, portMAX_DELAY);
+    this->mutex.Lock();
     this->i2c_master->Write(this->device_address, data, 2);
     // 退出临界区
-    xSemaphoreGive(this->mutex);
+    this->mutex.Unlock();
     return;
 }
 
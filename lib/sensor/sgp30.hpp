@@ -5,6 +5,7 @@
 #include "freertos/semphr.h"
 
 #include "i2c_master.hpp"
+#include "mutex.hpp"
 
 namespace cubestone_wang 
 {
@@ -38,7 +39,7 @@ class SGP30
         Baseline GetBaseline();
         void SetBaseline(Baseline baseline);
     private:
-        SemaphoreHandle_t mutex;
+        sync::Mutex mutex;
         I2cMaster* i2c_master;
         static uint8_t device_address;
         uint8_t crc(uint8_t data1, uint8_t data2);
@@ -13,6 +13,12 @@ namespace sensor
 
 using namespace utils;
 
+// 二进制格式的字段号
+enum Field : uint8_t {
+    FIELD_CO2EQ = 1,
+    FIELD_TVOC = 2,
+};
+
 const char *const SGP30Config::LOG_TAG = "SGP30_CONFIG";
 const uint16_t SGP30Config::Default_CO2eq = 0;
 const uint16_t SGP30Config::Default_TVOC = 0;
@@ -23,7 +29,7 @@ void SGP30Config::Reset()
     TVOC = Default_TVOC;
 }
 
-std::string SGP30Config::Dump()
+std::string SGP30Config::Dump() const
 {
     cJSON *json_root = cJSON_CreateObject();
     cJSON_AddNumberToObject(json_root, "co2eq", CO2eq);	
@@ -80,6 +86,43 @@ bool SGP30Config::Load(const std::string &config_data)
     }
 }
 
+config::BaseConfig *SGP30Config::Clone() const
+{
+    return new SGP30Config(*this);
+}
+
+void SGP30Config::Encode(config::BinaryEncoder &encoder) const
+{
+    encoder.WriteUInt(FIELD_CO2EQ, CO2eq);
+    encoder.WriteUInt(FIELD_TVOC, TVOC);
+}
+
+bool SGP30Config::Decode(config::BinaryDecoder &decoder, const uint8_t schema_version)
+{
+    uint32_t value;
+    while (decoder.Next()) {
+        switch (decoder.GetField()) {
+            case FIELD_CO2EQ:
+                if (false == decoder.GetUInt(value)) {
+                    ESP_LOGE(LOG_TAG, "co2eq error");
+                    return false;
+                }
+                CO2eq = (uint16_t)value;
+                break;
+            case FIELD_TVOC:
+                if (false == decoder.GetUInt(value)) {
+                    ESP_LOGE(LOG_TAG, "tvoc error");
+                    return false;
+                }
+                TVOC = (uint16_t)value;
+                break;
+            default:
+                break;
+        }
+    }
+    return true;
+}
+
 }
 
 }
@@ -17,8 +17,8 @@ using namespace system;
 const char *const ZE08_CH2O::LOG_TAG = "ZE08_CH2O";
 
 ZE08_CH2O::ZE08_CH2O(gpio_num_t rx, gpio_num_t tx, uart_port_t uart_num)
+    : mutex(LOG_TAG)
 {
-    this->mutex = xSemaphoreCreateMutex();
     this->uart_num = uart_num;
     uart_config_t uart_config;
     uart_config.baud_rate = 9600;
@@ -46,7 +46,7 @@ ZE08_CH2O::Data ZE08_CH2O::GetData()
 {
     Data result_data;
     // 设置临界区
-    xSemaphoreTake(mutex, portMAX_DELAY);
+    mutex.Lock();
     uart_flush(this->uart_num);
     uint8_t data[9] = {
         0xff, 0x01, 0x86, 0x00, 0x00, 0x00, 0x00, 0x00, 0x79
@@ -55,7 +55,7 @@ ZE08_CH2O::Data ZE08_CH2O::GetData()
     System::Sleep(25);
     this->read(data, 9);
     // 退出临界区
-    xSemaphoreGive(this->mutex);
+    this->mutex.Unlock();
     char buf[9*3];
     for (auto i = 0; i < 9; i++) {
         sprintf(buf+i*3, "%02x%s", data[i], i != (9 -1) ? " " : "");
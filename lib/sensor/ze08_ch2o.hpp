@@ -6,6 +6,8 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
 
+#include "mutex.hpp"
+
 namespace cubestone_wang 
 {
 
@@ -27,7 +29,7 @@ class ZE08_CH2O
         ~ZE08_CH2O();
         Data GetData(); 
     private:
-        SemaphoreHandle_t mutex;
+        sync::Mutex mutex;
         uart_port_t uart_num;
         void write(uint8_t* data, const uint32_t data_length);
         void read(uint8_t* data, const uint32_t data_length);
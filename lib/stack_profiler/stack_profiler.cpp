@@ -0,0 +1,199 @@
+#include "esp_log.h"
+#include "sdkconfig.h"
+
+#include "system.hpp"
+#include "task_placement.hpp"
+
+#include "stack_profiler.hpp"
+
+namespace cubestone_wang
+{
+
+namespace stack_profiler
+{
+
+using namespace system;
+using namespace timer;
+
+// 推荐值按该粒度向上取整（字节）
+static const uint32_t STACK_DEPTH_ALIGNMENT = 256;
+
+const char *const StackProfiler::LOG_TAG = "STACK_PROFILER";
+
+bool StackProfiler::start_flag = false;
+
+uint32_t StackProfiler::margin = 512;
+
+uint32_t StackProfiler::warning_threshold = 512;
+
+Timer::Handle_t StackProfiler::timer_handle = Timer::INVALID_HANDLE;
+
+sync::Mutex StackProfiler::mutex(LOG_TAG);
+
+std::map<std::string, StackProfiler::Record> StackProfiler::records;
+
+bool StackProfiler::Start(const uint32_t interval, const uint32_t margin, const uint32_t warning_threshold)
+{
+    bool result = true;
+    // 设置临界区
+    mutex.Lock();
+    if (true == start_flag) {
+        ESP_LOGI(LOG_TAG, "this has been started");
+        result = false;
+        goto DONE;
+    }
+    StackProfiler::margin = margin;
+    StackProfiler::warning_threshold = warning_threshold;
+    timer_handle = Timer::AddPeriodicEvent(interval, sample);
+    if (Timer::INVALID_HANDLE == timer_handle) {
+        result = false;
+        goto DONE;
+    }
+    start_flag = true;
+DONE:
+    // 退出临界区
+    mutex.Unlock();
+    if (result) {
+        // 登记由配置决定栈大小的系统任务
+        Register("main", CONFIG_ESP_MAIN_TASK_STACK_SIZE);
+        Register("sys_evt", CONFIG_ESP_SYSTEM_EVENT_TASK_STACK_SIZE);
+        Register("esp_timer", CONFIG_ESP_TIMER_TASK_STACK_SIZE);
+        Register("ipc0", CONFIG_ESP_IPC_TASK_STACK_SIZE);
+        Register("ipc1", CONFIG_ESP_IPC_TASK_STACK_SIZE);
+        Register("IDLE", CONFIG_FREERTOS_IDLE_TASK_STACKSIZE);
+        Register("IDLE0", CONFIG_FREERTOS_IDLE_TASK_STACKSIZE);
+        Register("IDLE1", CONFIG_FREERTOS_IDLE_TASK_STACKSIZE);
+        Register("Tmr Svc", CONFIG_FREERTOS_TIMER_TASK_STACK_DEPTH);
+        Register("tiT", CONFIG_LWIP_TCPIP_TASK_STACK_SIZE);
+#ifdef CONFIG_MDNS_TASK_STACK_SIZE
+        Register("mdns", CONFIG_MDNS_TASK_STACK_SIZE);
+#endif
+        // 登记放置表中的任务
+        for (auto type = 0; type < static_cast<int>(task_placement::TaskPlacement::TaskType::MAX); type++) {
+            auto &placement = task_placement::TaskPlacement::Get(static_cast<task_placement::TaskPlacement::TaskType>(type));
+            Register(placement.Name, placement.StackDepth);
+        }
+        // 立即采样一次，尽早发现问题
+        Timer::Post(sample);
+    }
+    return result;
+}
+
+void StackProfiler::Stop()
+{
+    // 设置临界区
+    mutex.Lock();
+    if (false == start_flag) {
+        ESP_LOGD(LOG_TAG, "this has been stopped");
+        goto DONE;
+    }
+    Timer::Del(timer_handle);
+    timer_handle = Timer::INVALID_HANDLE;
+    start_flag = false;
+DONE:
+    // 退出临界区
+    mutex.Unlock();
+}
+
+void StackProfiler::Register(const std::string &task_name, const uint32_t stack_depth)
+{
+    // 设置临界区
+    mutex.Lock();
+    auto iter = records.find(task_name);
+    if (iter == records.end()) {
+        Record record = {};
+        record.Name = task_name;
+        record.MinFreeStack = UINT32_MAX;
+        iter = records.emplace(task_name, record).first;
+    }
+    iter->second.StackDepth = stack_depth;
+    // 退出临界区
+    mutex.Unlock();
+}
+
+void StackProfiler::Sample()
+{
+    sample(nullptr);
+}
+
+void StackProfiler::sample(void *)
+{
+    // 采样前获取，避免在临界区内分配内存
+    auto task_info_summary = System::GetCurrentTaskInfoSummary();
+    // 设置临界区
+    mutex.Lock();
+    for (auto &task_info : task_info_summary.TaskInfoList) {
+        auto iter = records.find(task_info.Name);
+        if (iter == records.end()) {
+            Record record = {};
+            record.Name = task_info.Name;
+            record.MinFreeStack = UINT32_MAX;
+            iter = records.emplace(task_info.Name, record).first;
+        }
+        auto &record = iter->second;
+        if (task_info.StackHighWaterMark >= record.MinFreeStack) {
+            continue;
+        }
+        record.MinFreeStack = task_info.StackHighWaterMark;
+        // 只在最小值下降时警告，避免重复输出
+        if (record.MinFreeStack < warning_threshold) {
+            ESP_LOGW(LOG_TAG, "%s stack is low, %lu B free, threshold %lu B",
+                     record.Name.c_str(), record.MinFreeStack, warning_threshold);
+        }
+    }
+    // 退出临界区
+    mutex.Unlock();
+}
+
+std::vector<StackProfiler::Record> StackProfiler::GetReport()
+{
+    std::vector<Record> report;
+    // 设置临界区
+    mutex.Lock();
+    for (auto iter = records.begin(); iter != records.end(); iter++) {
+        auto record = iter->second;
+        // 只登记未运行的任务不输出
+        if (UINT32_MAX == record.MinFreeStack) {
+            continue;
+        }
+        if (0 != record.StackDepth && record.StackDepth >= record.MinFreeStack) {
+            record.MaxUsedStack = record.StackDepth - record.MinFreeStack;
+            record.RecommendedStackDepth = (record.MaxUsedStack + margin + STACK_DEPTH_ALIGNMENT - 1)
+                                           / STACK_DEPTH_ALIGNMENT * STACK_DEPTH_ALIGNMENT;
+        } else {
+            record.MaxUsedStack = 0;
+            record.RecommendedStackDepth = 0;
+        }
+        report.push_back(record);
+    }
+    // 退出临界区
+    mutex.Unlock();
+    return report;
+}
+
+void StackProfiler::LogReport()
+{
+    auto report = GetReport();
+    int32_t reclaimable = 0;
+    ESP_LOGI(LOG_TAG, "            name   stack  min free    used  recommended");
+    for (auto &record : report) {
+        if (0 == record.StackDepth) {
+            ESP_LOGI(LOG_TAG, "%16s       -  %8lu       -            -",
+                     record.Name.c_str(),
+                     record.MinFreeStack);
+            continue;
+        }
+        ESP_LOGI(LOG_TAG, "%16s  %6lu  %8lu  %6lu  %11lu",
+                 record.Name.c_str(),
+                 record.StackDepth,
+                 record.MinFreeStack,
+                 record.MaxUsedStack,
+                 record.RecommendedStackDepth);
+        reclaimable += (int32_t)record.StackDepth - (int32_t)record.RecommendedStackDepth;
+    }
+    ESP_LOGI(LOG_TAG, "reclaimable with recommended sizes: %ld B", reclaimable);
+}
+
+}
+
+}
@@ -0,0 +1,85 @@
+#ifndef _stack_profiler_hpp_
+#define _stack_profiler_hpp_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "freertos/FreeRTOS.h"
+
+#include "mutex.hpp"
+#include "timer.hpp"
+
+namespace cubestone_wang
+{
+
+namespace stack_profiler
+{
+
+/*
+  任务栈分析类
+  周期性采样所有任务的栈高水位线并记录启动以来的最小值，低于阈值时输出警告，
+  根据已登记的栈大小给出推荐值（已使用 + 余量），用于安全地缩小各任务的栈
+  ESP-IDF中栈大小与高水位线的单位均为字节
+*/
+class StackProfiler
+{
+    public:
+        // 单个任务的统计结果
+        struct Record {
+            std::string Name;
+            uint32_t StackDepth;            // 登记的栈大小（字节），0表示未知
+            uint32_t MinFreeStack;          // 启动以来的最小剩余栈（字节）
+            uint32_t MaxUsedStack;          // 最大已使用栈（字节），栈大小未知时为0
+            uint32_t RecommendedStackDepth; // 推荐的栈大小（字节），栈大小未知时为0
+        };
+        // 日志标签
+        static const char *const LOG_TAG;
+        /**
+         * @brief 启动，由定时器周期性采样
+         *
+         * @param interval 采样间隔（毫秒）
+         * @param margin 推荐值在最大使用量之上保留的余量（字节）
+         * @param warning_threshold 剩余栈低于该值时警告（字节）
+         */
+        static bool Start(const uint32_t interval=10000,
+                          const uint32_t margin=512,
+                          const uint32_t warning_threshold=512);
+        /**
+         * @brief 停止
+         */
+        static void Stop();
+        /**
+         * @brief 登记任务的栈大小，用于计算使用量及推荐值
+         *
+         * @param task_name 任务名称
+         * @param stack_depth 栈大小（字节）
+         */
+        static void Register(const std::string &task_name, const uint32_t stack_depth);
+        /**
+         * @brief 立即采样一次
+         */
+        static void Sample();
+        /**
+         * @brief 获取统计结果，按任务名称排序
+         */
+        static std::vector<Record> GetReport();
+        /**
+         * @brief 输出统计结果
+         */
+        static void LogReport();
+    private:
+        static void sample(void *);
+        static bool start_flag;
+        static uint32_t margin;
+        static uint32_t warning_threshold;
+        static timer::Timer::Handle_t timer_handle;
+        static sync::Mutex mutex;
+        static std::map<std::string, Record> records;
+};
+
+}
+
+}
+
+#endif // _stack_profiler_hpp_
@@ -12,6 +12,8 @@
 #include "freertos/task.h"
 #include "freertos/semphr.h"
 
+#include "task_placement.hpp"
+
 #include "system.hpp"
 
 namespace cubestone_wang 
@@ -26,6 +28,8 @@ bool System::restart_flag = false;
 
 SemaphoreHandle_t System::restart_mutex = xSemaphoreCreateMutex();
 
+uint32_t System::restart_countdown = 0;
+
 void System::LogHardwareInfo()
 {   
     ESP_LOGI(LOG_TAG, "Hardware info:");
@@ -85,19 +89,21 @@ void System:: Restart(const char *const reason, const uint32_t delay)
         ESP_LOGI(LOG_TAG, "restart now");
         esp_restart();
     } else {
-        xTaskCreate([](void *delay) {
-                        for (uint32_t i = (uint32_t)delay; i > 0; i--) {
-                            ESP_LOGI(LOG_TAG, "restart in %lu s...", i);
-                            Sleep(1000);
-                        }
-                        ESP_LOGI(LOG_TAG, "restart now");
-                        esp_restart();
-                    }, 
-                    "restart", 
-                    4096, 
-                    (void *)delay, 
-                    configMAX_PRIORITIES,
-                    NULL);
+        // 在单独的任务中倒计时，定时器调度任务阻塞时也能按时重启
+        restart_countdown = delay;
+        auto ret = task_placement::TaskPlacement::Create(task_placement::TaskPlacement::TaskType::RESTART,
+                                                         [](void *) {
+                                                             for (; restart_countdown > 0; restart_countdown--) {
+                                                                 ESP_LOGI(LOG_TAG, "restart in %lu s...", restart_countdown);
+                                                                 Sleep(1000);
+                                                             }
+                                                             ESP_LOGI(LOG_TAG, "restart now");
+                                                             esp_restart();
+                                                         });
+        if (false == ret) {
+            ESP_LOGE(LOG_TAG, "create restart task failed, restart now");
+            esp_restart();
+        }
     }
 }
 
@@ -92,6 +92,8 @@ class System
     private:
         static bool restart_flag;
         static SemaphoreHandle_t restart_mutex;
+        // 距重启的剩余秒数
+        static uint32_t restart_countdown;
 };
 
 }
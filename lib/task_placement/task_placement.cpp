@@ -0,0 +1,133 @@
+#include <string.h>
+
+#include "esp_log.h"
+
+#include "task_placement.hpp"
+
+namespace cubestone_wang
+{
+
+namespace task_placement
+{
+
+const char *const TaskPlacement::LOG_TAG = "TASK_PLACEMENT";
+
+// 与TaskType顺序一致
+const TaskPlacement::Placement TaskPlacement::placements[] = {
+    // LED、按钮及定时事件，与传感器采集同在APP_CPU
+    {"timer", 1, 5, 6144},
+    // 上传与Wi-Fi、lwIP同在PRO_CPU，HTTPS握手在该任务中进行，需要较大的栈
+    {"influxdb", 0, 2, 8192},
+    // 启动阶段，不固定核心，并行执行
+    {"boot", tskNO_AFFINITY, 3, 4096},
+    // 域名解析的后台刷新，与lwIP同在PRO_CPU
+    {"resolver", 0, 1, 4096},
+    // 重启倒计时，不依赖定时器调度任务；关机回调（写入配置、停止Wi-Fi等）在该任务中执行，需要较大的栈
+    {"restart", tskNO_AFFINITY, 10, 6144},
+    // 指标接口，由esp_http_server创建，与上传同在PRO_CPU，优先级低于上传
+    {"httpd", 0, 1, 4096},
+    // MQTT客户端，由esp-mqtt创建，核心由sdkconfig的CONFIG_MQTT_USE_CORE_0决定，与上传同在PRO_CPU
+    {"mqtt", 0, 2, 6144},
+    // 显示刷新，整帧经I2C发送，与传感器采集同在APP_CPU，优先级低于定时器调度任务
+    {"screen", 1, 3, 4096},
+    // 按钮触发的操作（校准、重置配置、输出状态），会阻塞在UART、NVS上，不在定时器调度任务中执行
+    {"action", 1, 1, 6144},
+};
+
+sync::Mutex TaskPlacement::mutex(LOG_TAG);
+
+uint32_t TaskPlacement::last_total_runtime = 0;
+
+std::map<uint32_t, uint32_t> TaskPlacement::last_runtimes;
+
+const TaskPlacement::Placement &TaskPlacement::Get(const TaskType type)
+{
+    static_assert(sizeof(placements) / sizeof(placements[0]) == static_cast<size_t>(TaskType::MAX),
+                  "placements must match TaskType");
+    return placements[static_cast<size_t>(type)];
+}
+
+bool TaskPlacement::Create(const TaskType type, TaskFunction_t func, void *args, TaskHandle_t *task_handler)
+{
+    auto &placement = Get(type);
+    auto err = xTaskCreatePinnedToCore(func,
+                                       placement.Name,
+                                       placement.StackDepth,
+                                       args,
+                                       placement.Priority,
+                                       task_handler,
+                                       placement.CoreID);
+    if (pdPASS != err) {
+        ESP_LOGE(LOG_TAG, "create %s failed, the reason is %d", placement.Name, err);
+        return false;
+    }
+    ESP_LOGD(LOG_TAG, "%s created on core %d, priority %u, stack %lu",
+             placement.Name, placement.CoreID, placement.Priority, placement.StackDepth);
+    return true;
+}
+
+void TaskPlacement::LogPlacement()
+{
+    ESP_LOGI(LOG_TAG, "            name  core  pri.   stack");
+    for (auto &placement : placements) {
+        ESP_LOGI(LOG_TAG, "%16s  %4d  %4u  %6lu",
+                 placement.Name,
+                 tskNO_AFFINITY == placement.CoreID ? -1 : placement.CoreID,
+                 placement.Priority,
+                 placement.StackDepth);
+    }
+}
+
+void TaskPlacement::LogCoreLoad()
+{
+    UBaseType_t task_count = uxTaskGetNumberOfTasks();
+    TaskStatus_t *task_status_array = new TaskStatus_t[task_count];
+    uint32_t total_runtime;
+    uint32_t idle_runtimes[portNUM_PROCESSORS] = {};
+    task_count = uxTaskGetSystemState(task_status_array, task_count, &total_runtime);
+    // 只保留本次快照中的任务，已删除任务（启动阶段、重启倒计时等）的记录随之清除
+    std::map<uint32_t, uint32_t> runtimes;
+    for (UBaseType_t index = 0; index < task_count; index++) {
+        runtimes[task_status_array[index].xTaskNumber] = task_status_array[index].ulRunTimeCounter;
+    }
+    // 设置临界区
+    mutex.Lock();
+    // 运行时间计数为32位，两次调用的间隔需小于其溢出周期
+    uint32_t elapsed = total_runtime - last_total_runtime;
+    if (0 == elapsed) {
+        ESP_LOGE(LOG_TAG, "elapsed runtime is 0");
+        goto DONE;
+    }
+    ESP_LOGI(LOG_TAG, "core                name   runtime(%%)");
+    for (UBaseType_t index = 0; index < task_count; index++) {
+        auto &task_status = task_status_array[index];
+        auto iter = last_runtimes.find(task_status.xTaskNumber);
+        uint32_t runtime = task_status.ulRunTimeCounter - (iter != last_runtimes.end() ? iter->second : 0);
+        // 空闲任务固定在各自的核心上，其占比即该核心的空闲率
+        if (0 == strncmp(task_status.pcTaskName, "IDLE", 4)
+            && task_status.xCoreID >= 0 && task_status.xCoreID < portNUM_PROCESSORS) {
+            idle_runtimes[task_status.xCoreID] = runtime;
+            continue;
+        }
+        if (runtime * 100ULL / elapsed > 0) {
+            ESP_LOGI(LOG_TAG, "%4ld  %18s  %10llu%%",
+                     tskNO_AFFINITY == task_status.xCoreID ? -1L : (long)task_status.xCoreID,
+                     task_status.pcTaskName,
+                     runtime * 100ULL / elapsed);
+        }
+    }
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        uint32_t idle = idle_runtimes[core] > elapsed ? elapsed : idle_runtimes[core];
+        ESP_LOGI(LOG_TAG, "core %d load: %llu%%", core, (elapsed - idle) * 100ULL / elapsed);
+    }
+DONE:
+    last_total_runtime = total_runtime;
+    last_runtimes.swap(runtimes);
+    // 退出临界区
+    mutex.Unlock();
+    delete[] task_status_array;
+}
+
+}
+
+}
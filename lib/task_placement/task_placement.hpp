@@ -0,0 +1,87 @@
+#ifndef _task_placement_hpp_
+#define _task_placement_hpp_
+
+#include <map>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "mutex.hpp"
+
+namespace cubestone_wang
+{
+
+namespace task_placement
+{
+
+/*
+  任务放置表
+  集中定义各模块任务的核心、优先级和栈大小，统一通过xTaskCreatePinnedToCore创建；
+  由组件创建的任务（esp_http_server、esp-mqtt）通过其配置结构体使用对应的放置
+  Wi-Fi、lwIP及上传任务固定在PRO_CPU，传感器采集（主任务）、显示、按钮操作及LED、按钮（定时器调度任务）固定在APP_CPU，
+  主任务、lwIP等系统任务的放置由sdkconfig决定
+*/
+class TaskPlacement
+{
+    public:
+        // 任务类型
+        enum class TaskType {
+            TIMER,
+            INFLUXDB,
+            BOOT,
+            RESOLVER,
+            RESTART,
+            HTTPD,
+            MQTT,
+            SCREEN,
+            ACTION,
+            MAX,
+        };
+        // 任务放置
+        struct Placement {
+            const char *Name;
+            BaseType_t CoreID;      // tskNO_AFFINITY表示不固定
+            UBaseType_t Priority;
+            uint32_t StackDepth;    // 字节
+        };
+        // 日志标签
+        static const char *const LOG_TAG;
+        /**
+         * @brief 获取任务放置
+         *
+         * @param type 任务类型
+         */
+        static const Placement &Get(const TaskType type);
+        /**
+         * @brief 按放置表创建任务
+         *
+         * @param type 任务类型
+         * @param func 任务函数
+         * @param args 任务参数
+         * @param task_handler 任务句柄
+         */
+        static bool Create(const TaskType type,
+                           TaskFunction_t func,
+                           void *args=nullptr,
+                           TaskHandle_t *task_handler=nullptr);
+        /**
+         * @brief 输出放置表
+         */
+        static void LogPlacement();
+        /**
+         * @brief 输出上次调用以来各核心的负载及各任务的占比
+         */
+        static void LogCoreLoad();
+    private:
+        static const Placement placements[];
+        static sync::Mutex mutex;
+        // 上次统计时的总运行时间及各任务运行时间
+        static uint32_t last_total_runtime;
+        static std::map<uint32_t, uint32_t> last_runtimes;
+};
+
+}
+
+}
+
+#endif // _task_placement_hpp_
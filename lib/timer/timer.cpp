@@ -1,10 +1,10 @@
 #include "esp_log.h"
 
-#include "system.hpp"
+#include "task_placement.hpp"
 
 #include "timer.hpp"
 
-namespace cubestone_wang 
+namespace cubestone_wang
 {
 
 namespace timer
@@ -12,196 +12,464 @@ namespace timer
 
 const char *const Timer::LOG_TAG = "TIMER";
 
+const Timer::Handle_t Timer::INVALID_HANDLE = 0;
+const uint16_t Timer::INVALID_INDEX = UINT16_MAX;
+
 bool Timer::init_flag = false;
-std::map<std::string, Timer::Data*> Timer::name_to_data;
-std::set<Timer::Data*> Timer::exist_data;
-SemaphoreHandle_t Timer::mutex = xSemaphoreCreateRecursiveMutex();
+std::vector<Timer::Data> Timer::data_pool;
+std::vector<uint16_t> Timer::free_indexes;
+std::vector<uint16_t> Timer::heap;
+std::map<std::string, Timer::Handle_t> Timer::name_to_handle;
+sync::Mutex Timer::mutex("timer");
+QueueHandle_t Timer::job_queue = xQueueCreate(16, sizeof(Timer::Job));
 TaskHandle_t Timer::task_handler = nullptr;
-QueueHandle_t Timer::queue = xQueueCreate(20, sizeof(Timer::Data *));
+const Timer::Signal_t Timer::INVALID_SIGNAL = 0;
+Timer::Job Timer::signal_jobs[Timer::MAX_SIGNALS] = {};
+uint8_t Timer::signal_count = 0;
+portMUX_TYPE Timer::signal_spinlock = portMUX_INITIALIZER_UNLOCKED;
+uint32_t Timer::pending_signals = 0;
 
-void Timer::init() 
+bool Timer::init()
 {
-    // 判断是否已经初始化  
+    // 判断是否已经初始化
     if (true == init_flag) {
         ESP_LOGI(LOG_TAG, "this has been inited");
-        return;
+        return true;
     }
-    auto err = xTaskCreate(run_task, 
-                           "timer", 
-                           4096, 
-                           nullptr, 
-                           15, 
-                           &task_handler);
-    if (err != pdPASS) {
-        ESP_LOGE(LOG_TAG, "init err, the reason is %d", err);
+    // 调度任务同时执行屏幕刷新、按钮回调等任务，栈需要容纳其中最深的调用
+    if (!task_placement::TaskPlacement::Create(task_placement::TaskPlacement::TaskType::TIMER,
+                                               run_task,
+                                               nullptr,
+                                               &task_handler)) {
+        ESP_LOGE(LOG_TAG, "init err");
+        return false;
     }
     init_flag = true;
-    return;
+    return true;
 }
 
-void Timer::deinit()
+void Timer::invoke(const CallbackFunction_t func, void *args)
 {
-    // 判断是否未初始化  
-    if (false == init_flag) {
-        ESP_LOGI(LOG_TAG, "this has not been inited");
+    if (nullptr == func) {
         return;
     }
-    vTaskDelete(task_handler);
-    task_handler = nullptr;
-    xQueueReset(queue);
-    init_flag = false;
-    return;
+    try {
+        func(args);
+    } catch(const std::exception& e) {
+        ESP_LOGE(LOG_TAG, "unexpected->%s", e.what());
+    }
 }
 
 void Timer::run_task(void *args)
-{   
+{
+    const int64_t tick_period = portTICK_PERIOD_MS * 1000;
+    Job job;
+    uint32_t signals;
     while(1) {
-        Data *data;
-        if (pdTRUE != xQueueReceive(queue, (void *)&data, portMAX_DELAY)) {
-            continue;
+        // 先执行触发的信号，执行前清除，执行期间再次触发时下一轮再执行
+        portENTER_CRITICAL(&signal_spinlock);
+        signals = pending_signals;
+        pending_signals = 0;
+        portEXIT_CRITICAL(&signal_spinlock);
+        for (uint8_t index = 0; 0 != signals; index++, signals >>= 1) {
+            if (signals & 1) {
+                invoke(signal_jobs[index].Func, signal_jobs[index].Args);
+            }
+        }
+        // 再执行投递的任务
+        while (pdTRUE == xQueueReceive(job_queue, &job, 0)) {
+            invoke(job.Func, job.Args);
         }
         // 设置临界区
-        xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
-        if (0 == exist_data.count(data)) {
+        mutex.Lock();
+        if (heap.empty()) {
             // 退出临界区
-            xSemaphoreGiveRecursive(mutex);
+            mutex.Unlock();
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
             continue;
         }
-        bool is_oneshot = data->IsOneshot;
-        auto func = data->Func;
-        auto args = data->Args;
-        if (true == is_oneshot) {
-            esp_timer_stop(data->Handle);
-            ESP_ERROR_CHECK(esp_timer_delete(data->Handle));
-            exist_data.erase(data);
-            name_to_data.erase(data->Name);
-            delete data;
+        int64_t now = esp_timer_get_time();
+        Data &data = data_pool[heap[0]];
+        if (data.Expiry > now) {
+            // 向上取整，保证不会提前触发
+            TickType_t ticks = (data.Expiry - now + tick_period - 1) / tick_period;
+            // 退出临界区
+            mutex.Unlock();
+            ulTaskNotifyTake(pdTRUE, ticks);
+            continue;
         }
-        if (func) {
-            try {
-                func(args);
-            } catch(const std::exception& e) {
-                ESP_LOGE(LOG_TAG, "unexpected->%s", e.what());
+        auto func = data.Func;
+        auto args = data.Args;
+        if (0 == data.Interval) {
+            heap_remove(0);
+            release(static_cast<uint16_t>(&data - data_pool.data()));
+        } else {
+            // 按到期时间累加以避免漂移，落后超过一个周期时不再补发
+            data.Expiry += data.Interval;
+            if (data.Expiry <= now) {
+                data.Expiry = now + data.Interval;
             }
+            heap_down(0);
         }
-        if (true == is_oneshot) {
-            if (name_to_data.empty()) {
-                task_handler = nullptr;
-                xQueueReset(queue);
-                init_flag = false;
-                // 退出临界区
-                xSemaphoreGiveRecursive(mutex);
-                vTaskDelete(NULL);
-            }
+        // 退出临界区
+        mutex.Unlock();
+        invoke(func, args);
+    }
+}
+
+void Timer::heap_swap(const size_t a, const size_t b)
+{
+    std::swap(heap[a], heap[b]);
+    data_pool[heap[a]].HeapIndex = a;
+    data_pool[heap[b]].HeapIndex = b;
+}
+
+void Timer::heap_up(size_t position)
+{
+    while (position > 0) {
+        size_t parent = (position - 1) / 2;
+        if (data_pool[heap[parent]].Expiry <= data_pool[heap[position]].Expiry) {
+            break;
+        }
+        heap_swap(parent, position);
+        position = parent;
+    }
+}
+
+void Timer::heap_down(size_t position)
+{
+    while (1) {
+        size_t smallest = position;
+        size_t left = position * 2 + 1;
+        size_t right = left + 1;
+        if (left < heap.size() && data_pool[heap[left]].Expiry < data_pool[heap[smallest]].Expiry) {
+            smallest = left;
         }
+        if (right < heap.size() && data_pool[heap[right]].Expiry < data_pool[heap[smallest]].Expiry) {
+            smallest = right;
+        }
+        if (smallest == position) {
+            break;
+        }
+        heap_swap(smallest, position);
+        position = smallest;
+    }
+}
+
+void Timer::heap_push(const uint16_t index)
+{
+    heap.push_back(index);
+    data_pool[index].HeapIndex = heap.size() - 1;
+    heap_up(heap.size() - 1);
+}
+
+void Timer::heap_remove(const size_t position)
+{
+    size_t last = heap.size() - 1;
+    if (position != last) {
+        heap_swap(position, last);
+    }
+    data_pool[heap[last]].HeapIndex = INVALID_INDEX;
+    heap.pop_back();
+    if (position < heap.size()) {
+        heap_up(position);
+        heap_down(position);
+    }
+}
+
+void Timer::release(const uint16_t index)
+{
+    Data &data = data_pool[index];
+    if (!data.Name.empty()) {
+        name_to_handle.erase(data.Name);
+        data.Name.clear();
+    }
+    data.Func = nullptr;
+    data.Args = nullptr;
+    data.HeapIndex = INVALID_INDEX;
+    data.Generation++;
+    free_indexes.push_back(index);
+}
+
+Timer::Data *Timer::get(const Handle_t handle)
+{
+    uint32_t index = (handle & 0xffff);
+    if (0 == index || index > data_pool.size()) {
+        return nullptr;
+    }
+    Data &data = data_pool[index - 1];
+    if (data.Generation != (handle >> 16) || INVALID_INDEX == data.HeapIndex) {
+        return nullptr;
+    }
+    return &data;
+}
+
+Timer::Handle_t Timer::add(const std::string &name,
+                           const int64_t delay,
+                           const int64_t interval,
+                           const CallbackFunction_t func,
+                           void *args)
+{
+    // 判断是否已经初始化
+    if (false == init_flag && false == init()) {
+        return INVALID_HANDLE;
+    }
+    uint16_t index;
+    if (!free_indexes.empty()) {
+        index = free_indexes.back();
+        free_indexes.pop_back();
+    } else if (data_pool.size() < INVALID_INDEX) {
+        index = data_pool.size();
+        Data data = {};
+        data.Generation = 1;
+        data.HeapIndex = INVALID_INDEX;
+        data_pool.push_back(data);
+    } else {
+        ESP_LOGE(LOG_TAG, "too many events");
+        return INVALID_HANDLE;
+    }
+    Data &data = data_pool[index];
+    data.Expiry = esp_timer_get_time() + delay;
+    data.Interval = interval;
+    data.Func = func;
+    data.Args = args;
+    data.Name = name;
+    heap_push(index);
+    // 新事件位于堆顶时唤醒调度任务重新计算等待时间
+    if (0 == data.HeapIndex) {
+        xTaskNotifyGive(task_handler);
+    }
+    return (static_cast<Handle_t>(data.Generation) << 16) | (index + 1);
+}
+
+bool Timer::del(const Handle_t handle)
+{
+    Data *data = get(handle);
+    if (nullptr == data) {
+        ESP_LOGW(LOG_TAG, "0x%08lx can't be found", handle);
+        return false;
+    }
+    heap_remove(data->HeapIndex);
+    release(static_cast<uint16_t>(data - data_pool.data()));
+    return true;
+}
+
+Timer::Handle_t Timer::AddPeriodicEvent(const uint32_t interval,
+                                        const CallbackFunction_t func,
+                                        void *args)
+{
+    if (0 == interval) {
+        ESP_LOGE(LOG_TAG, "interval can't be 0");
+        return INVALID_HANDLE;
+    }
+    // 设置临界区
+    mutex.Lock();
+    auto handle = add("", interval*(int64_t)1000, interval*(int64_t)1000, func, args);
+    // 退出临界区
+    mutex.Unlock();
+    return handle;
+}
+
+Timer::Handle_t Timer::AddOneShotEvent(const uint32_t delay,
+                                       const CallbackFunction_t func,
+                                       void *args)
+{
+    // 设置临界区
+    mutex.Lock();
+    auto handle = add("", delay*(int64_t)1000, 0, func, args);
+    // 退出临界区
+    mutex.Unlock();
+    return handle;
+}
+
+bool Timer::Del(const Handle_t handle)
+{
+    // 设置临界区
+    mutex.Lock();
+    auto result = del(handle);
+    // 退出临界区
+    mutex.Unlock();
+    return result;
+}
+
+bool Timer::Reschedule(const Handle_t handle, const uint32_t delay)
+{
+    // 设置临界区
+    mutex.Lock();
+    Data *data = get(handle);
+    if (nullptr != data) {
+        data->Expiry = esp_timer_get_time() + delay*(int64_t)1000;
+        heap_up(data->HeapIndex);
+        heap_down(data->HeapIndex);
+        if (0 == data->HeapIndex) {
+            xTaskNotifyGive(task_handler);
+        }
+    }
+    // 退出临界区
+    mutex.Unlock();
+    return nullptr != data;
+}
+
+bool Timer::Post(const CallbackFunction_t func, void *args)
+{
+    Job job = {func, args};
+    // 判断是否已经初始化
+    if (false == init_flag) {
+        // 设置临界区
+        mutex.Lock();
+        auto result = init();
         // 退出临界区
-        xSemaphoreGiveRecursive(mutex);
+        mutex.Unlock();
+        if (false == result) {
+            return false;
+        }
     }
+    if (pdTRUE != xQueueSend(job_queue, &job, 0)) {
+        ESP_LOGE(LOG_TAG, "job queue is full");
+        return false;
+    }
+    xTaskNotifyGive(task_handler);
+    return true;
 }
 
-void Timer::inner_timer_callback(void *args) 
+bool IRAM_ATTR Timer::PostFromISR(const CallbackFunction_t func, void *args, BaseType_t *task_woken)
 {
-    xQueueSend(queue, (void *)&args, portMAX_DELAY);
+    Job job = {func, args};
+    if (pdTRUE != xQueueSendFromISR(job_queue, &job, task_woken)) {
+        return false;
+    }
+    // 尚未初始化时保留在队列中，调度任务启动后执行
+    if (nullptr != task_handler) {
+        vTaskNotifyGiveFromISR(task_handler, task_woken);
+    }
+    return true;
+}
+
+Timer::Signal_t Timer::AddSignal(const CallbackFunction_t func, void *args)
+{
+    Signal_t signal = INVALID_SIGNAL;
+    // 设置临界区
+    mutex.Lock();
+    // 判断是否已经初始化
+    if (false == init_flag && false == init()) {
+        goto DONE;
+    }
+    if (signal_count >= MAX_SIGNALS) {
+        ESP_LOGE(LOG_TAG, "too many signals");
+        goto DONE;
+    }
+    signal_jobs[signal_count] = {func, args};
+    signal = 1UL << signal_count;
+    signal_count++;
+DONE:
+    // 退出临界区
+    mutex.Unlock();
+    return signal;
+}
+
+void Timer::Raise(const Signal_t signal)
+{
+    if (INVALID_SIGNAL == signal) {
+        return;
+    }
+    portENTER_CRITICAL(&signal_spinlock);
+    pending_signals |= signal;
+    portEXIT_CRITICAL(&signal_spinlock);
+    xTaskNotifyGive(task_handler);
+}
+
+void IRAM_ATTR Timer::RaiseFromISR(const Signal_t signal, BaseType_t *task_woken)
+{
+    if (INVALID_SIGNAL == signal) {
+        return;
+    }
+    portENTER_CRITICAL_ISR(&signal_spinlock);
+    pending_signals |= signal;
+    portEXIT_CRITICAL_ISR(&signal_spinlock);
+    vTaskNotifyGiveFromISR(task_handler, task_woken);
 }
 
 bool Timer::AddPeriodicEvent(const std::string &name,
                              const uint32_t interval,
-                             const CallbackFunction_t func, 
+                             const CallbackFunction_t func,
                              void *args)
 {
+    bool result = false;
+    if (0 == interval) {
+        ESP_LOGE(LOG_TAG, "interval can't be 0");
+        return false;
+    }
     // 设置临界区
-    xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
-    if (name_to_data.count(name) > 0) {
+    mutex.Lock();
+    if (name_to_handle.count(name) > 0) {
         ESP_LOGE(LOG_TAG, "%s has been exist", name.c_str());
-        // 退出临界区
-        xSemaphoreGiveRecursive(mutex);
-        return false;
+        goto DONE;
     }
-    // 判断是否已经初始化  
-    if (false == init_flag) {
-        init();
-    }
-    Data *data = new Data();
-    esp_timer_create_args_t timer_create_args;
-    esp_timer_handle_t timer_handle = nullptr;
-    timer_create_args.dispatch_method = ESP_TIMER_TASK;
-    timer_create_args.callback = inner_timer_callback;
-    timer_create_args.arg = (void *)data;
-    ESP_ERROR_CHECK(esp_timer_create(&timer_create_args, &timer_handle));
-    data->Func = func;
-    data->Args = args;
-    data->IsOneshot = false;
-    data->Handle = timer_handle;
-    data->Name = name;
-    name_to_data[name] = data;
-    exist_data.insert(data);
-    ESP_ERROR_CHECK(esp_timer_start_periodic(timer_handle, interval*(uint64_t)1000));
+    {
+        auto handle = add(name, interval*(int64_t)1000, interval*(int64_t)1000, func, args);
+        if (INVALID_HANDLE == handle) {
+            goto DONE;
+        }
+        name_to_handle[name] = handle;
+    }
+    result = true;
+DONE:
     // 退出临界区
-    xSemaphoreGiveRecursive(mutex);
-    return true;
+    mutex.Unlock();
+    return result;
 }
 
 bool Timer::AddOneShotEvent(const std::string &name,
                             const uint32_t delay,
-                            const CallbackFunction_t func, 
+                            const CallbackFunction_t func,
                             void *args)
 {
+    bool result = false;
     // 设置临界区
-    xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
-    if (name_to_data.count(name) > 0) {
+    mutex.Lock();
+    if (name_to_handle.count(name) > 0) {
         ESP_LOGE(LOG_TAG, "%s has been exist", name.c_str());
-        // 退出临界区
-        xSemaphoreGiveRecursive(mutex);
-        return false;
+        goto DONE;
     }
-    // 判断是否已经初始化  
-    if (false == init_flag) {
-        init();  
-    }
-    Data *data = new Data();
-    esp_timer_create_args_t timer_create_args;
-    esp_timer_handle_t timer_handle = nullptr;
-    timer_create_args.dispatch_method = ESP_TIMER_TASK;
-    timer_create_args.callback = inner_timer_callback;
-    timer_create_args.arg = (void *)data;
-    ESP_ERROR_CHECK(esp_timer_create(&timer_create_args, &timer_handle));
-    data->Func = func;
-    data->Args = args;
-    data->IsOneshot = true;
-    data->Handle = timer_handle;
-    data->Name = name;
-    name_to_data[name] = data;
-    exist_data.insert(data);
-    ESP_ERROR_CHECK(esp_timer_start_once(timer_handle, delay*(uint64_t)1000));
+    {
+        auto handle = add(name, delay*(int64_t)1000, 0, func, args);
+        if (INVALID_HANDLE == handle) {
+            goto DONE;
+        }
+        name_to_handle[name] = handle;
+    }
+    result = true;
+DONE:
     // 退出临界区
-    xSemaphoreGiveRecursive(mutex);
-    return true;
+    mutex.Unlock();
+    return result;
 }
 
 bool Timer::Del(const std::string &name)
 {
+    bool result = false;
     // 设置临界区
-    xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
-    auto iter = name_to_data.find(name);  
-    if(iter == name_to_data.end()) {
+    mutex.Lock();
+    auto iter = name_to_handle.find(name);
+    if (iter == name_to_handle.end()) {
         ESP_LOGW(LOG_TAG, "%s can't be found", name.c_str());
-        // 退出临界区
-        xSemaphoreGiveRecursive(mutex);
-        return false;
-    }
-    if (0 < exist_data.count(iter->second)) {
-        exist_data.erase(iter->second);
-    }
-    esp_timer_stop(iter->second->Handle);
-    ESP_ERROR_CHECK(esp_timer_delete(iter->second->Handle));
-    delete iter->second;
-    name_to_data.erase(iter);
-    if (name_to_data.empty()) {
-        deinit();
+        goto DONE;
     }
+    result = del(iter->second);
+DONE:
     // 退出临界区
-    xSemaphoreGiveRecursive(mutex);
-    return true;
+    mutex.Unlock();
+    return result;
+}
+
+size_t Timer::GetEventCount()
+{
+    // 设置临界区
+    mutex.Lock();
+    auto count = heap.size();
+    // 退出临界区
+    mutex.Unlock();
+    return count;
 }
 
 }
@@ -3,20 +3,29 @@
 
 #include <string>
 #include <map>
-#include <set>
+#include <vector>
 
 #include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
 #include "freertos/semphr.h"
 #include "freertos/task.h"
-#include "freertos/queue.h"
 
-namespace cubestone_wang 
+#include "mutex.hpp"
+
+namespace cubestone_wang
 {
 
 namespace timer
 {
 
+/*
+  所有事件保存在以到期时间排序的最小堆中，由单个调度任务等待堆顶到期后执行回调，
+  添加与删除的复杂度为O(log n)，不再为每个事件创建esp_timer
+  调度任务同时作为执行器，按投递顺序执行Post投递的任务，各模块通过事件和任务
+  完成周期处理，不再各自创建任务；回调运行在同一个任务中，应尽快返回
+  信号为预先注册的回调，触发时只置位并唤醒调度任务，不占用投递队列，执行前多次触发只执行一次
+*/
 class Timer
 {
     public:
@@ -26,6 +35,88 @@ class Timer
          * @brief 回调函数定义
          */
         typedef void (* CallbackFunction_t)(void *args);
+        /**
+         * @brief 事件句柄定义，INVALID_HANDLE表示无效
+         */
+        typedef uint32_t Handle_t;
+        static const Handle_t INVALID_HANDLE;
+        /**
+         * @brief 添加周期性事件
+         *
+         * @param interval 重复执行的间隔(毫秒)
+         * @param func 触发时的回调函数
+         * @param args 回调函数参数
+         * @return 事件句柄，失败时返回INVALID_HANDLE
+         */
+        static Handle_t AddPeriodicEvent(const uint32_t interval,
+                                         const CallbackFunction_t func,
+                                         void *args=nullptr);
+        /**
+         * @brief 添加一次性事件
+         *
+         * @param delay 延迟的时间(毫秒)
+         * @param func 触发时的回调函数
+         * @param args 回调函数参数
+         * @return 事件句柄，失败时返回INVALID_HANDLE
+         */
+        static Handle_t AddOneShotEvent(const uint32_t delay,
+                                        const CallbackFunction_t func,
+                                        void *args=nullptr);
+        /**
+         * @brief 删除，回调正在其他任务中执行时不会等待其结束
+         *
+         * @param handle 事件句柄
+         */
+        static bool Del(const Handle_t handle);
+        /**
+         * @brief 修改事件的下次到期时间，周期性事件之后仍按原周期执行
+         *
+         * @param handle 事件句柄
+         * @param delay 距下次到期的时间(毫秒)
+         * @return 事件已触发或已删除时返回false
+         */
+        static bool Reschedule(const Handle_t handle, const uint32_t delay);
+        /**
+         * @brief 投递任务，由调度任务尽快执行
+         *
+         * @param func 回调函数
+         * @param args 回调函数参数
+         */
+        static bool Post(const CallbackFunction_t func, void *args=nullptr);
+        /**
+         * @brief 在中断中投递任务
+         *
+         * @param func 回调函数
+         * @param args 回调函数参数
+         * @param task_woken 是否唤醒了更高优先级的任务
+         */
+        static bool PostFromISR(const CallbackFunction_t func, void *args, BaseType_t *task_woken);
+        /**
+         * @brief 信号定义，每个信号占一位，INVALID_SIGNAL表示无效
+         */
+        typedef uint32_t Signal_t;
+        static const Signal_t INVALID_SIGNAL;
+        /**
+         * @brief 注册信号，不能删除，最多32个
+         *
+         * @param func 触发时的回调函数
+         * @param args 回调函数参数
+         * @return 信号，失败时返回INVALID_SIGNAL
+         */
+        static Signal_t AddSignal(const CallbackFunction_t func, void *args=nullptr);
+        /**
+         * @brief 触发信号，由调度任务尽快执行其回调
+         *
+         * @param signal 信号
+         */
+        static void Raise(const Signal_t signal);
+        /**
+         * @brief 在中断中触发信号
+         *
+         * @param signal 信号
+         * @param task_woken 是否唤醒了更高优先级的任务
+         */
+        static void RaiseFromISR(const Signal_t signal, BaseType_t *task_woken);
         /**
          * @brief 添加周期性事件
          *
@@ -36,7 +127,7 @@ class Timer
          */
         static bool AddPeriodicEvent(const std::string &name,
                                      const uint32_t interval,
-                                     const CallbackFunction_t func, 
+                                     const CallbackFunction_t func,
                                      void *args=nullptr);
         /**
          * @brief 添加一次性事件
@@ -48,7 +139,7 @@ class Timer
          */
         static bool AddOneShotEvent(const std::string &name,
                                     const uint32_t delay,
-                                     const CallbackFunction_t func, 
+                                    const CallbackFunction_t func,
                                     void *args=nullptr);
         /**
          * @brief 删除
@@ -56,26 +147,63 @@ class Timer
          * @param name 事件名称
          */
         static bool Del(const std::string &name);
+        /**
+         * @brief 获取当前事件数量
+         */
+        static size_t GetEventCount();
     private:
         struct Data{
+            // 下次到期时间(微秒)
+            int64_t Expiry;
+            // 周期(微秒)，0表示一次性事件
+            int64_t Interval;
+            CallbackFunction_t Func;
+            void *Args;
+            // 每次释放后递增，防止旧句柄误删新事件
+            uint16_t Generation;
+            // 在堆中的位置，INVALID_INDEX表示空闲
+            uint16_t HeapIndex;
+            // 通过名称添加时的事件名称
             std::string Name;
-            CallbackFunction_t Func; 
+        };
+        // 投递的任务
+        struct Job {
+            CallbackFunction_t Func;
             void *Args;
-            bool IsOneshot;
-            esp_timer_handle_t Handle;
         };
+        static const uint16_t INVALID_INDEX;
         /**
          * @brief 初始化
          */
-        static void init();
-        static void deinit();
+        static bool init();
+        static Handle_t add(const std::string &name,
+                            const int64_t delay,
+                            const int64_t interval,
+                            const CallbackFunction_t func,
+                            void *args);
+        static bool del(const Handle_t handle);
+        static Data *get(const Handle_t handle);
+        static void release(const uint16_t index);
+        static void invoke(const CallbackFunction_t func, void *args);
+        static void heap_swap(const size_t a, const size_t b);
+        static void heap_up(size_t position);
+        static void heap_down(size_t position);
+        static void heap_push(const uint16_t index);
+        static void heap_remove(const size_t position);
         static bool init_flag;
         static TaskHandle_t task_handler;
-        static SemaphoreHandle_t mutex;
-        static QueueHandle_t queue;
-        static std::map<std::string, Data*> name_to_data;
-        static std::set<Data*> exist_data;
-        static void inner_timer_callback(void *args);
+        static sync::Mutex mutex;
+        static QueueHandle_t job_queue;
+        static std::vector<Data> data_pool;
+        static std::vector<uint16_t> free_indexes;
+        static std::vector<uint16_t> heap;
+        static std::map<std::string, Handle_t> name_to_handle;
+        static const uint8_t MAX_SIGNALS = 32;
+        static Job signal_jobs[MAX_SIGNALS];
+        static uint8_t signal_count;
+        // 保护已触发的信号，在中断中访问
+        static portMUX_TYPE signal_spinlock;
+        static uint32_t pending_signals;
         static void run_task(void *args);
 };
 
@@ -83,4 +211,4 @@ class Timer
 
 }
 
-#endif // _mqtt_hpp_
+#endif // _timer_hpp_
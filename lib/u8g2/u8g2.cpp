@@ -1,3 +1,5 @@
+#include "string.h"
+
 #include <functional>
 #include "esp_log.h"
 #include "system.hpp"
@@ -10,6 +12,8 @@ namespace u8g2
 {
 
 const char *const U8G2::LOG_TAG = "U8G2";
+const uint8_t U8G2::FRAME_COLUMNS = 132;
+const uint8_t U8G2::FRAME_PAGES = 8;
 
 uint8_t U8G2::u8x8_gpio_and_delay(u8x8_t *u8x8, uint8_t msg, uint8_t arg_int, void *arg_ptr)
 {
@@ -108,6 +112,8 @@ uint8_t U8G2::u8x8_byte_i2c(u8x8_t *u8x8, uint8_t msg, uint8_t arg_int, void *ar
             instance->i2c_master->Write(instance->i2c_device_address, 
                                         instance->buffer, 
                                         instance->buffer_length);
+            instance->transferred_bytes += instance->buffer_length;
+            instance->transfer_count++;
             instance->buffer_length = 0;
             break;
         }
@@ -117,27 +123,160 @@ uint8_t U8G2::u8x8_byte_i2c(u8x8_t *u8x8, uint8_t msg, uint8_t arg_int, void *ar
     return 1;
 }
 
+uint8_t U8G2::u8x8_byte_headless(u8x8_t *u8x8, uint8_t msg, uint8_t arg_int, void *arg_ptr)
+{
+    U8G2 * instance = (U8G2 *)u8x8_GetUserPtr(u8x8);
+    switch(msg)
+    {
+        case U8X8_MSG_BYTE_SEND:
+        {   
+            uint8_t *data = (uint8_t *)arg_ptr;   
+            while( arg_int > 0 )
+            {
+                instance->buffer[instance->buffer_length++] = *data;
+                data++;
+                arg_int--;
+            }  
+            break;
+        }
+        case U8X8_MSG_BYTE_INIT:
+            break;
+        case U8X8_MSG_BYTE_SET_DC:
+            break;
+        case U8X8_MSG_BYTE_START_TRANSFER:
+            break;
+        case U8X8_MSG_BYTE_END_TRANSFER:
+        {
+            instance->capture_transfer();
+            instance->transferred_bytes += instance->buffer_length;
+            instance->transfer_count++;
+            instance->buffer_length = 0;
+            break;
+        }
+        default:
+            return 0;
+    }
+    return 1;
+}
+
+void U8G2::capture_transfer()
+{
+    if (0 == this->buffer_length) {
+        return;
+    }
+    // 第一个字节为控制字节，0x00为命令，0x40为数据
+    if (0x40 == this->buffer[0]) {
+        for (uint8_t index=1; index<this->buffer_length; index++) {
+            if (this->frame_page < FRAME_PAGES && this->frame_column < FRAME_COLUMNS) {
+                this->frame[this->frame_page * FRAME_COLUMNS + this->frame_column] = this->buffer[index];
+            }
+            this->frame_column++;
+        }
+        return;
+    }
+    // 仅解析寻址相关的命令，其余命令跳过其参数
+    uint8_t index = 1;
+    while (index < this->buffer_length) {
+        uint8_t command = this->buffer[index++];
+        if (command <= 0x0f) {
+            this->frame_column = (this->frame_column & 0xf0) | command;
+        } else if (command <= 0x1f) {
+            this->frame_column = ((command & 0x0f) << 4) | (this->frame_column & 0x0f);
+        } else if (command >= 0xb0 && command <= 0xb7) {
+            this->frame_page = command & 0x07;
+        } else if (command == 0x21 || command == 0x22) {
+            index += 2;
+        } else if (command == 0x20 || command == 0x81 || command == 0x8d || 
+                   command == 0xa8 || command == 0xad || command == 0xd3 || 
+                   command == 0xd5 || command == 0xd9 || command == 0xda || 
+                   command == 0xdb) {
+            index += 1;
+        }
+    }
+}
+
 U8G2::U8G2(I2cMaster* const i2c_master, 
            const uint8_t i2c_device_address, 
            const DeviceType device_type, 
-           const u8g2_cb_t* rotation)
+           const u8g2_cb_t* rotation,
+           const BufferMode buffer_mode)
 {
-    this->mutex = xSemaphoreCreateMutex();
     this->i2c_master = i2c_master;
     this->i2c_device_address = i2c_device_address;
+    this->frame = nullptr;
+    this->init(device_type, rotation, buffer_mode, U8G2::u8x8_byte_i2c);
+}
+
+U8G2::U8G2(const DeviceType device_type, 
+           const u8g2_cb_t* rotation,
+           const BufferMode buffer_mode)
+{
+    this->i2c_master = nullptr;
+    this->i2c_device_address = 0;
+    this->frame = (uint8_t*)malloc(FRAME_COLUMNS * FRAME_PAGES);
+    memset(this->frame, 0, FRAME_COLUMNS * FRAME_PAGES);
+    this->init(device_type, rotation, buffer_mode, U8G2::u8x8_byte_headless);
+}
+
+void U8G2::init(const DeviceType device_type, 
+                const u8g2_cb_t* rotation,
+                const BufferMode buffer_mode,
+                u8x8_msg_cb byte_cb)
+{
+    this->mutex = xSemaphoreCreateMutex();
+    this->buffer_length = 0;
+    this->buffer_mode = buffer_mode;
+    this->transferred_bytes = 0;
+    this->transfer_count = 0;
+    this->frame_page = 0;
+    this->frame_column = 0;
     switch (device_type)
     {
         case DeviceType::SSD1306_I2C_128x64:
-            u8g2_Setup_ssd1306_i2c_128x64_noname_f(&instance, 
-                                                   rotation, 
-                                                   U8G2::u8x8_byte_i2c, 
-                                                   U8G2::u8x8_gpio_and_delay);
+            switch (buffer_mode)
+            {
+                case BufferMode::PAGE_1:
+                    u8g2_Setup_ssd1306_i2c_128x64_noname_1(&instance, 
+                                                           rotation, 
+                                                           byte_cb, 
+                                                           U8G2::u8x8_gpio_and_delay);
+                    break;
+                case BufferMode::PAGE_2:
+                    u8g2_Setup_ssd1306_i2c_128x64_noname_2(&instance, 
+                                                           rotation, 
+                                                           byte_cb, 
+                                                           U8G2::u8x8_gpio_and_delay);
+                    break;
+                default:
+                    u8g2_Setup_ssd1306_i2c_128x64_noname_f(&instance, 
+                                                           rotation, 
+                                                           byte_cb, 
+                                                           U8G2::u8x8_gpio_and_delay);
+                    break;
+            }
             break;
         case DeviceType::SH1106_I2C_128x64:
-            u8g2_Setup_sh1106_i2c_128x64_noname_f(&instance, 
-                                                  rotation, 
-                                                  U8G2::u8x8_byte_i2c, 
-                                                  U8G2::u8x8_gpio_and_delay);
+            switch (buffer_mode)
+            {
+                case BufferMode::PAGE_1:
+                    u8g2_Setup_sh1106_i2c_128x64_noname_1(&instance, 
+                                                          rotation, 
+                                                          byte_cb, 
+                                                          U8G2::u8x8_gpio_and_delay);
+                    break;
+                case BufferMode::PAGE_2:
+                    u8g2_Setup_sh1106_i2c_128x64_noname_2(&instance, 
+                                                          rotation, 
+                                                          byte_cb, 
+                                                          U8G2::u8x8_gpio_and_delay);
+                    break;
+                default:
+                    u8g2_Setup_sh1106_i2c_128x64_noname_f(&instance, 
+                                                          rotation, 
+                                                          byte_cb, 
+                                                          U8G2::u8x8_gpio_and_delay);
+                    break;
+            }
             break;
         default:
             ESP_ERROR_CHECK(ESP_ERR_INVALID_ARG);
@@ -155,6 +294,11 @@ U8G2::U8G2(I2cMaster* const i2c_master,
 U8G2::~U8G2()
 {   
     free(u8g2_GetBufferPtr(&instance));
+    if (nullptr != this->frame) {
+        free(this->frame);
+        this->frame = nullptr;
+    }
+    vSemaphoreDelete(this->mutex);
 }
 
 u8g2_t * U8G2::GetInstance()
@@ -176,6 +320,82 @@ void U8G2::Unlock()
     return;
 }
 
+U8G2::BufferMode U8G2::GetBufferMode()
+{
+    return this->buffer_mode;
+}
+
+uint32_t U8G2::GetBufferSize()
+{
+    return u8g2_GetBufferSize(&instance);
+}
+
+void U8G2::FirstPage()
+{
+    if (BufferMode::FULL == this->buffer_mode) {
+        u8g2_ClearBuffer(&instance);
+    } else {
+        u8g2_FirstPage(&instance);
+    }
+}
+
+bool U8G2::NextPage()
+{
+    if (BufferMode::FULL == this->buffer_mode) {
+        u8g2_SendBuffer(&instance);
+        return false;
+    }
+    return 0 != u8g2_NextPage(&instance);
+}
+
+uint32_t U8G2::GetTransferredBytes()
+{
+    return this->transferred_bytes;
+}
+
+uint32_t U8G2::GetTransferCount()
+{
+    return this->transfer_count;
+}
+
+void U8G2::ResetTransferStatistics()
+{
+    this->transferred_bytes = 0;
+    this->transfer_count = 0;
+}
+
+std::string U8G2::GetFramePBM()
+{
+    std::string result;
+    if (nullptr == this->frame) {
+        ESP_LOGE(LOG_TAG, "frame only exists in headless mode");
+        return result;
+    }
+    uint32_t width = u8g2_GetDisplayWidth(&instance);
+    uint32_t height = u8g2_GetDisplayHeight(&instance);
+    uint32_t x_offset = instance.u8x8.x_offset;
+    uint32_t row_bytes = (width + 7) / 8;
+    result = "P4\n" + std::to_string(width) + " " + std::to_string(height) + "\n";
+    result.reserve(result.length() + row_bytes * height);
+    for (uint32_t y=0; y<height; y++) {
+        for (uint32_t byte_index=0; byte_index<row_bytes; byte_index++) {
+            uint8_t value = 0;
+            for (uint32_t bit=0; bit<8; bit++) {
+                uint32_t column = byte_index * 8 + bit + x_offset;
+                if (column >= FRAME_COLUMNS) {
+                    continue;
+                }
+                // 显存按页纵向排列，低位在上
+                if (this->frame[(y / 8) * FRAME_COLUMNS + column] & (1 << (y % 8))) {
+                    value |= (0x80 >> bit);
+                }
+            }
+            result.append(1, (char)value);
+        }
+    }
+    return result;
+}
+
 }
 
 }
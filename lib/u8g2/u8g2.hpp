@@ -1,6 +1,8 @@
 #ifndef _u8g2_hpp_
 #define _u8g2_hpp_
 
+#include <string>
+
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
 
@@ -26,14 +28,63 @@ class U8G2
             SH1106_I2C_128x64,
             UNKNOWN
         };
+        // 缓冲模式
+        enum class BufferMode {
+            FULL,       // 全缓冲（1KB），一次发送，延迟最低
+            PAGE_1,     // 单页缓冲（128B），按页重绘，内存最低
+            PAGE_2,     // 双页缓冲（256B），折中
+        };
         U8G2(I2cMaster* const i2c_master, 
              const uint8_t i2c_device_address, 
              const DeviceType device_type, 
-             const u8g2_cb_t* rotation);
+             const u8g2_cb_t* rotation,
+             const BufferMode buffer_mode=BufferMode::FULL);
+        /**
+         * @brief 无头模式，不连接屏幕，发送的数据在内存中还原为帧
+         *
+         * @param device_type 屏幕类型
+         * @param rotation 旋转
+         * @param buffer_mode 缓冲模式
+         */
+        U8G2(const DeviceType device_type, 
+             const u8g2_cb_t* rotation,
+             const BufferMode buffer_mode=BufferMode::FULL);
         virtual ~U8G2();
         u8g2_t* GetInstance();
         void Lock();
         void Unlock();
+        /**
+         * @brief 获取缓冲模式
+         */
+        BufferMode GetBufferMode();
+        /**
+         * @brief 获取缓冲区大小（字节）
+         */
+        uint32_t GetBufferSize();
+        /**
+         * @brief 开始绘制一帧，全缓冲模式下清空缓冲区，页缓冲模式下定位到第一页
+         */
+        void FirstPage();
+        /**
+         * @brief 结束当前页的绘制并发送，返回是否还需绘制下一页
+         */
+        bool NextPage();
+        /**
+         * @brief 获取累计发送的字节数（含控制字节）
+         */
+        uint32_t GetTransferredBytes();
+        /**
+         * @brief 获取累计发送的次数
+         */
+        uint32_t GetTransferCount();
+        /**
+         * @brief 清空发送统计
+         */
+        void ResetTransferStatistics();
+        /**
+         * @brief 获取当前帧的PBM(P4)图像，仅无头模式有效
+         */
+        std::string GetFramePBM();
         static uint8_t u8x8_gpio_and_delay(u8x8_t *u8x8, 
                                            uint8_t msg, 
                                            uint8_t arg_int, 
@@ -42,13 +93,32 @@ class U8G2
                                      uint8_t msg, 
                                      uint8_t arg_int, 
                                      void *arg_ptr);
+        static uint8_t u8x8_byte_headless(u8x8_t *u8x8, 
+                                          uint8_t msg, 
+                                          uint8_t arg_int, 
+                                          void *arg_ptr);
     private:
+        // 无头模式下模拟的显存列数（SH1106为132列）
+        static const uint8_t FRAME_COLUMNS;
+        // 无头模式下模拟的显存页数
+        static const uint8_t FRAME_PAGES;
         SemaphoreHandle_t mutex;
         u8g2_t instance;
         I2cMaster* i2c_master;
         uint8_t i2c_device_address;
         uint8_t buffer[32];
         uint8_t buffer_length;
+        BufferMode buffer_mode;
+        uint32_t transferred_bytes;
+        uint32_t transfer_count;
+        uint8_t *frame;
+        uint8_t frame_page;
+        uint8_t frame_column;
+        void init(const DeviceType device_type, 
+                  const u8g2_cb_t* rotation,
+                  const BufferMode buffer_mode,
+                  u8x8_msg_cb byte_cb);
+        void capture_transfer();
 };
 
 }
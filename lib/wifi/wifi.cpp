@@ -2,8 +2,10 @@
 
 #include "esp_log.h"
 #include "esp_system.h"
+#include "esp_timer.h"
 
 #include "event_loop.hpp"
+#include "nonvolatile_storage.hpp"
 
 #include "wifi.hpp"
 
@@ -14,6 +16,7 @@ namespace wifi
 {
 
 using namespace event_loop;
+using namespace nonvolatile_storage;
 
 const char *const WiFi::LOG_TAG = "WIFI";
 
@@ -35,12 +38,49 @@ EventGroupHandle_t WiFi::event_group = nullptr;
 uint32_t WiFi::retry_count = 0;
 const uint32_t WiFi::MAX_RETRY_COUNT = 10;
 
+const char *const WiFi::nvs_namespace = "WIFI";
+const char *const WiFi::fast_connect_key = "fast_connect";
+const uint32_t WiFi::FAST_CONNECT_RETRY_COUNT = 2;
+
+bool WiFi::fast_connect = false;
+
+int64_t WiFi::start_timestamp = 0;
+
+WiFi::ConnectInfo WiFi::connect_info = {};
+
+wifi_config_t WiFi::sta_config = {};
+
+portMUX_TYPE WiFi::spinlock = portMUX_INITIALIZER_UNLOCKED;
+
+wifi_ps_type_t WiFi::current_power_save = WIFI_PS_NONE;
+
+int64_t WiFi::connected_timestamp = 0;
+
+WiFi::PowerSaveStatistics WiFi::power_save_statistics[WIFI_PS_MAX_MODEM + 1] = {
+    {WIFI_PS_NONE, 0, 0, 0, 0},
+    {WIFI_PS_MIN_MODEM, 0, 0, 0, 0},
+    {WIFI_PS_MAX_MODEM, 0, 0, 0, 0},
+};
+
+void WiFi::update_connected_time(const int64_t now)
+{
+    // 调用者已设置临界区
+    if (0 != connected_timestamp) {
+        power_save_statistics[current_power_save].ConnectedTime += now - connected_timestamp;
+        connected_timestamp = now;
+    }
+}
+
 void WiFi::event_handler(void *args, esp_event_base_t event_base, int32_t event_id, void* event_data)
 {
     if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
         ESP_ERROR_CHECK(esp_wifi_connect());
     } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
         wifi_event_sta_disconnected_t* disconnected = (wifi_event_sta_disconnected_t*) event_data;
+        portENTER_CRITICAL(&spinlock);
+        update_connected_time(esp_timer_get_time());
+        connected_timestamp = 0;
+        portEXIT_CRITICAL(&spinlock);
         ESP_LOGD(LOG_TAG, 
                  "disconnect ssid: %s, ssid len: %d, reason: %d", 
                  disconnected->ssid,
@@ -48,7 +88,17 @@ void WiFi::event_handler(void *args, esp_event_base_t event_base, int32_t event_
                  disconnected->reason);
         // 仅在初始启动时有最大重连次数限制，运行中将不断尝试重连
         if (event_group != nullptr) {
-            if (retry_count <MAX_RETRY_COUNT) {
+            if (true == fast_connect && retry_count >= FAST_CONNECT_RETRY_COUNT) {
+                // 缓存的AP不可用，改为扫描全部信道
+                ESP_LOGW(LOG_TAG, "fast connect failed, fall back to full scan");
+                fast_connect = false;
+                retry_count = 0;
+                sta_config.sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
+                sta_config.sta.bssid_set = false;
+                sta_config.sta.channel = 0;
+                ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &sta_config));
+                ESP_ERROR_CHECK(esp_wifi_connect());
+            } else if (retry_count <MAX_RETRY_COUNT) {
                 ESP_ERROR_CHECK(esp_wifi_connect());
                 retry_count++;
             } else {
@@ -58,22 +108,118 @@ void WiFi::event_handler(void *args, esp_event_base_t event_base, int32_t event_
             }
         } else {
             if (true == start_flag) {
+                if (true == sta_config.sta.bssid_set) {
+                    // 运行中重连时不再固定上次的AP和信道，扫描全部信道，以便切换到其他AP
+                    ESP_LOGD(LOG_TAG, "clear fast connect pin, reconnect with full scan");
+                    fast_connect = false;
+                    sta_config.sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
+                    sta_config.sta.bssid_set = false;
+                    sta_config.sta.channel = 0;
+                    esp_wifi_set_config(WIFI_IF_STA, &sta_config);
+                }
                 esp_wifi_connect();
             }
         }
+    } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_CONNECTED) {
+        int64_t now = esp_timer_get_time();
+        portENTER_CRITICAL(&spinlock);
+        connected_timestamp = now;
+        portEXIT_CRITICAL(&spinlock);
+        if (nullptr != event_group) {
+            connect_info.AssociationTime = now - start_timestamp;
+        }
     } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
         ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
         ESP_LOGI(LOG_TAG, "got ip:" IPSTR, IP2STR(&event->ip_info.ip));
         if (nullptr != event_group) {
+            connect_info.GotIPTime = esp_timer_get_time() - start_timestamp;
             xEventGroupSetBits(event_group, WIFI_SUCCESS_BIT);
         }
     }
 }   
 
-bool WiFi::Start(const wifi_mode_t &mode, const std::string &ssid, const std::string &password, const std::string &hostname)
+bool WiFi::set_static_ip(const StaticIP &static_ip)
+{
+    esp_netif_ip_info_t ip_info = {};
+    esp_netif_dns_info_t dns_info = {};
+    if (ESP_OK != esp_netif_str_to_ip4(static_ip.IP.c_str(), &ip_info.ip)
+        || ESP_OK != esp_netif_str_to_ip4(static_ip.Netmask.c_str(), &ip_info.netmask)
+        || ESP_OK != esp_netif_str_to_ip4(static_ip.Gateway.c_str(), &ip_info.gw)) {
+        ESP_LOGE(LOG_TAG, "invalid static ip %s/%s via %s",
+                 static_ip.IP.c_str(), static_ip.Netmask.c_str(), static_ip.Gateway.c_str());
+        return false;
+    }
+    esp_err_t err = esp_netif_dhcpc_stop(netif);
+    if (ESP_OK != err && ESP_ERR_ESP_NETIF_DHCP_ALREADY_STOPPED != err) {
+        ESP_LOGE(LOG_TAG, "stop dhcp client failed, the reason is %d", err);
+        return false;
+    }
+    ESP_ERROR_CHECK(esp_netif_set_ip_info(netif, &ip_info));
+    // DNS为空时使用网关
+    if (0 == static_ip.DNS.length()) {
+        dns_info.ip.u_addr.ip4 = ip_info.gw;
+    } else if (ESP_OK != esp_netif_str_to_ip4(static_ip.DNS.c_str(), &dns_info.ip.u_addr.ip4)) {
+        ESP_LOGE(LOG_TAG, "invalid dns %s", static_ip.DNS.c_str());
+        return false;
+    }
+    dns_info.ip.type = ESP_IPADDR_TYPE_V4;
+    ESP_ERROR_CHECK(esp_netif_set_dns_info(netif, ESP_NETIF_DNS_MAIN, &dns_info));
+    ESP_LOGI(LOG_TAG, "static ip: %s", static_ip.IP.c_str());
+    return true;
+}
+
+bool WiFi::load_fast_connect_record(const std::string &ssid, FastConnectRecord &record)
+{
+    std::string data;
+    if (false == NonvolatileStorage::ReadBlob(nvs_namespace, fast_connect_key, data)) {
+        return false;
+    }
+    if (sizeof(record) != data.length()) {
+        ESP_LOGW(LOG_TAG, "fast connect record size %d error", data.length());
+        return false;
+    }
+    memcpy(&record, data.data(), sizeof(record));
+    // SSID变化后缓存失效
+    if (0 != strncmp((const char *)record.SSID, ssid.c_str(), sizeof(record.SSID))) {
+        return false;
+    }
+    return 0 != record.Channel;
+}
+
+void WiFi::save_fast_connect_record()
+{
+    wifi_ap_record_t ap_info;
+    FastConnectRecord record = {};
+    FastConnectRecord last_record;
+    if (ESP_OK != esp_wifi_sta_get_ap_info(&ap_info)) {
+        return;
+    }
+    memcpy(record.SSID, sta_config.sta.ssid, sizeof(record.SSID));
+    memcpy(record.BSSID, ap_info.bssid, sizeof(record.BSSID));
+    record.Channel = ap_info.primary;
+    // 未变化时不写入
+    if (load_fast_connect_record(std::string((const char *)sta_config.sta.ssid, strnlen((const char *)sta_config.sta.ssid, 32)), last_record)
+        && 0 == memcmp(&record, &last_record, sizeof(record))) {
+        return;
+    }
+    if (NonvolatileStorage::WriteBlob(nvs_namespace,
+                                      fast_connect_key,
+                                      std::string((const char *)&record, sizeof(record)))) {
+        ESP_LOGD(LOG_TAG, "save fast connect record, channel: %u", record.Channel);
+    }
+}
+
+bool WiFi::Start(const wifi_mode_t &mode,
+                 const std::string &ssid,
+                 const std::string &password,
+                 const std::string &hostname,
+                 const StaticIP &static_ip,
+                 const wifi_ps_type_t power_save,
+                 const uint16_t listen_interval)
 {
     bool result = true;
     EventBits_t event_bits;
+    FastConnectRecord record;
     wifi_config_t wifi_config = {};
     wifi_init_config_t wifi_init_config = WIFI_INIT_CONFIG_DEFAULT();
     // 设置临界区
@@ -93,6 +239,14 @@ bool WiFi::Start(const wifi_mode_t &mode, const std::string &ssid, const std::st
         if (0 < hostname.length()) {
             ESP_ERROR_CHECK(esp_netif_set_hostname(netif, hostname.c_str()));
         }
+        if (0 < static_ip.IP.length() && false == set_static_ip(static_ip)) {
+            vEventGroupDelete(event_group);
+            event_group = nullptr;
+            esp_netif_destroy(netif);
+            netif = nullptr;
+            result = false;
+            goto DONE;
+        }
         ESP_ERROR_CHECK(esp_wifi_init(&wifi_init_config));
         ESP_ERROR_CHECK(esp_wifi_set_storage(WIFI_STORAGE_RAM));
         esp_event_handler_instance_t instance_got_ip;
@@ -106,18 +260,37 @@ bool WiFi::Start(const wifi_mode_t &mode, const std::string &ssid, const std::st
                                                             &event_handler,
                                                             nullptr,
                                                             &instance_got_ip));
-        wifi_config.sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
         wifi_config.sta.sort_method = WIFI_CONNECT_AP_BY_SIGNAL;
         wifi_config.sta.threshold.authmode = WIFI_AUTH_WPA2_PSK;
-        wifi_config.sta.bssid_set = false;
-        wifi_config.sta.channel = 0;
         memset(wifi_config.sta.ssid, 0, 32); 
         memcpy(wifi_config.sta.ssid, ssid.c_str(), ssid.length());
         memset(wifi_config.sta.password, 0, 64); 
         memcpy(wifi_config.sta.password, password.c_str(), password.length());
+        fast_connect = load_fast_connect_record(ssid, record);
+        if (true == fast_connect) {
+            // 直接连接上次的AP，省去扫描全部信道
+            wifi_config.sta.scan_method = WIFI_FAST_SCAN;
+            wifi_config.sta.bssid_set = true;
+            memcpy(wifi_config.sta.bssid, record.BSSID, sizeof(record.BSSID));
+            wifi_config.sta.channel = record.Channel;
+            ESP_LOGD(LOG_TAG, "fast connect, channel: %u", record.Channel);
+        } else {
+            wifi_config.sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
+            wifi_config.sta.bssid_set = false;
+            wifi_config.sta.channel = 0;
+        }
+        wifi_config.sta.listen_interval = listen_interval;
+        sta_config = wifi_config;
+        connect_info = {};
+        connect_info.FastConnect = fast_connect;
+        retry_count = 0;
+        start_timestamp = esp_timer_get_time();
         ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
         ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
         ESP_ERROR_CHECK(esp_wifi_start());
+        ESP_ERROR_CHECK(esp_wifi_set_ps(power_save));
+        current_power_save = power_save;
+        ESP_LOGD(LOG_TAG, "power save: %d, listen interval: %u", power_save, listen_interval);
         event_bits = xEventGroupWaitBits(event_group,
                                          WIFI_SUCCESS_BIT | WIFI_FAILURE_BIT,
                                          pdFALSE,
@@ -127,7 +300,13 @@ bool WiFi::Start(const wifi_mode_t &mode, const std::string &ssid, const std::st
         vEventGroupDelete(event_group);  
         event_group = nullptr;
         if (event_bits & WIFI_SUCCESS_BIT) {
-            ESP_LOGD(LOG_TAG, "connected to ap");
+            // 回退到扫描全部信道时以实际结果为准
+            connect_info.FastConnect = fast_connect;
+            ESP_LOGI(LOG_TAG, "connected to ap, %s, associated in %lld ms, got ip in %lld ms",
+                     connect_info.FastConnect ? "fast connect" : "full scan",
+                     connect_info.AssociationTime / 1000,
+                     connect_info.GotIPTime / 1000);
+            save_fast_connect_record();
         } else if (event_bits & WIFI_FAILURE_BIT) {
             result = false;
             ESP_LOGD(LOG_TAG, "failed to connect to ap");
@@ -154,7 +333,9 @@ bool WiFi::Start(const wifi_mode_t &mode, const std::string &ssid, const std::st
         memcpy(wifi_config.ap.password, password.c_str(), password.length());
         ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_AP));
         ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_AP, &wifi_config));
+        // AP需持续接收，不使用省电模式
         ESP_ERROR_CHECK(esp_wifi_set_ps(WIFI_PS_NONE));
+        current_power_save = WIFI_PS_NONE;
         ESP_ERROR_CHECK(esp_wifi_start());
         ESP_LOGD(LOG_TAG, "ap start");
         WiFi::start_flag = true;
@@ -178,6 +359,10 @@ void WiFi::Stop()
     start_flag = false;
     if (WIFI_MODE_STA == current_mode) {
         esp_event_handler_instance_unregister(WIFI_EVENT, ESP_EVENT_ANY_ID, event_handler_instance);
+        portENTER_CRITICAL(&spinlock);
+        update_connected_time(esp_timer_get_time());
+        connected_timestamp = 0;
+        portEXIT_CRITICAL(&spinlock);
         event_handler_instance = nullptr;
         esp_wifi_disconnect();
     }
@@ -199,6 +384,85 @@ esp_netif_t *WiFi::GetNetif()
     return netif;
 }
 
+bool WiFi::SetPowerSave(const wifi_ps_type_t power_save)
+{
+    bool result = true;
+    esp_err_t err;
+    // 设置临界区
+    xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
+    if (false == start_flag || WIFI_MODE_STA != current_mode) {
+        ESP_LOGE(LOG_TAG, "power save is only available in sta mode");
+        result = false;
+        goto DONE;
+    }
+    err = esp_wifi_set_ps(power_save);
+    if (ESP_OK != err) {
+        ESP_LOGE(LOG_TAG, "set power save failed, the reason is %d", err);
+        result = false;
+        goto DONE;
+    }
+    portENTER_CRITICAL(&spinlock);
+    update_connected_time(esp_timer_get_time());
+    current_power_save = power_save;
+    portEXIT_CRITICAL(&spinlock);
+    ESP_LOGI(LOG_TAG, "power save: %d", power_save);
+DONE:
+    // 退出临界区
+    xSemaphoreGiveRecursive(mutex);
+    return result;
+}
+
+void WiFi::RecordLatency(const uint32_t latency)
+{
+    portENTER_CRITICAL(&spinlock);
+    auto &statistics = power_save_statistics[current_power_save];
+    statistics.LatencyCount++;
+    statistics.TotalLatency += latency;
+    if (latency > statistics.MaxLatency) {
+        statistics.MaxLatency = latency;
+    }
+    portEXIT_CRITICAL(&spinlock);
+}
+
+std::vector<WiFi::PowerSaveStatistics> WiFi::GetPowerSaveStatistics()
+{
+    PowerSaveStatistics statistics[WIFI_PS_MAX_MODEM + 1];
+    int64_t now = esp_timer_get_time();
+    // 临界区内不分配内存
+    portENTER_CRITICAL(&spinlock);
+    // 计入当前连接尚未累计的时间
+    update_connected_time(now);
+    memcpy(statistics, power_save_statistics, sizeof(statistics));
+    portEXIT_CRITICAL(&spinlock);
+    return std::vector<PowerSaveStatistics>(statistics, statistics + WIFI_PS_MAX_MODEM + 1);
+}
+
+void WiFi::LogPowerSaveStatistics()
+{
+    const char *const names[] = {"none", "min modem", "max modem"};
+    auto statistics_list = GetPowerSaveStatistics();
+    ESP_LOGI(LOG_TAG, "      power save  connected(s)     count  avg latency  max latency (us)");
+    for (auto &statistics : statistics_list) {
+        ESP_LOGI(LOG_TAG, "%16s  %12lld  %8lu  %11llu  %11lu",
+                 names[statistics.Type],
+                 statistics.ConnectedTime / 1000000,
+                 statistics.LatencyCount,
+                 0 == statistics.LatencyCount ? 0 : statistics.TotalLatency / statistics.LatencyCount,
+                 statistics.MaxLatency);
+    }
+}
+
+WiFi::ConnectInfo WiFi::GetConnectInfo()
+{
+    ConnectInfo info;
+    // 设置临界区
+    xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
+    info = connect_info;
+    // 退出临界区
+    xSemaphoreGiveRecursive(mutex);
+    return info;
+}
+
 }
 
 }
@@ -2,6 +2,7 @@
 #define _wifi_hpp_
 
 #include <string>
+#include <vector>
 
 #include "esp_event.h"
 #include "esp_wifi.h"
@@ -18,12 +19,95 @@ namespace wifi
 class WiFi
 {
     public:
+        // STA的静态IP，IP为空时使用DHCP
+        struct StaticIP {
+            std::string IP;
+            std::string Netmask;
+            std::string Gateway;
+            std::string DNS;
+        };
+        // 启动时的连接耗时
+        struct ConnectInfo {
+            bool FastConnect;           // 是否通过缓存的BSSID及信道连接
+            int64_t AssociationTime;    // 从启动到关联成功（微秒）
+            int64_t GotIPTime;          // 从启动到获取IP（微秒）
+        };
+        // 各省电模式下的统计
+        struct PowerSaveStatistics {
+            wifi_ps_type_t Type;
+            int64_t ConnectedTime;      // 该模式下保持连接的时间（微秒）
+            uint32_t LatencyCount;      // 上传次数
+            uint64_t TotalLatency;      // 微秒
+            uint32_t MaxLatency;        // 微秒
+        };
         // 日志标签
         static const char *const LOG_TAG;
-        static bool Start(const wifi_mode_t &mode, const std::string &ssid, const std::string &password, const std::string &hostname="");
+        /**
+         * @brief 启动
+         * STA模式下优先使用上次连接成功的BSSID及信道直接连接，失败后再扫描全部信道；运行中断开后总是扫描全部信道重连
+         *
+         * @param static_ip 静态IP，仅STA模式有效
+         * @param power_save 省电模式，仅STA模式有效，AP模式不省电
+         * @param listen_interval 最大省电模式下接收信标的间隔（信标周期数），关联时生效
+         */
+        static bool Start(const wifi_mode_t &mode,
+                          const std::string &ssid,
+                          const std::string &password,
+                          const std::string &hostname="",
+                          const StaticIP &static_ip={},
+                          const wifi_ps_type_t power_save=WIFI_PS_MIN_MODEM,
+                          const uint16_t listen_interval=3);
         static void Stop();
         static esp_netif_t *GetNetif();
+        /**
+         * @brief 获取启动时的连接耗时
+         */
+        static ConnectInfo GetConnectInfo();
+        /**
+         * @brief 运行中切换省电模式，仅STA模式有效
+         *
+         * @param power_save 省电模式
+         */
+        static bool SetPowerSave(const wifi_ps_type_t power_save);
+        /**
+         * @brief 记录一次上传的耗时，计入当前的省电模式
+         *
+         * @param latency 耗时（微秒）
+         */
+        static void RecordLatency(const uint32_t latency);
+        /**
+         * @brief 获取各省电模式下的统计
+         */
+        static std::vector<PowerSaveStatistics> GetPowerSaveStatistics();
+        /**
+         * @brief 输出各省电模式下的统计
+         */
+        static void LogPowerSaveStatistics();
     private:
+        // 上次连接成功的AP，保存在NVS中
+        struct FastConnectRecord {
+            uint8_t SSID[32];
+            uint8_t BSSID[6];
+            uint8_t Channel;
+        };
+        static const char *const nvs_namespace;
+        static const char *const fast_connect_key;
+        // 直接连接失败后改为扫描全部信道前的重试次数
+        static const uint32_t FAST_CONNECT_RETRY_COUNT;
+        static bool fast_connect;
+        static int64_t start_timestamp;
+        static ConnectInfo connect_info;
+        static wifi_config_t sta_config;
+        // 保护省电统计，事件处理及上传任务中均会更新
+        static portMUX_TYPE spinlock;
+        static wifi_ps_type_t current_power_save;
+        // 本次连接（或切换模式）的开始时间，未连接时为0
+        static int64_t connected_timestamp;
+        static PowerSaveStatistics power_save_statistics[WIFI_PS_MAX_MODEM + 1];
+        static void update_connected_time(const int64_t now);
+        static bool set_static_ip(const StaticIP &static_ip);
+        static bool load_fast_connect_record(const std::string &ssid, FastConnectRecord &record);
+        static void save_fast_connect_record();
         static SemaphoreHandle_t mutex;
         static bool start_flag;
         static void event_handler(void *args, esp_event_base_t event_base, int32_t event_id, void* event_data);
@@ -12,6 +12,23 @@ namespace cubestone_wang
 namespace wifi
 {
 
+// 二进制格式的字段号
+enum Field : uint8_t {
+    FIELD_MODE = 1,
+    FIELD_AP_SSID = 2,
+    FIELD_AP_PASSWORD = 3,
+    FIELD_AP_HOSTNAME = 4,
+    FIELD_STA_SSID = 5,
+    FIELD_STA_PASSWORD = 6,
+    FIELD_STA_HOSTNAME = 7,
+    FIELD_STATIC_IP = 8,
+    FIELD_STATIC_NETMASK = 9,
+    FIELD_STATIC_GATEWAY = 10,
+    FIELD_STATIC_DNS = 11,
+    FIELD_POWER_SAVE = 12,
+    FIELD_LISTEN_INTERVAL = 13,
+};
+
 const char *const Config::LOG_TAG = "WIFI_CONFIG";
 const char *const Config::default_ap_password = "12345678";
 const char *const Config::default_sta_ssid = "";
@@ -20,45 +37,40 @@ const char *const Config::default_sta_password = "";
 Config::Config()
 {
     uint8_t mac_address[6];
-    default_ap_ssid = new char[13];
-    default_ap_hostname = new char[13];
-    default_sta_hostname = new char[13];
-    memset(default_ap_ssid, 0, sizeof(char) * 13); 
-    memset(default_ap_hostname, 0, sizeof(char) * 13); 
-    memset(default_sta_hostname, 0, sizeof(char) * 13); 
+    char buffer[13] = {0};
     ESP_ERROR_CHECK(esp_read_mac(mac_address, ESP_MAC_WIFI_SOFTAP));
-    sprintf(default_ap_ssid,  "esp32_%02x%02x%02x", mac_address[3], mac_address[4], mac_address[5]);
-    sprintf(default_ap_hostname, "esp32_%02x%02x%02x", mac_address[3], mac_address[4], mac_address[5]);
+    sprintf(buffer, "esp32_%02x%02x%02x", mac_address[3], mac_address[4], mac_address[5]);
+    default_ap_ssid = buffer;
+    default_ap_hostname = buffer;
     ESP_ERROR_CHECK(esp_read_mac(mac_address, ESP_MAC_WIFI_STA));
-    sprintf(default_sta_hostname, "esp32_%02x%02x%02x", mac_address[3], mac_address[4], mac_address[5]);
-}
-
-Config::~Config()
-{
-    delete default_ap_ssid;
-    default_ap_ssid = nullptr;
-    delete default_ap_hostname;
-    default_ap_hostname = nullptr;
-    delete default_sta_hostname;
-    default_sta_hostname = nullptr;
+    sprintf(buffer, "esp32_%02x%02x%02x", mac_address[3], mac_address[4], mac_address[5]);
+    default_sta_hostname = buffer;
 }
 
 void Config::Reset()
 {   
     Mode = WIFI_MODE_STA;
+    PowerSave = WIFI_PS_MIN_MODEM;
+    ListenInterval = 3;
     AP.SSID = default_ap_ssid;
     AP.Password = default_ap_password;
     AP.Hostname = default_ap_hostname;
     STA.SSID = default_sta_ssid;
     STA.Password = default_sta_password;
     STA.Hostname = default_sta_hostname;
+    StaticIP.IP = "";
+    StaticIP.Netmask = "";
+    StaticIP.Gateway = "";
+    StaticIP.DNS = "";
 }
 
-std::string Config::Dump()
+std::string Config::Dump() const
 {
     cJSON *json_root = cJSON_CreateObject();
     cJSON *json_item;
     cJSON_AddNumberToObject(json_root, "mode", Mode);	
+    cJSON_AddNumberToObject(json_root, "power_save", PowerSave);
+    cJSON_AddNumberToObject(json_root, "listen_interval", ListenInterval);
     json_item = cJSON_AddObjectToObject(json_root, "ap");
     cJSON_AddStringToObject(json_item, "ssid", AP.SSID.c_str());
     cJSON_AddStringToObject(json_item, "password", AP.Password.c_str());
@@ -67,6 +79,11 @@ std::string Config::Dump()
     cJSON_AddStringToObject(json_item, "ssid", STA.SSID.c_str());
     cJSON_AddStringToObject(json_item, "password", STA.Password.c_str());   
     cJSON_AddStringToObject(json_item, "hostname", STA.Hostname.c_str());
+    json_item = cJSON_AddObjectToObject(json_root, "static_ip");
+    cJSON_AddStringToObject(json_item, "ip", StaticIP.IP.c_str());
+    cJSON_AddStringToObject(json_item, "netmask", StaticIP.Netmask.c_str());
+    cJSON_AddStringToObject(json_item, "gateway", StaticIP.Gateway.c_str());
+    cJSON_AddStringToObject(json_item, "dns", StaticIP.DNS.c_str());
     char *json_data = cJSON_PrintUnformatted(json_root);
     std::string result = std::string(json_data);
     cJSON_free(json_data);
@@ -102,6 +119,26 @@ bool Config::Load(const char *const config_data)
         cJSON_Delete(json_root); 
         return false;
     }
+    json_item = cJSON_GetObjectItem(json_root, "power_save");
+    if (NULL == json_item) {
+        PowerSave = WIFI_PS_MIN_MODEM;
+    } else if (cJSON_Number != json_item->type || json_item->valueint < WIFI_PS_NONE || json_item->valueint > WIFI_PS_MAX_MODEM) {
+        ESP_LOGE(LOG_TAG, "power save error");
+        cJSON_Delete(json_root); 
+        return false;
+    } else {
+        PowerSave = (wifi_ps_type_t)json_item->valueint;
+    }
+    json_item = cJSON_GetObjectItem(json_root, "listen_interval");
+    if (NULL == json_item) {
+        ListenInterval = 3;
+    } else if (cJSON_Number != json_item->type || json_item->valueint < 0 || json_item->valueint > UINT16_MAX) {
+        ESP_LOGE(LOG_TAG, "listen interval error");
+        cJSON_Delete(json_root); 
+        return false;
+    } else {
+        ListenInterval = json_item->valueint;
+    }
     json_item = cJSON_GetObjectItem(json_root, "ap");
     if (NULL == json_item) {
         
@@ -183,6 +220,30 @@ bool Config::Load(const char *const config_data)
             STA.Hostname = json_sub_item->valuestring;
         }
     }
+    StaticIP.IP = "";
+    StaticIP.Netmask = "";
+    StaticIP.Gateway = "";
+    StaticIP.DNS = "";
+    json_item = cJSON_GetObjectItem(json_root, "static_ip");
+    if (NULL != json_item && cJSON_Object != json_item->type) {
+        ESP_LOGE(LOG_TAG, "static ip error");
+        cJSON_Delete(json_root); 
+        return false;
+    } else if (NULL != json_item) {
+        const char *const names[] = {"ip", "netmask", "gateway", "dns"};
+        std::string *const values[] = {&StaticIP.IP, &StaticIP.Netmask, &StaticIP.Gateway, &StaticIP.DNS};
+        for (uint8_t index=0; index<4; index++) {
+            json_sub_item = cJSON_GetObjectItem(json_item, names[index]);
+            if (NULL == json_sub_item) {
+                continue;
+            } else if (cJSON_String != json_sub_item->type) {
+                ESP_LOGE(LOG_TAG, "static ip %s error", names[index]);
+                cJSON_Delete(json_root); 
+                return false;
+            }
+            *values[index] = json_sub_item->valuestring;
+        }
+    }
     cJSON_Delete(json_root); 
     return true;
 }
@@ -196,6 +257,97 @@ bool Config::Load(const std::string &config_data)
     }
 }
 
+config::BaseConfig *Config::Clone() const
+{
+    return new Config(*this);
+}
+
+void Config::Encode(config::BinaryEncoder &encoder) const
+{
+    encoder.WriteUInt(FIELD_MODE, Mode);
+    encoder.WriteUInt(FIELD_POWER_SAVE, PowerSave);
+    encoder.WriteUInt(FIELD_LISTEN_INTERVAL, ListenInterval);
+    encoder.WriteString(FIELD_AP_SSID, AP.SSID);
+    encoder.WriteString(FIELD_AP_PASSWORD, AP.Password);
+    encoder.WriteString(FIELD_AP_HOSTNAME, AP.Hostname);
+    encoder.WriteString(FIELD_STA_SSID, STA.SSID);
+    encoder.WriteString(FIELD_STA_PASSWORD, STA.Password);
+    encoder.WriteString(FIELD_STA_HOSTNAME, STA.Hostname);
+    // 未设置静态IP时不写入
+    if (0 < StaticIP.IP.length()) {
+        encoder.WriteString(FIELD_STATIC_IP, StaticIP.IP);
+        encoder.WriteString(FIELD_STATIC_NETMASK, StaticIP.Netmask);
+        encoder.WriteString(FIELD_STATIC_GATEWAY, StaticIP.Gateway);
+        encoder.WriteString(FIELD_STATIC_DNS, StaticIP.DNS);
+    }
+}
+
+bool Config::Decode(config::BinaryDecoder &decoder, const uint8_t schema_version)
+{
+    uint32_t value;
+    bool result;
+    while (decoder.Next()) {
+        switch (decoder.GetField()) {
+            case FIELD_MODE:
+                result = decoder.GetUInt(value) && (WIFI_MODE_AP == value || WIFI_MODE_STA == value);
+                if (result) {
+                    Mode = (wifi_mode_t)value;
+                }
+                break;
+            case FIELD_POWER_SAVE:
+                result = decoder.GetUInt(value) && value <= WIFI_PS_MAX_MODEM;
+                if (result) {
+                    PowerSave = (wifi_ps_type_t)value;
+                }
+                break;
+            case FIELD_LISTEN_INTERVAL:
+                result = decoder.GetUInt(value) && value <= UINT16_MAX;
+                if (result) {
+                    ListenInterval = value;
+                }
+                break;
+            case FIELD_AP_SSID:
+                result = decoder.GetString(AP.SSID);
+                break;
+            case FIELD_AP_PASSWORD:
+                result = decoder.GetString(AP.Password);
+                break;
+            case FIELD_AP_HOSTNAME:
+                result = decoder.GetString(AP.Hostname);
+                break;
+            case FIELD_STA_SSID:
+                result = decoder.GetString(STA.SSID);
+                break;
+            case FIELD_STA_PASSWORD:
+                result = decoder.GetString(STA.Password);
+                break;
+            case FIELD_STA_HOSTNAME:
+                result = decoder.GetString(STA.Hostname);
+                break;
+            case FIELD_STATIC_IP:
+                result = decoder.GetString(StaticIP.IP);
+                break;
+            case FIELD_STATIC_NETMASK:
+                result = decoder.GetString(StaticIP.Netmask);
+                break;
+            case FIELD_STATIC_GATEWAY:
+                result = decoder.GetString(StaticIP.Gateway);
+                break;
+            case FIELD_STATIC_DNS:
+                result = decoder.GetString(StaticIP.DNS);
+                break;
+            default:
+                result = true;
+                break;
+        }
+        if (false == result) {
+            ESP_LOGE(LOG_TAG, "field %u error", decoder.GetField());
+            return false;
+        }
+    }
+    return true;
+}
+
 }
 
 }
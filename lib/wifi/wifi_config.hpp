@@ -23,19 +23,32 @@ class Config: public config::BaseConfig
             std::string Password;
             std::string Hostname;
         } AP, STA;
+        // STA的静态IP，IP为空时使用DHCP，DNS为空时使用网关
+        struct
+        {
+            std::string IP;
+            std::string Netmask;
+            std::string Gateway;
+            std::string DNS;
+        } StaticIP;
         wifi_mode_t Mode;
+        // STA的省电模式，及最大省电模式下接收信标的间隔（信标周期数）
+        wifi_ps_type_t PowerSave;
+        uint16_t ListenInterval;
         // 日志标签
         static const char *const LOG_TAG;
         Config();
-        virtual ~Config();
         void Reset();
-        std::string Dump();
+        std::string Dump() const;
         bool Load(const char *const config_data);
         bool Load(const std::string &config_data);
+        void Encode(config::BinaryEncoder &encoder) const;
+        config::BaseConfig *Clone() const;
+        bool Decode(config::BinaryDecoder &decoder, const uint8_t schema_version);
     private:
-        char *default_ap_ssid;
-        char *default_ap_hostname;
-        char *default_sta_hostname;
+        std::string default_ap_ssid;
+        std::string default_ap_hostname;
+        std::string default_sta_hostname;
         static const char *const default_ap_password;
         static const char *const default_sta_ssid;
         static const char *const default_sta_password;
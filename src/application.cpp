@@ -6,28 +6,37 @@
 #include "esp_system.h"
 #include "esp_wifi.h"
 #include "esp_task_wdt.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
 #include "freertos/task.h"
 #include "lwip/netdb.h"
 
+#include "boot_sequence.hpp"
 #include "button_manager.hpp"
 #include "config_manager.hpp"
 #include "influxdb_config.hpp"
 #include "mdns_config.hpp"
 #include "mdns.hpp"
 #include "monochrome_led.hpp"
+#include "mqtt_config.hpp"
+#include "mqtt.hpp"
 #include "monochrome_led_manager.hpp"
+#include "mutex.hpp"
 #include "ntp_config.hpp"
 #include "ntp.hpp"
+#include "resolver.hpp"
 #include "scheduled_restart_config.hpp"
 #include "scheduled_restart.hpp"
 #include "sgp30_config.hpp"
+#include "stack_profiler.hpp"
 #include "system.hpp"
+#include "task_placement.hpp"
 #include "wifi_config.hpp"
 #include "wifi.hpp"
 
 #include "screen/screen.hpp"
+#include "screen/screen_config.hpp"
 
 #include "application.hpp"
 
@@ -54,6 +63,14 @@ std::string Application::influxdb_config_name = "influxdb";
 std::string Application::ntp_config_name = "ntp";
 std::string Application::mdns_config_name = "mdns";
 std::string Application::wifi_config_name = "wifi";
+std::string Application::mqtt_config_name = "mqtt";
+std::string Application::screen_config_name = "screen";
+monochrome_led::MonochromeLEDManager::Handle_t Application::wifi_monochrome_led = monochrome_led::MonochromeLEDManager::INVALID_HANDLE;
+monochrome_led::MonochromeLEDManager::Handle_t Application::pm25_monochrome_led = monochrome_led::MonochromeLEDManager::INVALID_HANDLE;
+monochrome_led::MonochromeLEDManager::Handle_t Application::co2_monochrome_led = monochrome_led::MonochromeLEDManager::INVALID_HANDLE;
+monochrome_led::MonochromeLEDManager::Handle_t Application::tvoc_monochrome_led = monochrome_led::MonochromeLEDManager::INVALID_HANDLE;
+monochrome_led::MonochromeLEDManager::Handle_t Application::inner_monochrome_led = monochrome_led::MonochromeLEDManager::INVALID_HANDLE;
+config::ConfigManager::Handle_t Application::sgp30_config = config::ConfigManager::INVALID_HANDLE;
 
 i2c_master::I2cMaster *Application::i2c_master_0 = nullptr;
 i2c_master::I2cMaster *Application::i2c_master_1 = nullptr;
@@ -63,7 +80,10 @@ sensor::PM2005 *Application::pm2005 = nullptr;
 sensor::SGP30 *Application::sgp30 = nullptr;
 sensor::ZE08_CH2O *Application::ze08_ch2o = nullptr;
 influxdb::Influxdb *Application::influxdb = nullptr;
-QueueHandle_t Application::influxdb_queue = xQueueCreate(100, sizeof(influxdb::Point *));
+influxdb::InfluxdbUDP *Application::influxdb_udp = nullptr;
+QueueHandle_t Application::influxdb_queue = xQueueCreate(100, sizeof(Application::Sample));
+QueueHandle_t Application::action_queue = xQueueCreate(4, sizeof(Application::Action));
+metrics::MetricsServer::Handle_t Application::gauges[Application::GAUGE_MAX] = {};
 
 bool Application::init()
 {
@@ -76,16 +96,31 @@ bool Application::init()
     if (false == Application::init_button()) {
         return false;
     }
-    if (false == Application::init_config()) {
+    if (false == Application::init_metrics()) {
         return false;
     }
-    if (false == Application::init_i2c()) {
-        return false;
-    }
-    if (false == Application::init_uart()) {
+    button::ButtonManager::Start();
+    monochrome_led::MonochromeLEDManager::Start();
+    monochrome_led::MonochromeLEDManager::SetBlink(Application::inner_monochrome_led, 500, 500);
+    monochrome_led::MonochromeLEDManager::SetBlink(Application::wifi_monochrome_led, 250, 250);
+    // 传感器与网络并行启动，传感器就绪后即开始采样，网络服务在后台继续启动
+    boot::BootSequence::Add("config", Application::init_config);
+    boot::BootSequence::Add("i2c", Application::init_i2c, {"config"});
+    boot::BootSequence::Add("uart", Application::init_uart);
+    boot::BootSequence::Add("time", Application::restore_time, {"config"});
+    boot::BootSequence::Add("influxdb", Application::init_influxdb, {"config"});
+    boot::BootSequence::Add("wifi", Application::start_wifi, {"config"});
+    boot::BootSequence::Add("ntp", Application::start_ntp, {"wifi"});
+    boot::BootSequence::Add("restart", Application::start_scheduled_restart, {"ntp"});
+    boot::BootSequence::Add("metrics", Application::start_metrics, {"wifi"});
+    boot::BootSequence::Add("mdns", Application::start_mdns, {"wifi"});
+    boot::BootSequence::Add("mqtt", Application::start_mqtt, {"wifi"});
+    boot::BootSequence::Start();
+    // 只等待采样所需的阶段
+    if (false == boot::BootSequence::Wait("i2c")) {
         return false;
     }
-    if (false == Application::init_influxdb()) {
+    if (false == boot::BootSequence::Wait("uart")) {
         return false;
     }
     return true;
@@ -109,130 +144,173 @@ bool Application::init_button()
     auto button_name = std::string("button");
     button::ButtonManager::Add(button_name, GPIO_NUM_34);
     // 设置回调函数
-    button::ButtonManager::SetClickCallbackFunction(button_name, [](void *_monochrome_led_name) {
-        auto func = [](void *_monochrome_led_name)
+    button::ButtonManager::SetClickCallbackFunction(button_name, [](void *_led_handle) {
+        auto led_handle = (monochrome_led::MonochromeLEDManager::Handle_t *)_led_handle;
+        monochrome_led::MonochromeLEDManager::SetPulse(*led_handle, 1, 200, 0);
+        Application::post_action(ACTION_LOG_STATUS);
+    }, &Application::wifi_monochrome_led);
+    button::ButtonManager::SetDoubleClickCallbackFunction(button_name, [](void *_led_handle) {
+        auto led_handle = (monochrome_led::MonochromeLEDManager::Handle_t *)_led_handle;
+        monochrome_led::MonochromeLEDManager::SetPulse(*led_handle, 2, 200, 200);
+        Application::post_action(ACTION_CALIBRATE);
+    }, &Application::wifi_monochrome_led);
+    button::ButtonManager::SetMultiClickCallbackFunction(button_name, [](void *_led_handle) {
+        auto led_handle = (monochrome_led::MonochromeLEDManager::Handle_t *)_led_handle;
+        monochrome_led::MonochromeLEDManager::SetPulse(*led_handle, 3, 200, 200);
+        Application::post_action(ACTION_RESET_CONFIG);
+    }, &Application::wifi_monochrome_led);
+    button::ButtonManager::SetLongPressStartCallbackFunction(button_name, [](void *_led_handle) {
+        auto led_handle = (monochrome_led::MonochromeLEDManager::Handle_t *)_led_handle;
+        monochrome_led::MonochromeLEDManager::SetOn(*led_handle);
+    }, &Application::wifi_monochrome_led);
+    button::ButtonManager::SetLongPressStopCallbackFunction(button_name, [](void *_led_handle) {
+        auto led_handle = (monochrome_led::MonochromeLEDManager::Handle_t *)_led_handle;
+        system::System::Restart("human restart", 5);
+        monochrome_led::MonochromeLEDManager::SetOff(*led_handle);
+    }, &Application::wifi_monochrome_led);
+    // 回调函数在定时器调度任务中执行，校准（UART）、重置配置（NVS）及状态输出交给单独的任务
+    return task_placement::TaskPlacement::Create(task_placement::TaskPlacement::TaskType::ACTION,
+                                                 Application::run_action_task);
+}
+
+void Application::post_action(const Action action)
+{
+    // 不阻塞，操作未执行完时忽略新的按键
+    if (pdTRUE != xQueueSend(Application::action_queue, (void *)&action, 0)) {
+        ESP_LOGW(LOG_TAG, "action queue is full, drop action %d", action);
+    }
+}
+
+void Application::run_action_task(void *)
+{
+    while (true) {
+        Action action;
+        if (pdTRUE != xQueueReceive(Application::action_queue, (void *)&action, portMAX_DELAY)) {
+            continue;
+        }
+        switch (action)
         {
-            auto monochrome_led_name = (std::string *)_monochrome_led_name;
-            monochrome_led::MonochromeLEDManager::SetOn(*monochrome_led_name);
-            system::System::Sleep(200);
-            monochrome_led::MonochromeLEDManager::SetOff(*monochrome_led_name);
-            vTaskDelete(NULL);
-        };
-        xTaskCreate(func, "tmp", 1024, _monochrome_led_name, 2, NULL);
-        auto task_info_summary = system::System::GetCurrentTaskInfoSummary();
-        uint32_t stats_as_percentage;
-        auto task_state_map = [](eTaskState state) {
-            switch (state)
-            {
-                case eTaskState::eRunning:
-                    return 'X';
-                case eTaskState::eReady:
-                    return 'R';
-                case eTaskState::eBlocked:
-                    return 'B';
-                case eTaskState::eSuspended:
-                    return 'S';
-                case eTaskState::eDeleted:
-                    return 'D';
-                default:
-                    return 'E';
-            }
-        };
-        task_info_summary.TotalRuntime /= 100UL;
-        if (task_info_summary.TotalRuntime == 0) {
-            ESP_LOGE(LOG_TAG, "total_runtime is 0");
-        } else {
-            ESP_LOGI(LOG_TAG, "core    id              name  pri.  state   stack     runtime   runtime(%%)");
-            for (auto task_info : task_info_summary.TaskInfoList) {
-                stats_as_percentage = task_info.Runtime / task_info_summary.TotalRuntime;
-                if (stats_as_percentage > 0) {
-                    ESP_LOGI(LOG_TAG, "%4ld%6lu  %16s  %4lu  %5c  %6lu  %10lu  %10lu%%",
-                                task_info.CoreID,
-                                task_info.Id, 
-                                task_info.Name.c_str(),
-                                task_info.Priority,
-                                task_state_map(task_info.State),
-                                task_info.StackHighWaterMark,
-                                task_info.Runtime,
-                                stats_as_percentage);
-                } else {
-                    ESP_LOGI(LOG_TAG, "%4ld%6lu  %16s  %4lu  %5c  %6lu  %10lu          <1%%",
-                                task_info.CoreID,
-                                task_info.Id, 
-                                task_info.Name.c_str(),
-                                task_info.Priority,
-                                task_state_map(task_info.State),
-                                task_info.StackHighWaterMark,
-                                task_info.Runtime);
+            case ACTION_LOG_STATUS:
+                Application::log_status();
+                break;
+            case ACTION_CALIBRATE:
+                // 传感器尚未初始化时忽略
+                if (nullptr == Application::cm1106) {
+                    ESP_LOGW(LOG_TAG, "cm1106 is not ready");
+                    break;
                 }
-            }
+                Application::cm1106->Calibrate();
+                break;
+            case ACTION_RESET_CONFIG:
+                Application::reset_config();
+                break;
+            default:
+                break;
         }
-        uint32_t free_heap_size = system::System::GetCurrentFreeHeapSize();
-        uint32_t min_free_heap_size = system::System::GetCurrentMinimumFreeHeapSize();
-        ESP_LOGI(LOG_TAG, "current free heap size: %luB, %.2fKiB", 
-                    free_heap_size, free_heap_size/1024.0);
-        ESP_LOGI(LOG_TAG, "min free heap size: %luB, %.2fKiB", 
-                    min_free_heap_size, min_free_heap_size/1024.0);
-        ESP_LOGI(Application::LOG_TAG, "uptime: %s", system::System::GetStartupTimeString().c_str());
-    }, &Application::wifi_monochrome_led_name);
-    button::ButtonManager::SetDoubleClickCallbackFunction(button_name, [](void *_monochrome_led_name) {
-        auto func = [](void *_monochrome_led_name)
-        {
-            auto monochrome_led_name = (std::string *)_monochrome_led_name;
-            for(auto i=0; i<2; i++) {
-                monochrome_led::MonochromeLEDManager::SetOn(*monochrome_led_name);
-                system::System::Sleep(200);
-                monochrome_led::MonochromeLEDManager::SetOff(*monochrome_led_name);
-                system::System::Sleep(200);
-            }
-            vTaskDelete(NULL);
-        };
-        xTaskCreate(func, "tmp", 1024, _monochrome_led_name, 2, NULL);
-        Application::cm1106->Calibrate();
-    }, &Application::wifi_monochrome_led_name);
-    button::ButtonManager::SetMultiClickCallbackFunction(button_name, [](void *_monochrome_led_name) {
-        auto func = [](void *_monochrome_led_name)
+    }
+}
+
+void Application::log_status()
+{
+    auto task_info_summary = system::System::GetCurrentTaskInfoSummary();
+    uint32_t stats_as_percentage;
+    auto task_state_map = [](eTaskState state) {
+        switch (state)
         {
-            auto monochrome_led_name = (std::string *)_monochrome_led_name;
-            for(auto i=0; i<3; i++) {
-                monochrome_led::MonochromeLEDManager::SetOn(*monochrome_led_name);
-                system::System::Sleep(200);
-                monochrome_led::MonochromeLEDManager::SetOff(*monochrome_led_name);
-                system::System::Sleep(200);
-            }
-            vTaskDelete(NULL);
-        };
-        xTaskCreate(func, "tmp", 1024, _monochrome_led_name, 2, NULL);
-        if (!config::ConfigManager::Reset()) {
-            ESP_LOGE(Application::LOG_TAG, "reset failed");
-            return;
+            case eTaskState::eRunning:
+                return 'X';
+            case eTaskState::eReady:
+                return 'R';
+            case eTaskState::eBlocked:
+                return 'B';
+            case eTaskState::eSuspended:
+                return 'S';
+            case eTaskState::eDeleted:
+                return 'D';
+            default:
+                return 'E';
         }
-        auto wifi_config = (wifi::Config *)config::ConfigManager::Get(Application::wifi_config_name);
-        wifi_config->STA.SSID = "{your_wifi_name}";
-        wifi_config->STA.Password = "{your_wifi_password}";
-        auto influxdb_config = (influxdb::Config *)config::ConfigManager::Get(Application::influxdb_config_name);
-        influxdb_config->Host = "influxdb.local";
-        influxdb_config->Port = 8086;
-        influxdb_config->Token = "{your_influxdb_token}";
-        influxdb_config->Org = "default";
-        influxdb_config->Bucket = "sensor";
-        influxdb_config->Timeout = 5;
-        if (!config::ConfigManager::Save())
-        {
-            ESP_LOGE(Application::LOG_TAG, "save after reset failed");
+    };
+    task_info_summary.TotalRuntime /= 100UL;
+    if (task_info_summary.TotalRuntime == 0) {
+        ESP_LOGE(LOG_TAG, "total_runtime is 0");
+    } else {
+        ESP_LOGI(LOG_TAG, "core    id              name  pri.  state   stack     runtime   runtime(%%)");
+        for (auto task_info : task_info_summary.TaskInfoList) {
+            stats_as_percentage = task_info.Runtime / task_info_summary.TotalRuntime;
+            if (stats_as_percentage > 0) {
+                ESP_LOGI(LOG_TAG, "%4ld%6lu  %16s  %4lu  %5c  %6lu  %10lu  %10lu%%",
+                            task_info.CoreID,
+                            task_info.Id, 
+                            task_info.Name.c_str(),
+                            task_info.Priority,
+                            task_state_map(task_info.State),
+                            task_info.StackHighWaterMark,
+                            task_info.Runtime,
+                            stats_as_percentage);
+            } else {
+                ESP_LOGI(LOG_TAG, "%4ld%6lu  %16s  %4lu  %5c  %6lu  %10lu          <1%%",
+                            task_info.CoreID,
+                            task_info.Id, 
+                            task_info.Name.c_str(),
+                            task_info.Priority,
+                            task_state_map(task_info.State),
+                            task_info.StackHighWaterMark,
+                            task_info.Runtime);
+            }
         }
-        system::System::Restart("restart after reset config");
-    }, &Application::wifi_monochrome_led_name);
-    button::ButtonManager::SetLongPressStartCallbackFunction(button_name, [](void *_monochrome_led_name) {
-        auto monochrome_led_name = (std::string *)_monochrome_led_name;
-        monochrome_led::MonochromeLEDManager::SetOn(*monochrome_led_name);
-    }, &Application::wifi_monochrome_led_name);
-    button::ButtonManager::SetLongPressStopCallbackFunction(button_name, [](void *_monochrome_led_name) {
-        auto monochrome_led_name = (std::string *)_monochrome_led_name;
-        system::System::Restart("human restart", 5);
-        monochrome_led::MonochromeLEDManager::SetOff(*monochrome_led_name);
-    }, &Application::wifi_monochrome_led_name);
-    return true;
+    }
+    uint32_t free_heap_size = system::System::GetCurrentFreeHeapSize();
+    uint32_t min_free_heap_size = system::System::GetCurrentMinimumFreeHeapSize();
+    ESP_LOGI(LOG_TAG, "current free heap size: %luB, %.2fKiB", 
+                free_heap_size, free_heap_size/1024.0);
+    ESP_LOGI(LOG_TAG, "min free heap size: %luB, %.2fKiB", 
+                min_free_heap_size, min_free_heap_size/1024.0);
+    ESP_LOGI(Application::LOG_TAG, "uptime: %s", system::System::GetStartupTimeString().c_str());
+    task_placement::TaskPlacement::LogCoreLoad();
+    stack_profiler::StackProfiler::LogReport();
+    sync::Mutex::LogStatistics();
+    boot::BootSequence::LogTimeline();
+    wifi::WiFi::LogPowerSaveStatistics();
+    resolver::Resolver::LogCache();
+    mqtt::MQTT::LogStatistics();
+    if (nullptr != Application::influxdb_udp) {
+        Application::influxdb_udp->LogStatistics();
+    }
+    if (nullptr != Application::influxdb) {
+        Application::influxdb->LogStatistics();
+    }
+}
+
+void Application::reset_config()
+{
+    if (!config::ConfigManager::Reset()) {
+        ESP_LOGE(Application::LOG_TAG, "reset failed");
+        return;
+    }
+    auto wifi_config = (wifi::Config *)config::ConfigManager::Edit(Application::wifi_config_name);
+    auto influxdb_config = (influxdb::Config *)config::ConfigManager::Edit(Application::influxdb_config_name);
+    if (nullptr == wifi_config || nullptr == influxdb_config) {
+        ESP_LOGE(Application::LOG_TAG, "edit after reset failed");
+        delete wifi_config;
+        delete influxdb_config;
+        return;
+    }
+    wifi_config->STA.SSID = "{your_wifi_name}";
+    wifi_config->STA.Password = "{your_wifi_password}";
+    config::ConfigManager::Publish(Application::wifi_config_name, wifi_config, false);
+    influxdb_config->Host = "influxdb.local";
+    influxdb_config->Port = 8086;
+    influxdb_config->Token = "{your_influxdb_token}";
+    influxdb_config->Org = "default";
+    influxdb_config->Bucket = "sensor";
+    influxdb_config->Timeout = 5;
+    config::ConfigManager::Publish(Application::influxdb_config_name, influxdb_config, false);
+    if (!config::ConfigManager::Save())
+    {
+        ESP_LOGE(Application::LOG_TAG, "save after reset failed");
+    }
+    system::System::Restart("restart after reset config");
 }
 
 bool Application::init_config()
@@ -241,18 +319,20 @@ bool Application::init_config()
     config::ConfigManager::Add(Application::ntp_config_name, new ntp::Config());
     config::ConfigManager::Add(Application::mdns_config_name, new mdns::Config());
     config::ConfigManager::Add(Application::scheduled_restart_config_name, new scheduled_restart::Config());
-    config::ConfigManager::Add(Application::sgp30_config_name, new sensor::SGP30Config());
+    Application::sgp30_config = config::ConfigManager::Add(Application::sgp30_config_name, new sensor::SGP30Config());
     config::ConfigManager::Add(Application::influxdb_config_name, new influxdb::Config());
+    config::ConfigManager::Add(Application::mqtt_config_name, new mqtt::Config());
+    config::ConfigManager::Add(Application::screen_config_name, new screen::Config());
     return config::ConfigManager::Load();
 }
 
 bool Application::init_monochrome_led()
 {
-    monochrome_led::MonochromeLEDManager::Add(Application::wifi_monochrome_led_name, GPIO_NUM_25);
-    monochrome_led::MonochromeLEDManager::Add(Application::pm25_monochrome_led_name, GPIO_NUM_33);
-    monochrome_led::MonochromeLEDManager::Add(Application::co2_monochrome_led_name, GPIO_NUM_4);
-    monochrome_led::MonochromeLEDManager::Add(Application::tvoc_monochrome_led_name, GPIO_NUM_32);
-    monochrome_led::MonochromeLEDManager::Add(Application::inner_monochrome_led_name, GPIO_NUM_26);
+    Application::wifi_monochrome_led = monochrome_led::MonochromeLEDManager::Add(Application::wifi_monochrome_led_name, GPIO_NUM_25);
+    Application::pm25_monochrome_led = monochrome_led::MonochromeLEDManager::Add(Application::pm25_monochrome_led_name, GPIO_NUM_33);
+    Application::co2_monochrome_led = monochrome_led::MonochromeLEDManager::Add(Application::co2_monochrome_led_name, GPIO_NUM_4);
+    Application::tvoc_monochrome_led = monochrome_led::MonochromeLEDManager::Add(Application::tvoc_monochrome_led_name, GPIO_NUM_32);
+    Application::inner_monochrome_led = monochrome_led::MonochromeLEDManager::Add(Application::inner_monochrome_led_name, GPIO_NUM_26);
     return true;
 }
 
@@ -264,14 +344,15 @@ bool Application::init_i2c()
     Application::hdc1080 = new sensor::HDC1080(Application::i2c_master_0);
     Application::sgp30 = new sensor::SGP30(Application::i2c_master_0);
     Application::pm2005 = new sensor::PM2005(Application::i2c_master_1);
-    sensor::SGP30Config *spg30_config = (sensor::SGP30Config *)config::ConfigManager::Get(Application::sgp30_config_name);
+    auto spg30_config = config::ConfigManager::Get<sensor::SGP30Config>(Application::sgp30_config);
     if (spg30_config->CO2eq != spg30_config->Default_CO2eq && spg30_config->TVOC != spg30_config->Default_TVOC) {
         sensor::SGP30::Baseline baseline;
         baseline.CO2eq = spg30_config->CO2eq;
         baseline.TVOC = spg30_config->TVOC;
         Application::sgp30->SetBaseline(baseline);
     }
-    screen::Screen::Start(Application::i2c_master_1);
+    screen::Screen::Start(Application::i2c_master_1,
+                          config::ConfigManager::Get<screen::Config>(Application::screen_config_name)->BufferMode);
     return true;
 }
 
@@ -284,30 +365,222 @@ bool Application::init_uart()
 
 bool Application::init_influxdb()
 {
-    influxdb::Config *influxdb_config = (influxdb::Config*)config::ConfigManager::Get(Application::influxdb_config_name);
+    auto influxdb_config = config::ConfigManager::Get<influxdb::Config>(Application::influxdb_config_name);
     Application::influxdb = new influxdb::Influxdb(influxdb_config->Host,
                                                    influxdb_config->Port,
                                                    influxdb_config->Token,
                                                    influxdb_config->Org,
                                                    influxdb_config->Bucket,
-                                                   influxdb_config->Timeout);
+                                                   influxdb_config->Timeout,
+                                                   influxdb_config->TLS,
+                                                   influxdb_config->CACert);
+    if (0 != influxdb_config->UDPPort) {
+        Application::influxdb_udp = new influxdb::InfluxdbUDP(influxdb_config->Host,
+                                                              influxdb_config->UDPPort,
+                                                              influxdb_config->UDPSequence);
+    }
     auto func = [](void *args)
     {
+        // 启用MQTT时代替InfluxDB上传
+        // 只取出需要的字段，不在任务中一直持有快照
+        bool mqtt_enable = config::ConfigManager::Get<mqtt::Config>(Application::mqtt_config_name)->Enable;
+        // 尽量在时间同步后再上传，之前的数据在队列中等待；没有可用的估计时间时一直等待
+        if (!ntp::NTP::WaitForSync(SYNC_WAIT_TIME) && !ntp::NTP::IsEstimated()) {
+            ntp::NTP::WaitForSync();
+        }
+        // 里程碑只需记录一次，避免每次上传都加锁查找
+        bool uploaded = false;
         while (true) {
-            influxdb::Point *point;
-            if (pdTRUE != xQueueReceive(Application::influxdb_queue, (void *)&point, portMAX_DELAY)) {
+            Sample sample;
+            if (pdTRUE != xQueueReceive(Application::influxdb_queue, (void *)&sample, portMAX_DELAY)) {
+                continue;
+            }
+            auto point = sample.Point;
+            // 同步后按同步时的时间换算，同步前采样的数据也随之修正
+            point->SetTimestamp(ntp::NTP::ToTimestamp(sample.Uptime));
+            if (!ntp::NTP::IsSynced()) {
+                point->AddField("time_estimated", true);
+            }
+            if (mqtt_enable) {
+                // 未连接时缓存，不阻塞
+                if (!mqtt::MQTT::Publish(point->ToLineProtocol())) {
+                    ESP_LOGE(LOG_TAG, "publish to mqtt failed");
+                } else if (!uploaded) {
+                    boot::BootSequence::Mark("first_upload");
+                    uploaded = true;
+                }
+                delete point;
+                continue;
+            }
+            if (nullptr != Application::influxdb_udp) {
+                // 队列中积压的数据合并到同一数据报，取完后立即发送
+                bool result = Application::influxdb_udp->WritePoint(*point);
+                if (0 == uxQueueMessagesWaiting(Application::influxdb_queue)) {
+                    result = Application::influxdb_udp->Flush() && result;
+                }
+                if (!result) {
+                    ESP_LOGE(LOG_TAG, "send to influxdb over udp failed");
+                } else if (!uploaded) {
+                    boot::BootSequence::Mark("first_upload");
+                    uploaded = true;
+                }
+                delete point;
                 continue;
             }
+            int64_t write_timestamp = esp_timer_get_time();
             if (!Application::influxdb->WritePoint(*point)) {
                 ESP_LOGE(LOG_TAG, "write to influxdb failed");
             } else {
+                // 按当前的省电模式统计上传耗时
+                wifi::WiFi::RecordLatency(esp_timer_get_time() - write_timestamp);
                 ESP_LOGI(LOG_TAG, "write to influxdb success");
+                if (!uploaded) {
+                    boot::BootSequence::Mark("first_upload");
+                    uploaded = true;
+                }
             }
             delete point;
             point = nullptr;
         }
     };
-    xTaskCreate(func, "influxdb", 4096, nullptr, 2, NULL);
+    return task_placement::TaskPlacement::Create(task_placement::TaskPlacement::TaskType::INFLUXDB, func);
+}
+
+bool Application::init_metrics()
+{
+    gauges[GAUGE_TEMPERATURE] = metrics::MetricsServer::Add("air_temperature_celsius", "Temperature.");
+    gauges[GAUGE_HUMIDITY] = metrics::MetricsServer::Add("air_humidity_percent", "Relative humidity.");
+    gauges[GAUGE_PM25] = metrics::MetricsServer::Add("air_pm25_ugm3", "PM2.5 concentration.");
+    gauges[GAUGE_PM10] = metrics::MetricsServer::Add("air_pm10_ugm3", "PM10 concentration.");
+    gauges[GAUGE_CO2] = metrics::MetricsServer::Add("air_co2_ppm", "CO2 concentration.");
+    gauges[GAUGE_TVOC] = metrics::MetricsServer::Add("air_tvoc_ppb", "TVOC concentration.");
+    gauges[GAUGE_CO2EQ] = metrics::MetricsServer::Add("air_co2eq_ppm", "CO2 equivalent estimated from TVOC.");
+    gauges[GAUGE_CH2O_UGM3] = metrics::MetricsServer::Add("air_ch2o_ugm3", "Formaldehyde concentration.");
+    gauges[GAUGE_CH2O_PPB] = metrics::MetricsServer::Add("air_ch2o_ppb", "Formaldehyde concentration.");
+    return true;
+}
+
+bool Application::start_metrics()
+{
+    // 端口与mdns中广播的_http服务一致
+    auto mdns_config = config::ConfigManager::Get<mdns::Config>(Application::mdns_config_name);
+    if (!metrics::MetricsServer::Start(mdns_config->MetricsPort)) {
+        ESP_LOGE(LOG_TAG, "metrics server start failed");
+        return false;
+    }
+    ESP_LOGI(LOG_TAG, "metrics server start success");
+    return true;
+}
+
+bool Application::restore_time()
+{
+    // 没有可恢复的时间时等待同步，不影响其他阶段
+    ntp::NTP::RestoreTime();
+    return true;
+}
+
+bool Application::start_wifi()
+{
+    auto wifi_config = config::ConfigManager::Get<wifi::Config>(Application::wifi_config_name);
+    wifi::WiFi::StaticIP static_ip = {wifi_config->StaticIP.IP,
+                                      wifi_config->StaticIP.Netmask,
+                                      wifi_config->StaticIP.Gateway,
+                                      wifi_config->StaticIP.DNS};
+    if(!wifi::WiFi::Start(WIFI_MODE_STA, 
+                          wifi_config->STA.SSID, 
+                          wifi_config->STA.Password, 
+                          wifi_config->STA.Hostname,
+                          static_ip,
+                          wifi_config->PowerSave,
+                          wifi_config->ListenInterval)) {
+        reboot_for_failed_start("wifi start failed");
+        return false;
+    }
+    monochrome_led::MonochromeLEDManager::SetBlink(Application::wifi_monochrome_led, 1000, 2000);
+    ESP_LOGI(LOG_TAG, "wifi start success");
+    return true;
+}
+
+bool Application::start_ntp()
+{
+    auto ntp_config = config::ConfigManager::Get<ntp::Config>(Application::ntp_config_name);
+    // 在后台同步，失败时继续使用估计的时间，不重启
+    if(!ntp::NTP::Start(ntp_config->ServerNameList)) {
+        ESP_LOGE(LOG_TAG, "ntp start failed");
+        return false;
+    } 
+    ESP_LOGI(LOG_TAG, "ntp start success");
+    return true;
+}
+
+bool Application::start_scheduled_restart()
+{
+    // 重启时间依赖当前时间，尽量在同步后计算
+    bool estimated = false;
+    if (!ntp::NTP::WaitForSync(SYNC_WAIT_TIME)) {
+        if (!ntp::NTP::IsEstimated()) {
+            ESP_LOGE(LOG_TAG, "no valid time for scheduled restart");
+            return false;
+        }
+        ESP_LOGW(LOG_TAG, "schedule restart with estimated time");
+        estimated = true;
+    }
+    auto scheduled_restart = config::ConfigManager::Get<scheduled_restart::Config>(Application::scheduled_restart_config_name);
+    if(!scheduled_restart::ScheduledRestart::Start(scheduled_restart->DayType, 
+                                                   scheduled_restart->Hour,
+                                                   scheduled_restart->Minute)) {
+        reboot_for_failed_start("scheduled restart start failed");
+        return false;
+    } 
+    if (estimated) {
+        // 第一次同步后按准确的时间重新计算
+        ntp::NTP::SetFirstSyncCallbackFunction([](void *) {
+            ESP_LOGI(LOG_TAG, "time synced, reschedule restart");
+            scheduled_restart::ScheduledRestart::Reschedule();
+        });
+        // 设置回调前已同步时直接重新计算
+        if (ntp::NTP::IsSynced()) {
+            scheduled_restart::ScheduledRestart::Reschedule();
+        }
+    }
+    ESP_LOGI(LOG_TAG, "scheduled restart start success");
+    return true;
+}
+
+bool Application::start_mqtt()
+{
+    auto mqtt_config = config::ConfigManager::Get<mqtt::Config>(Application::mqtt_config_name);
+    if (!mqtt_config->Enable) {
+        return true;
+    }
+    // 不等待连接，连接前的数据由MQTT缓存
+    if (!mqtt::MQTT::Start(mqtt_config->URI,
+                           mqtt_config->ClientID,
+                           mqtt_config->Username,
+                           mqtt_config->Password,
+                           mqtt_config->Topic,
+                           mqtt_config->QoS,
+                           mqtt_config->Retain,
+                           mqtt_config->BatchSize,
+                           mqtt_config->Keepalive)) {
+        ESP_LOGE(LOG_TAG, "mqtt start failed");
+        return false;
+    }
+    ESP_LOGI(LOG_TAG, "mqtt start success");
+    return true;
+}
+
+bool Application::start_mdns()
+{
+    auto mdns_config = config::ConfigManager::Get<mdns::Config>(Application::mdns_config_name);
+    if(!mdns::MDNS::Start(mdns_config->Hostname, 
+                          mdns_config->InstanceName,
+                          mdns_config->services)) {
+        std::string message = "mdns start failed";
+        reboot_for_failed_start(message);
+        return false;
+    } 
+    ESP_LOGI(LOG_TAG, "mdns start success");
     return true;
 }
 
@@ -320,6 +593,12 @@ void Application::reboot_for_failed_start(std::string reason)
 void Application::shutdown_handler()
 {
     start_flag = false;
+    // 写入尚未保存的配置
+    config::ConfigManager::Flush();
+    metrics::MetricsServer::Stop();
+    ESP_LOGI(Application::LOG_TAG, "metrics server has been stopped");
+    mqtt::MQTT::Stop();
+    ESP_LOGI(Application::LOG_TAG, "mqtt has been stopped");
     mdns::MDNS::Stop();
     ESP_LOGI(Application::LOG_TAG, "mdns has been stopped");
     ntp::NTP::Stop();
@@ -354,53 +633,11 @@ void Application::Start()
     // 输出基础信息
     system::System::LogHardwareInfo();
     system::System::LogSoftwareInfo();
+    task_placement::TaskPlacement::LogPlacement();
 
-    button::ButtonManager::Start();
-    monochrome_led::MonochromeLEDManager::Start();
-    monochrome_led::MonochromeLEDManager::SetBlink(Application::inner_monochrome_led_name, 500, 500);
-    
-    monochrome_led::MonochromeLEDManager::SetBlink(Application::wifi_monochrome_led_name, 250, 250);
-    
-    screen::Screen::SetStatus(screen::Screen::Status::LOADING);
-
-    auto wifi_config = (wifi::Config *)config::ConfigManager::Get(Application::wifi_config_name);
-    if(!wifi::WiFi::Start(WIFI_MODE_STA, 
-                          wifi_config->STA.SSID, 
-                          wifi_config->STA.Password, 
-                          wifi_config->STA.Hostname)) {
-        reboot_for_failed_start("wifi start failed");
-        return;
-    }
-    ESP_LOGI(LOG_TAG, "wifi start success");
+    // 周期性采样各任务的栈使用情况
+    stack_profiler::StackProfiler::Start();
 
-    auto ntp_config = (ntp::Config *)config::ConfigManager::Get(Application::ntp_config_name);
-    if(!ntp::NTP::Start(ntp_config->ServerNameList)) {
-        ESP_LOGE(LOG_TAG, "ntp start failed");
-        reboot_for_failed_start("ntp start failed");
-        return;
-    } 
-    ESP_LOGI(LOG_TAG, "ntp start success");
-    ESP_LOGI(LOG_TAG, "the current date/time is: %s", system::System::GetCurrentTimeStandardString().c_str());
-    
-    auto scheduled_restart = (scheduled_restart::Config *)config::ConfigManager::Get(Application::scheduled_restart_config_name);
-    if(!scheduled_restart::ScheduledRestart::Start(scheduled_restart->DayType, 
-                                                   scheduled_restart->Hour,
-                                                   scheduled_restart->Minute)) {
-        reboot_for_failed_start("scheduled restart start failed");
-        return;
-    } 
-    ESP_LOGI(LOG_TAG, "scheduled restart start success");
-
-    auto mdns_config = (mdns::Config *)config::ConfigManager::Get(Application::mdns_config_name);
-    if(!mdns::MDNS::Start(mdns_config->Hostname, 
-                          mdns_config->InstanceName,
-                          mdns_config->services)) {
-        std::string message = "mdns start failed";
-        reboot_for_failed_start(message);
-        return;
-    } 
-    ESP_LOGI(LOG_TAG, "mdns start success");
-   
     // 注册重启时的回调函数
     ESP_ERROR_CHECK(esp_register_shutdown_handler(shutdown_handler));
 
@@ -410,10 +647,11 @@ void Application::Start()
     screen::Screen::SetStatus(screen::Screen::Status::DISPLAY);
     
     auto last_startup_timestamp = system::System::GetStartupTimestamp();
-    std::string measurement = mdns_config->Hostname;
+    std::string measurement = config::ConfigManager::Get<mdns::Config>(Application::mdns_config_name)->Hostname;
+    // 里程碑只需记录一次
+    bool sampled = false;
     // 主循环
     while(1) {
-        monochrome_led::MonochromeLEDManager::SetBlink(Application::wifi_monochrome_led_name, 1000, 2000);
         uint32_t count = 0;
         while (count < 3)
         {   
@@ -425,15 +663,20 @@ void Application::Start()
             auto sgp_baseline = Application::sgp30->GetBaseline();
             auto current_startup_timestamp = system::System::GetStartupTimestamp();
             auto ze08_ch2o_data = Application::ze08_ch2o->GetData();
+            if (!sampled) {
+                boot::BootSequence::Mark("first_sample");
+                sampled = true;
+            }
             
             if ((current_startup_timestamp-last_startup_timestamp) >= 1800) {
-                sensor::SGP30Config *config = (sensor::SGP30Config *)config::ConfigManager::Get(Application::sgp30_config_name);
-                config->CO2eq = sgp_baseline.CO2eq;
-                config->TVOC = sgp_baseline.TVOC;
-                if (config::ConfigManager::Save(Application::sgp30_config_name)) {
-                    ESP_LOGI(LOG_TAG, "sgp30 baseline save success");
+                auto config = (sensor::SGP30Config *)config::ConfigManager::Edit(Application::sgp30_config);
+                if (nullptr != config) {
+                    config->CO2eq = sgp_baseline.CO2eq;
+                    config->TVOC = sgp_baseline.TVOC;
+                    // 发布后由定时器在后台写入，基线未变化时不写入
+                    config::ConfigManager::Publish(Application::sgp30_config, config);
                 } else {
-                    ESP_LOGE(LOG_TAG, "sgp30 baseline save failed");
+                    ESP_LOGE(LOG_TAG, "edit sgp30 config failed");
                 }
                 last_startup_timestamp = current_startup_timestamp;
             }
@@ -454,20 +697,31 @@ void Application::Start()
             screen::Screen::SetCO2eq(sgp_data.CO2eq);
             screen::Screen::SetCH2O(ze08_ch2o_data.CH2O_UGM3, ze08_ch2o_data.CH2O_PPB);
 
+            metrics::MetricsServer::Set(gauges[GAUGE_TEMPERATURE], temperature);
+            metrics::MetricsServer::Set(gauges[GAUGE_HUMIDITY], humidity);
+            metrics::MetricsServer::Set(gauges[GAUGE_PM25], pm2005_data.PM25);
+            metrics::MetricsServer::Set(gauges[GAUGE_PM10], pm2005_data.PM10);
+            metrics::MetricsServer::Set(gauges[GAUGE_CO2], cm1106_data);
+            metrics::MetricsServer::Set(gauges[GAUGE_TVOC], sgp_data.TVOC);
+            metrics::MetricsServer::Set(gauges[GAUGE_CO2EQ], sgp_data.CO2eq);
+            metrics::MetricsServer::Set(gauges[GAUGE_CH2O_UGM3], ze08_ch2o_data.CH2O_UGM3);
+            metrics::MetricsServer::Set(gauges[GAUGE_CH2O_PPB], ze08_ch2o_data.CH2O_PPB);
+            metrics::MetricsServer::Publish(system::System::GetCurrentTimestamp());
+
             if (pm2005_data.PM25 > 75) {
-                monochrome_led::MonochromeLEDManager::SetOn(Application::pm25_monochrome_led_name);
+                monochrome_led::MonochromeLEDManager::SetOn(Application::pm25_monochrome_led);
             } else {
-                monochrome_led::MonochromeLEDManager::SetOff(Application::pm25_monochrome_led_name);
+                monochrome_led::MonochromeLEDManager::SetOff(Application::pm25_monochrome_led);
             }
             if (cm1106_data > 1000) {
-                monochrome_led::MonochromeLEDManager::SetOn(Application::co2_monochrome_led_name);
+                monochrome_led::MonochromeLEDManager::SetOn(Application::co2_monochrome_led);
             } else {
-                monochrome_led::MonochromeLEDManager::SetOff(Application::co2_monochrome_led_name);
+                monochrome_led::MonochromeLEDManager::SetOff(Application::co2_monochrome_led);
             }
             if (sgp_data.TVOC > 500 || ze08_ch2o_data.CH2O_UGM3 > 80) {
-                monochrome_led::MonochromeLEDManager::SetOn(Application::tvoc_monochrome_led_name);
+                monochrome_led::MonochromeLEDManager::SetOn(Application::tvoc_monochrome_led);
             } else {
-                monochrome_led::MonochromeLEDManager::SetOff(Application::tvoc_monochrome_led_name);
+                monochrome_led::MonochromeLEDManager::SetOff(Application::tvoc_monochrome_led);
             }
 
             auto point = new influxdb::Point(measurement);
@@ -485,8 +739,12 @@ void Application::Start()
             
             point->AddField("ch2o_ugm3", (long long)ze08_ch2o_data.CH2O_UGM3);
             point->AddField("ch2o_ppb", (long long)ze08_ch2o_data.CH2O_PPB);
-            point->SetTimestamp(system::System::GetCurrentTimestamp());
-            xQueueSend(Application::influxdb_queue, (void *)&point, portMAX_DELAY);
+            Sample sample = {point, esp_timer_get_time()};
+            // 网络尚未就绪时队列可能已满，丢弃而不阻塞采样
+            if (pdTRUE != xQueueSend(Application::influxdb_queue, (void *)&sample, 0)) {
+                ESP_LOGW(LOG_TAG, "influxdb queue is full, drop the point");
+                delete point;
+            }
 
             count += 1;
             esp_task_wdt_reset();
@@ -7,10 +7,14 @@
 #include "freertos/semphr.h"
 #include "freertos/queue.h"
 
+#include "config_manager.hpp"
 #include "influxdb.hpp"
+#include "influxdb_udp.hpp"
+#include "metrics_server.hpp"
 #include "i2c_master.hpp"
 #include "cm1106.hpp"
 #include "hdc1080.hpp"
+#include "monochrome_led_manager.hpp"
 #include "pm2005.hpp"
 #include "sgp30.hpp"
 #include "ze08_ch2o.hpp"
@@ -37,6 +41,15 @@ class Application
         static std::string ntp_config_name;
         static std::string mdns_config_name;
         static std::string wifi_config_name;
+        static std::string mqtt_config_name;
+        static std::string screen_config_name;
+        // 注册后得到的句柄，循环中使用以省去按名称查找
+        static monochrome_led::MonochromeLEDManager::Handle_t wifi_monochrome_led;
+        static monochrome_led::MonochromeLEDManager::Handle_t pm25_monochrome_led;
+        static monochrome_led::MonochromeLEDManager::Handle_t co2_monochrome_led;
+        static monochrome_led::MonochromeLEDManager::Handle_t tvoc_monochrome_led;
+        static monochrome_led::MonochromeLEDManager::Handle_t inner_monochrome_led;
+        static config::ConfigManager::Handle_t sgp30_config;
         static i2c_master::I2cMaster *i2c_master_0;
         static i2c_master::I2cMaster *i2c_master_1;
         static sensor::CM1106 *cm1106;
@@ -45,15 +58,56 @@ class Application
         static sensor::SGP30 *sgp30;
         static sensor::ZE08_CH2O *ze08_ch2o;
         static influxdb::Influxdb *influxdb;
+        static influxdb::InfluxdbUDP *influxdb_udp;
+        // 待上传的数据及采样时启动后的时间（微秒），上传时再换算为时间戳
+        struct Sample {
+            influxdb::Point *Point;
+            int64_t Uptime;
+        };
         static QueueHandle_t influxdb_queue;
+        // 按钮触发的操作，由单独的任务执行，不阻塞定时器调度任务
+        enum Action {
+            ACTION_LOG_STATUS,
+            ACTION_CALIBRATE,
+            ACTION_RESET_CONFIG,
+        };
+        static QueueHandle_t action_queue;
+        // 对外提供的指标
+        enum Gauge {
+            GAUGE_TEMPERATURE,
+            GAUGE_HUMIDITY,
+            GAUGE_PM25,
+            GAUGE_PM10,
+            GAUGE_CO2,
+            GAUGE_TVOC,
+            GAUGE_CO2EQ,
+            GAUGE_CH2O_UGM3,
+            GAUGE_CH2O_PPB,
+            GAUGE_MAX,
+        };
+        static metrics::MetricsServer::Handle_t gauges[GAUGE_MAX];
+        // 上传前等待时间同步的时间（毫秒），超时后以估计的时间上传
+        static const uint32_t SYNC_WAIT_TIME = 60000;
         static bool init();
         static bool init_log();
         static bool init_button();
+        static void post_action(const Action action);
+        static void run_action_task(void *);
+        static void log_status();
+        static void reset_config();
         static bool init_config();
         static bool init_monochrome_led();
         static bool init_i2c();
         static bool init_uart();
         static bool init_influxdb();
+        static bool init_metrics();
+        static bool start_metrics();
+        static bool restore_time();
+        static bool start_wifi();
+        static bool start_ntp();
+        static bool start_scheduled_restart();
+        static bool start_mdns();
+        static bool start_mqtt();
         static void reboot_for_failed_start(std::string reason);
         static void shutdown_handler();
     public:
@@ -1,11 +1,15 @@
 #ifndef _screen_hpp_
 #define _screen_hpp_
 
+#include <string>
+#include <vector>
+
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
 
 #include "i2c_master.hpp"
 #include "u8g2.hpp"
+#include "mutex.hpp"
 
 namespace cubestone_wang 
 {
@@ -18,15 +22,33 @@ using namespace i2c_master;
 class Screen
 {
     public:
+        using BufferMode = u8g2::U8G2::BufferMode;
         enum class Status {
             INIT,
             LOADING,
             DISPLAY,
             UNKNOWN
         };
+        // 基准测试结果
+        struct BenchmarkResult {
+            std::string Name;
+            uint32_t Rounds;
+            uint32_t BufferSize;            // 缓冲区大小（字节）
+            uint32_t AverageRenderTime;     // 平均渲染时间（微秒）
+            uint32_t MaxRenderTime;         // 最大渲染时间（微秒）
+            uint32_t TransferredBytes;      // 每帧需发送的字节数
+            uint32_t TransferCount;         // 每帧的发送次数
+            std::string PBM;                // 渲染结果（PBM P4）
+        };
         // 日志标签
         static const char *const LOG_TAG;
-        static bool Start(I2cMaster* const i2c_master);
+        /**
+         * @brief 启动
+         *
+         * @param i2c_master I2C主机
+         * @param buffer_mode 缓冲模式，FULL延迟最低，PAGE_1内存最低
+         */
+        static bool Start(I2cMaster* const i2c_master, const BufferMode buffer_mode=BufferMode::FULL);
         static void SetContrast(const uint8_t contrast);
         static void SetStatus(const Status status);
         static void SetTemperature(const float temperature);
@@ -37,10 +59,35 @@ class Screen
         static void SetTVOC(const uint16_t tvoc);
         static void SetCO2eq(const uint16_t co2eq);
         static void SetCH2O(const uint16_t ch2o_ugm3, const uint16_t ch2o_ppb);
+        /**
+         * @brief 基准测试，使用无头模式及模拟数据渲染各页面，不影响屏幕显示
+         * 不依赖屏幕的运行状态，可在主机上运行，见tools/screen_render
+         *
+         * @param rounds 每个页面渲染的次数
+         * @param buffer_mode 缓冲模式
+         */
+        static std::vector<BenchmarkResult> Benchmark(const uint32_t rounds=10, 
+                                                      const BufferMode buffer_mode=BufferMode::FULL);
     private:
-        static SemaphoreHandle_t mutex;
+        // 一帧的绘制数据，绘制函数只读取该数据，不访问屏幕的运行状态
+        struct Frame {
+            Status FrameStatus;
+            uint8_t LoadingStep;
+            uint8_t DisplayStep;
+            float Temperature;
+            float Humidity;
+            uint16_t CO2;
+            uint16_t PM25;
+            uint16_t PM10;
+            uint16_t TVOC;
+            uint16_t CO2eq;
+            uint16_t CH2O_UGM3;
+            uint16_t CH2O_PPB;
+        };
+        static sync::Mutex mutex;
         static bool start_flag;
         static I2cMaster* i2c_master;
+        static BufferMode buffer_mode;
         static void run_task(void *);
         static float temperature;   // -40 ~ 125
         static float humidity;      // 0 ~ 100
@@ -57,9 +104,13 @@ class Screen
         static uint8_t loading_step;
         static uint8_t display_step;
         static time_t last_update_timestamp;
-        static void draw_init(u8g2_t* const u8g2);
-        static void draw_loading(u8g2_t* const u8g2);
-        static void draw_display(u8g2_t* const u8g2);
+        static void update_step();
+        static Frame get_frame();
+        static void setup_u8g2(u8g2_t* const u8g2);
+        static void draw(u8g2::U8G2 &display, const Frame &frame);
+        static void draw_init(u8g2::U8G2 &display);
+        static void draw_loading(u8g2::U8G2 &display, const Frame &frame);
+        static void draw_display(u8g2::U8G2 &display, const Frame &frame);
 };
 
 }
@@ -0,0 +1,109 @@
+#include "cJSON.h"
+#include "esp_log.h"
+
+#include "screen_config.hpp"
+
+namespace cubestone_wang 
+{
+
+namespace screen
+{
+
+// 二进制格式的字段号
+enum Field : uint8_t {
+    FIELD_BUFFER_MODE = 1,
+};
+
+const char *const Config::LOG_TAG = "SCREEN_CONFIG";
+
+const Screen::BufferMode Config::default_buffer_mode = Screen::BufferMode::FULL; 
+
+void Config::Reset()
+{
+    BufferMode = default_buffer_mode;
+}
+
+std::string Config::Dump() const
+{
+    cJSON *json_root = cJSON_CreateObject();
+    cJSON_AddNumberToObject(json_root, "buffer_mode", static_cast<uint32_t>(BufferMode));
+    char *json_data = cJSON_PrintUnformatted(json_root);
+    std::string result = std::string(json_data);
+    cJSON_free(json_data);
+    cJSON_Delete(json_root); 
+    return result;
+}
+
+bool Config::Load(const char *const config_data)
+{
+    if (nullptr == config_data) {
+        Reset();
+        return true;
+    }
+    cJSON *json_root = cJSON_Parse(config_data);
+    if (NULL == json_root) {   
+        Reset();
+        return true;
+    }
+    cJSON *json_item;
+    json_item = cJSON_GetObjectItem(json_root, "buffer_mode");
+    if (NULL == json_item) {
+        BufferMode = default_buffer_mode;
+    } else if (cJSON_Number != json_item->type
+               || json_item->valueint < static_cast<int>(Screen::BufferMode::FULL)
+               || json_item->valueint > static_cast<int>(Screen::BufferMode::PAGE_2)) {
+        ESP_LOGE(LOG_TAG, "buffer mode error");
+        cJSON_Delete(json_root); 
+        return false;
+    } else {
+        BufferMode = (Screen::BufferMode)(json_item->valueint);
+    }
+    
+    cJSON_Delete(json_root); 
+    return true;
+}
+
+bool Config::Load(const std::string &config_data)
+{
+    if ("" == config_data) {
+        return this->Load(nullptr);
+    } else {
+        return this->Load(config_data.c_str());
+    }
+}
+
+config::BaseConfig *Config::Clone() const
+{
+    return new Config(*this);
+}
+
+void Config::Encode(config::BinaryEncoder &encoder) const
+{
+    encoder.WriteUInt(FIELD_BUFFER_MODE, static_cast<uint32_t>(BufferMode));
+}
+
+bool Config::Decode(config::BinaryDecoder &decoder, const uint8_t schema_version)
+{
+    uint32_t value;
+    while (decoder.Next()) {
+        switch (decoder.GetField()) {
+            case FIELD_BUFFER_MODE:
+                if (false == decoder.GetUInt(value)) {
+                    ESP_LOGE(LOG_TAG, "buffer_mode error");
+                    return false;
+                }
+                // 超出范围时保持默认值
+                if (value <= static_cast<uint32_t>(Screen::BufferMode::PAGE_2)) {
+                    BufferMode = (Screen::BufferMode)value;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    return true;
+}
+
+}
+
+}
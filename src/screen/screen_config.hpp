@@ -0,0 +1,38 @@
+#ifndef _screen_config_hpp_
+#define _screen_config_hpp_
+
+#include <string>
+
+#include "base_config.hpp"
+
+#include "screen.hpp"
+
+namespace cubestone_wang 
+{
+
+namespace screen
+{
+
+class Config: public config::BaseConfig
+{
+    public:
+        // 日志标签
+        static const char *const LOG_TAG;
+        void Reset();
+        std::string Dump() const;
+        bool Load(const char *const config_data);
+        bool Load(const std::string &config_data);
+        void Encode(config::BinaryEncoder &encoder) const;
+        config::BaseConfig *Clone() const;
+        bool Decode(config::BinaryDecoder &decoder, const uint8_t schema_version);
+        // 缓冲模式，0为全缓冲，1为单页缓冲，2为双页缓冲
+        Screen::BufferMode BufferMode;
+    private:
+        static const Screen::BufferMode default_buffer_mode; 
+};
+
+}
+
+}
+
+#endif // _screen_config_hpp_
@@ -0,0 +1,184 @@
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "screen_font.hpp"
+#include "screen.hpp"
+
+// 绘制及基准测试，只依赖u8g2，可在主机上编译，见tools/screen_render
+
+namespace cubestone_wang 
+{
+
+namespace screen
+{
+
+std::vector<Screen::BenchmarkResult> Screen::Benchmark(const uint32_t rounds, const BufferMode buffer_mode)
+{
+    std::vector<BenchmarkResult> results;
+    // 页面名称及模拟数据
+    struct Page {
+        const char *Name;
+        Frame PageFrame;
+    };
+    const Page pages[] = {
+        {"init", {Status::INIT, 0, 0, 23.5, 45.5, 650, 12, 20, 120, 480, 10, 8}},
+        {"loading", {Status::LOADING, 3, 0, 23.5, 45.5, 650, 12, 20, 120, 480, 10, 8}},
+        {"display_0", {Status::DISPLAY, 0, 0, 23.5, 45.5, 650, 12, 20, 120, 480, 10, 8}},
+        {"display_1", {Status::DISPLAY, 0, 1, 23.5, 45.5, 650, 12, 20, 120, 480, 10, 8}},
+    };
+    if (0 == rounds) {
+        ESP_LOGE(LOG_TAG, "rounds must > 0");
+        return results;
+    }
+    auto _u8g2 = u8g2::U8G2(u8g2::U8G2::DeviceType::SH1106_I2C_128x64, U8G2_R0, buffer_mode);
+    Screen::setup_u8g2(_u8g2.GetInstance());
+    for (auto &page : pages) {
+        BenchmarkResult result;
+        uint64_t total_render_time = 0;
+        result.Name = page.Name;
+        result.Rounds = rounds;
+        result.MaxRenderTime = 0;
+        result.BufferSize = _u8g2.GetBufferSize();
+        _u8g2.ResetTransferStatistics();
+        for (uint32_t round=0; round<rounds; round++) {
+            auto start_time = esp_timer_get_time();
+            Screen::draw(_u8g2, page.PageFrame);
+            uint32_t render_time = (uint32_t)(esp_timer_get_time() - start_time);
+            total_render_time += render_time;
+            if (render_time > result.MaxRenderTime) {
+                result.MaxRenderTime = render_time;
+            }
+        }
+        result.AverageRenderTime = (uint32_t)(total_render_time / rounds);
+        result.TransferredBytes = _u8g2.GetTransferredBytes() / rounds;
+        result.TransferCount = _u8g2.GetTransferCount() / rounds;
+        result.PBM = _u8g2.GetFramePBM();
+        ESP_LOGI(LOG_TAG, "%-10s buffer %4u B, avg %6u us, max %6u us, %5u bytes, %4u transfers",
+                 result.Name.c_str(),
+                 (unsigned)result.BufferSize,
+                 (unsigned)result.AverageRenderTime,
+                 (unsigned)result.MaxRenderTime,
+                 (unsigned)result.TransferredBytes,
+                 (unsigned)result.TransferCount);
+        results.push_back(result);
+    }
+    return results;
+}
+
+void Screen::draw(u8g2::U8G2 &display, const Frame &frame)
+{
+    switch (frame.FrameStatus)
+    {
+        case Screen::Status::INIT:
+            Screen::draw_init(display);
+            break;
+        case Screen::Status::LOADING:
+            Screen::draw_loading(display, frame);
+            break;
+        case Screen::Status::DISPLAY:
+            Screen::draw_display(display, frame);
+            break;
+        default:
+            ESP_ERROR_CHECK(ESP_ERR_INVALID_ARG);
+            break;
+    }
+}
+
+void Screen::setup_u8g2(u8g2_t* const u8g2)
+{
+    u8g2_SetFont(u8g2, u8g2_font_t0_14_te_subset);
+    u8g2_SetFontPosBottom(u8g2);
+    u8g2_SetFontMode(u8g2, 1);
+}
+
+void Screen::draw_init(u8g2::U8G2 &display)
+{
+    auto u8g2 = display.GetInstance();
+    display.FirstPage();
+    do {
+        u8g2_DrawBox(u8g2, 0, 0, 128, 64);
+    } while (display.NextPage());
+}
+
+void Screen::draw_loading(u8g2::U8G2 &display, const Frame &frame)
+{
+    auto u8g2 = display.GetInstance();
+    uint8_t x_pos = 30;
+    uint8_t y_pos = 38;
+    const char *text;
+    switch (frame.LoadingStep)
+    {
+        case 0:
+            text = "Loading";
+            break;
+        case 1:
+            text = "Loading.";
+            break;
+        case 2:
+            text = "Loading..";
+            break;
+        case 3:
+            text = "Loading...";
+            break;
+        default:
+            text = "";
+            break;
+    }
+    display.FirstPage();
+    do {
+        u8g2_DrawUTF8(u8g2, x_pos, y_pos, text);
+    } while (display.NextPage());
+}
+
+void Screen::draw_display(u8g2::U8G2 &display, const Frame &frame)
+{
+    auto u8g2 = display.GetInstance();
+    uint8_t x_pos = 8;
+    // 每行的文本，页缓冲模式下会多次重绘，因此先格式化
+    char lines[4][32];
+    memset(lines, 0, sizeof(lines));
+    switch (frame.DisplayStep)
+    {
+        case 0:
+            sprintf(lines[0], "TEMP : %.1f °C", frame.Temperature);
+            sprintf(lines[1], "RH   : %.1f %%", frame.Humidity);
+            if (frame.PM25 != 0 || frame.PM10 != 0) {
+                sprintf(lines[2], "PM2.5: %d ug/m³", frame.PM25);
+                sprintf(lines[3], "PM10 : %d ug/m³", frame.PM10);
+            } else {
+                sprintf(lines[2], "PM2.5: - ug/m³");
+                sprintf(lines[3], "PM10 : - ug/m³");
+            }
+            break;
+        case 1:
+            sprintf(lines[0], "CO₂  : %d ppm", frame.CO2);
+            sprintf(lines[2], "CH₂O : %d ug/m³", frame.CH2O_UGM3);
+            if (frame.TVOC != 0 || frame.CO2eq != 400) {
+                sprintf(lines[1], "TVOC : %d ppb", frame.TVOC);
+                sprintf(lines[3], "CO₂eq: %d ug/m³", frame.CO2eq);
+            } else {
+                sprintf(lines[1], "TVOC : - ppb");
+                sprintf(lines[3], "CO₂eq: - ug/m³");
+            }
+            break;
+        default:
+            break;
+    }
+    display.FirstPage();
+    do {
+        u8g2_DrawUTF8(u8g2, x_pos, 15, lines[0]);
+        u8g2_DrawUTF8(u8g2, x_pos, 31, lines[1]);
+        u8g2_DrawUTF8(u8g2, x_pos, 47, lines[2]);
+        u8g2_DrawUTF8(u8g2, x_pos, 63, lines[3]);
+        // u8g2_DrawLine(u8g2, 0, 0, 127, 0);
+        // u8g2_DrawLine(u8g2, 127, 0, 127, 63);
+        // u8g2_DrawLine(u8g2, 127, 63, 0, 63);
+        // u8g2_DrawLine(u8g2, 0, 63, 0, 0);
+    } while (display.NextPage());
+}
+
+}
+
+}
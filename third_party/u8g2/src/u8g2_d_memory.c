@@ -3,6 +3,28 @@
 
 #include "u8g2.h"
 
+uint8_t *u8g2_m_16_8_1(uint8_t *page_cnt)
+{
+  #ifdef U8G2_USE_DYNAMIC_ALLOC
+  *page_cnt = 1;
+  return 0;
+  #else
+  static uint8_t buf[128];
+  *page_cnt = 1;
+  return buf;
+  #endif
+}
+uint8_t *u8g2_m_16_8_2(uint8_t *page_cnt)
+{
+  #ifdef U8G2_USE_DYNAMIC_ALLOC
+  *page_cnt = 2;
+  return 0;
+  #else
+  static uint8_t buf[256];
+  *page_cnt = 2;
+  return buf;
+  #endif
+}
 uint8_t *u8g2_m_16_8_f(uint8_t *page_cnt)
 {
   #ifdef U8G2_USE_DYNAMIC_ALLOC
@@ -0,0 +1,209 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+u8g2字库裁剪工具
+
+从u8g2格式的字库（C字符串常量）中仅保留指定源文件绘制用到的字形，
+生成constexpr字节表头文件，用于减少固件体积并缩短字形查找路径。
+
+用法:
+    font_subset.py --font fonts.hpp --name u8g2_font_t0_14_te \
+                   --source screen_draw.cpp --function draw_ \
+                   --output screen_font.hpp
+"""
+
+import argparse
+import os
+import re
+import sys
+
+# u8g2字库头部长度
+FONT_HEADER_SIZE = 23
+# 格式化输出数值时可能出现的字符
+NUMBER_CHARS = "0123456789.-"
+
+
+def read_c_string(content, name):
+    """读取C文件中名为name的字符串常量并解码为字节"""
+    match = re.search(r"\b%s\s*\[\s*\d*\s*\][^=]*=\s*((?:\s*\"(?:[^\"\\]|\\.)*\")+)\s*;" % re.escape(name),
+                      content)
+    if match is None:
+        raise ValueError("can't find font %s" % name)
+    result = bytearray()
+    for literal in re.findall(r"\"((?:[^\"\\]|\\.)*)\"", match.group(1)):
+        index = 0
+        while index < len(literal):
+            char = literal[index]
+            if char != "\\":
+                result += char.encode("latin-1")
+                index += 1
+                continue
+            next_char = literal[index + 1]
+            if next_char in "01234567":
+                octal = re.match(r"[0-7]{1,3}", literal[index + 1:]).group(0)
+                result.append(int(octal, 8))
+                index += 1 + len(octal)
+            elif next_char == "x":
+                hexadecimal = re.match(r"[0-9a-fA-F]+", literal[index + 2:]).group(0)
+                result.append(int(hexadecimal, 16) & 0xff)
+                index += 2 + len(hexadecimal)
+            else:
+                result += {"n": b"\n", "t": b"\t", "r": b"\r", "\\": b"\\",
+                           "\"": b"\"", "'": b"'", "?": b"?"}[next_char]
+                index += 2
+    # 字符串常量末尾隐含的'\0'也是字库的一部分
+    result.append(0)
+    return bytes(result)
+
+
+def parse_font(font):
+    """解析字库，返回头部及 {编码: 字形数据(不含编码及长度)}"""
+    header = font[:FONT_HEADER_SIZE]
+    start_pos_unicode = (header[21] << 8) | header[22]
+    glyphs = {}
+    # 8位编码部分
+    position = FONT_HEADER_SIZE
+    while font[position + 1] != 0:
+        size = font[position + 1]
+        glyphs[font[position]] = font[position + 2:position + size]
+        position += size
+    # unicode部分，先跳过查找表（以0xffff结尾）
+    position = FONT_HEADER_SIZE + start_pos_unicode
+    lookup_table = position
+    while True:
+        position += (font[lookup_table] << 8) | font[lookup_table + 1]
+        encoding = (font[lookup_table + 2] << 8) | font[lookup_table + 3]
+        lookup_table += 4
+        if encoding == 0xffff:
+            break
+    position = FONT_HEADER_SIZE + start_pos_unicode
+    position += (font[position] << 8) | font[position + 1]
+    while True:
+        encoding = (font[position] << 8) | font[position + 1]
+        if encoding == 0:
+            break
+        size = font[position + 2]
+        glyphs[encoding] = font[position + 3:position + size]
+        position += size
+    return header, glyphs
+
+
+def build_font(header, glyphs):
+    """按u8g2格式重新生成字库"""
+    body = bytearray()
+    start_pos_upper_a = None
+    start_pos_lower_a = None
+    for encoding in sorted(e for e in glyphs if e <= 0xff):
+        if start_pos_upper_a is None and encoding >= ord("A"):
+            start_pos_upper_a = len(body)
+        if start_pos_lower_a is None and encoding >= ord("a"):
+            start_pos_lower_a = len(body)
+        data = glyphs[encoding]
+        body += bytes([encoding, len(data) + 2]) + data
+    if start_pos_upper_a is None:
+        start_pos_upper_a = len(body)
+    if start_pos_lower_a is None:
+        start_pos_lower_a = len(body)
+    # 8位编码部分结束标记
+    body += b"\x00\x00"
+    start_pos_unicode = len(body)
+    # 查找表仅一项，直接指向字形列表
+    body += bytes([0x00, 0x04, 0xff, 0xff])
+    for encoding in sorted(e for e in glyphs if e > 0xff):
+        data = glyphs[encoding]
+        body += bytes([encoding >> 8, encoding & 0xff, len(data) + 3]) + data
+    # unicode部分结束标记
+    body += b"\x00\x00"
+    header = bytearray(header)
+    header[0] = len(glyphs) & 0xff
+    header[17:19] = bytes([start_pos_upper_a >> 8, start_pos_upper_a & 0xff])
+    header[19:21] = bytes([start_pos_lower_a >> 8, start_pos_lower_a & 0xff])
+    header[21:23] = bytes([start_pos_unicode >> 8, start_pos_unicode & 0xff])
+    return bytes(header + body)
+
+
+def collect_chars(content, function_prefix):
+    """收集源文件中指定前缀函数内字符串常量用到的字符"""
+    chars = set()
+    for match in re.finditer(r"\w+::%s\w*\s*\([^)]*\)\s*\{" % re.escape(function_prefix), content):
+        depth = 1
+        position = match.end()
+        while depth > 0:
+            if content[position] == "{":
+                depth += 1
+            elif content[position] == "}":
+                depth -= 1
+            position += 1
+        body = content[match.end():position]
+        # 去掉注释
+        body = re.sub(r"//[^\n]*", "", body)
+        body = re.sub(r"/\*.*?\*/", "", body, flags=re.S)
+        for literal in re.findall(r"\"((?:[^\"\\]|\\.)*)\"", body):
+            for conversion in re.findall(r"%[-+ #0]*\d*(?:\.\d+)?[a-zA-Z%]", literal):
+                if conversion == "%%":
+                    chars.add("%")
+                elif conversion[-1] in "dioufFeEgGxX":
+                    chars.update(NUMBER_CHARS)
+                else:
+                    raise ValueError("unsupported conversion %s" % conversion)
+            literal = re.sub(r"%[-+ #0]*\d*(?:\.\d+)?[a-zA-Z%]", "", literal)
+            # 源文件为UTF-8，转义字符不会被绘制，直接去掉
+            chars.update(re.sub(r"\\.", "", literal))
+    return chars
+
+
+def write_header(output, name, source_name, font, glyph_count, source_glyph_count, source_size):
+    guard = "_%s_" % os.path.basename(output).replace(".", "_")
+    lines = []
+    lines.append("#ifndef %s" % guard)
+    lines.append("#define %s" % guard)
+    lines.append("#include \"u8g2.h\"")
+    lines.append("")
+    lines.append("/*")
+    lines.append("  Generated by tools/font_subset.py, do not edit")
+    lines.append("  Source: %s" % source_name)
+    lines.append("  Glyphs: %d/%d" % (glyph_count, source_glyph_count))
+    lines.append("  Size: %d/%d" % (len(font), source_size))
+    lines.append("*/")
+    lines.append("constexpr uint8_t %s[%d] U8G2_FONT_SECTION(\"%s\") = {" % (name, len(font), name))
+    for index in range(0, len(font), 16):
+        lines.append("  " + ", ".join("0x%02x" % value for value in font[index:index + 16]) + ",")
+    lines.append("};")
+    lines.append("")
+    lines.append("#endif // %s" % guard)
+    with open(output, "w", encoding="utf-8") as file:
+        file.write("\n".join(lines) + "\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="u8g2 font subset generator")
+    parser.add_argument("--font", required=True, help="file which contains the u8g2 font")
+    parser.add_argument("--name", required=True, help="name of the u8g2 font")
+    parser.add_argument("--source", required=True, action="append", help="source file to scan")
+    parser.add_argument("--function", default="draw_", help="prefix of the functions to scan")
+    parser.add_argument("--extra", default="", help="extra characters to keep")
+    parser.add_argument("--output", required=True, help="output header")
+    parser.add_argument("--output-name", default=None, help="name of the generated font")
+    args = parser.parse_args()
+
+    with open(args.font, encoding="utf-8") as file:
+        source_font = read_c_string(file.read(), args.name)
+    header, glyphs = parse_font(source_font)
+    chars = set(args.extra)
+    for source in args.source:
+        with open(source, encoding="utf-8") as file:
+            chars |= collect_chars(file.read(), args.function)
+    missing = sorted(char for char in chars if ord(char) not in glyphs)
+    if missing:
+        sys.stderr.write("glyphs not in font: %s\n" % "".join(missing))
+        return 1
+    subset = {ord(char): glyphs[ord(char)] for char in chars}
+    font = build_font(header, subset)
+    output_name = args.output_name or (args.name + "_subset")
+    write_header(args.output, output_name, args.name, font, len(subset), len(glyphs), len(source_font))
+    print("%s: %d/%d glyphs, %d/%d bytes" % (output_name, len(subset), len(glyphs), len(font), len(source_font)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
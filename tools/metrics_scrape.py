@@ -0,0 +1,94 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+指标接口抓取测试工具
+
+反复请求设备的/metrics（Prometheus文本格式）及/api/latest（JSON），
+校验响应内容并统计请求延迟，用于检查拉取式指标接口的响应时间。
+
+用法:
+    metrics_scrape.py --host bry88ab151k.local --count 100
+"""
+
+import argparse
+import json
+import sys
+import time
+import urllib.request
+
+
+def scrape(url, timeout):
+    """请求一次，返回(延迟毫秒, 响应内容)"""
+    start = time.perf_counter()
+    with urllib.request.urlopen(url, timeout=timeout) as response:
+        body = response.read()
+    return (time.perf_counter() - start) * 1000, body.decode("utf-8")
+
+
+def check_metrics(body):
+    """校验Prometheus文本格式，返回样本数"""
+    samples = 0
+    for line in body.splitlines():
+        if not line or line.startswith("#"):
+            continue
+        name, value = line.rsplit(" ", 1)
+        float(value)
+        samples += 1
+    return samples
+
+
+def check_latest(body):
+    """校验JSON格式，返回字段数"""
+    return len(json.loads(body))
+
+
+def percentile(values, ratio):
+    """最近秩法计算分位数，values需已排序"""
+    index = max(0, min(len(values) - 1, int(round(ratio * len(values) + 0.5)) - 1))
+    return values[index]
+
+
+def run(url, count, interval, timeout, check):
+    """抓取count次并输出延迟统计，全部成功时返回True"""
+    latencies = []
+    failures = 0
+    for _ in range(count):
+        try:
+            latency, body = scrape(url, timeout)
+            check(body)
+            latencies.append(latency)
+        except Exception as error:
+            failures += 1
+            print("%s: %s" % (url, error), file=sys.stderr)
+        time.sleep(interval)
+    if latencies:
+        latencies.sort()
+        print("%-40s ok %4d  fail %4d  min %7.1f  avg %7.1f  p50 %7.1f  p95 %7.1f  max %7.1f (ms)" % (
+            url, len(latencies), failures,
+            latencies[0],
+            sum(latencies) / len(latencies),
+            percentile(latencies, 0.50),
+            percentile(latencies, 0.95),
+            latencies[-1]))
+    else:
+        print("%-40s ok    0  fail %4d" % (url, failures))
+    return 0 == failures
+
+
+def main():
+    parser = argparse.ArgumentParser(description="抓取设备指标接口并统计延迟")
+    parser.add_argument("--host", required=True, help="设备地址或mDNS主机名")
+    parser.add_argument("--port", type=int, default=80, help="端口")
+    parser.add_argument("--count", type=int, default=50, help="每个接口的请求次数")
+    parser.add_argument("--interval", type=float, default=0.1, help="请求间隔（秒）")
+    parser.add_argument("--timeout", type=float, default=5.0, help="单次请求超时（秒）")
+    args = parser.parse_args()
+
+    base = "http://%s:%d" % (args.host, args.port)
+    ok = run(base + "/metrics", args.count, args.interval, args.timeout, check_metrics)
+    ok = run(base + "/api/latest", args.count, args.interval, args.timeout, check_latest) and ok
+    return 0 if ok else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
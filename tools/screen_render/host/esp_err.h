@@ -0,0 +1,21 @@
+#ifndef _host_esp_err_h_
+#define _host_esp_err_h_
+
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef int esp_err_t;
+
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_INVALID_ARG 0x102
+
+#define ESP_ERROR_CHECK(x) do {                                             \
+        esp_err_t err_rc_ = (x);                                            \
+        if (ESP_OK != err_rc_) {                                            \
+            fprintf(stderr, "%s:%d: error 0x%x\n", __FILE__, __LINE__, err_rc_); \
+            abort();                                                        \
+        }                                                                   \
+    } while (0)
+
+#endif // _host_esp_err_h_
@@ -0,0 +1,15 @@
+#ifndef _host_esp_timer_h_
+#define _host_esp_timer_h_
+
+#include <stdint.h>
+#include <time.h>
+
+// 微秒
+static inline int64_t esp_timer_get_time()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+#endif // _host_esp_timer_h_
@@ -0,0 +1,17 @@
+#ifndef _host_freertos_h_
+#define _host_freertos_h_
+
+// 主机编译用的最小替代，只提供绘制代码用到的类型
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define portMAX_DELAY 0xffffffffUL
+
+#endif // _host_freertos_h_
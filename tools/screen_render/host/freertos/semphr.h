@@ -0,0 +1,29 @@
+#ifndef _host_semphr_h_
+#define _host_semphr_h_
+
+// 主机上单线程运行，互斥锁为空操作
+
+#include "freertos/FreeRTOS.h"
+
+typedef void *SemaphoreHandle_t;
+
+static inline SemaphoreHandle_t xSemaphoreCreateMutex()
+{
+    return nullptr;
+}
+
+static inline void vSemaphoreDelete(SemaphoreHandle_t)
+{
+}
+
+static inline BaseType_t xSemaphoreTake(SemaphoreHandle_t, TickType_t)
+{
+    return pdTRUE;
+}
+
+static inline BaseType_t xSemaphoreGive(SemaphoreHandle_t)
+{
+    return pdTRUE;
+}
+
+#endif // _host_semphr_h_
@@ -0,0 +1,29 @@
+#ifndef _host_i2c_master_hpp_
+#define _host_i2c_master_hpp_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// 主机上只使用无头模式，不会发送
+
+namespace cubestone_wang
+{
+
+namespace i2c_master
+{
+
+class I2cMaster
+{
+    public:
+        void Write(const uint8_t device_address, 
+                   const uint8_t *write_buffer, 
+                   const size_t write_size)
+        {
+        }
+};
+
+}
+
+}
+
+#endif // _host_i2c_master_hpp_
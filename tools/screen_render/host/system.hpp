@@ -0,0 +1,26 @@
+#ifndef _host_system_hpp_
+#define _host_system_hpp_
+
+#include <stdint.h>
+
+// 主机上U8G2只用到延时，无头模式下不需要等待屏幕
+
+namespace cubestone_wang
+{
+
+namespace system
+{
+
+class System
+{
+    public:
+        static void Sleep(const uint32_t milliseconds)
+        {
+        }
+};
+
+}
+
+}
+
+#endif // _host_system_hpp_
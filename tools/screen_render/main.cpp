@@ -0,0 +1,110 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "screen.hpp"
+
+/*
+  主机上的屏幕渲染检查
+  以各缓冲模式运行Screen::Benchmark，输出各页面及各模式的缓冲区大小、渲染时间，用于比较全缓冲与页缓冲，
+  各页面的渲染结果应与golden目录中的PBM一致，--update时写入golden目录
+*/
+
+using namespace cubestone_wang;
+
+// 其余成员在screen.cpp中定义，依赖ESP-IDF，不在主机上编译
+const char *const screen::Screen::LOG_TAG = "SCREEN";
+
+static bool read_file(const std::string &path, std::string &data)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    data = buffer.str();
+    return true;
+}
+
+static bool write_file(const std::string &path, const std::string &data)
+{
+    std::ofstream file(path, std::ios::binary);
+    file << data;
+    return file.good();
+}
+
+int main(int argc, char *argv[])
+{
+    std::string golden;
+    bool update = false;
+    uint32_t rounds = 100;
+    for (int index = 1; index < argc; index++) {
+        if (0 == strcmp(argv[index], "--golden") && index + 1 < argc) {
+            golden = argv[++index];
+        } else if (0 == strcmp(argv[index], "--update")) {
+            update = true;
+        } else if (0 == strcmp(argv[index], "--rounds") && index + 1 < argc) {
+            rounds = (uint32_t)atoi(argv[++index]);
+        } else {
+            fprintf(stderr, "usage: %s --golden DIR [--update] [--rounds N]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (golden.empty()) {
+        fprintf(stderr, "--golden is required\n");
+        return 2;
+    }
+    const struct {
+        const char *Name;
+        screen::Screen::BufferMode Mode;
+    } modes[] = {
+        {"full", screen::Screen::BufferMode::FULL},
+        {"page_1", screen::Screen::BufferMode::PAGE_1},
+        {"page_2", screen::Screen::BufferMode::PAGE_2},
+    };
+    int failed = 0;
+    std::string summary;
+    for (auto &mode : modes) {
+        uint32_t buffer_size = 0;
+        uint32_t total_render_time = 0;
+        uint32_t max_render_time = 0;
+        printf("buffer mode %s\n", mode.Name);
+        for (auto &result : screen::Screen::Benchmark(rounds, mode.Mode)) {
+            buffer_size = result.BufferSize;
+            total_render_time += result.AverageRenderTime;
+            if (result.MaxRenderTime > max_render_time) {
+                max_render_time = result.MaxRenderTime;
+            }
+            // 各缓冲模式的渲染结果相同，共用同一个golden文件
+            auto path = golden + "/" + result.Name + ".pbm";
+            std::string expected;
+            if (update) {
+                if (!write_file(path, result.PBM)) {
+                    fprintf(stderr, "%s: write failed\n", path.c_str());
+                    failed++;
+                }
+            } else if (!read_file(path, expected)) {
+                fprintf(stderr, "%s: missing\n", path.c_str());
+                failed++;
+            } else if (expected != result.PBM) {
+                fprintf(stderr, "%s (%s): mismatch\n", path.c_str(), mode.Name);
+                failed++;
+            }
+        }
+        char line[96];
+        snprintf(line, sizeof(line), "%-8s %6u B  %8u us  %8u us\n",
+                 mode.Name, buffer_size, total_render_time, max_render_time);
+        summary += line;
+    }
+    // 每种模式渲染全部页面一次的平均总时间及单页最大时间
+    printf("mode       buffer  avg(all)  max(page)\n%s", summary.c_str());
+    if (0 != failed) {
+        fprintf(stderr, "%d failed\n", failed);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+UDP行协议接收测试工具
+
+监听UDP端口，接收设备以InfluxdbUDP发送的行协议数据报，按每个来源地址统计
+每秒数据报数、行数及按seq字段计算的丢失率；设备重启后seq从0开始，视为新的序列。
+指定--generate时在本机按相同方式打包并发送到监听端口，可在没有设备时验证统计本身，
+--drop可模拟发送端丢弃一定比例的数据报。
+
+用法:
+    udp_loopback.py --port 8094 --report 10
+    udp_loopback.py --port 8094 --generate 200 --drop 0.05
+"""
+
+import argparse
+import random
+import re
+import socket
+import sys
+import threading
+import time
+
+# 以太网MTU减去IP及UDP头部，与InfluxdbUDP::DEFAULT_PAYLOAD_SIZE一致
+PAYLOAD_SIZE = 1472
+SEQ_PATTERN = re.compile(rb"[ ,]seq=(\d+)i[ ,]")
+
+
+class Source:
+    """一个来源地址的统计"""
+
+    def __init__(self):
+        self.datagrams = 0
+        self.lines = 0
+        self.bytes = 0
+        self.sequenced = 0
+        self.first_seq = None
+        self.last_seq = None
+        self.restarts = 0
+        self.reordered = 0
+
+    def add(self, data):
+        self.datagrams += 1
+        self.bytes += len(data)
+        for line in data.split(b"\n"):
+            if not line.strip():
+                continue
+            self.lines += 1
+            match = SEQ_PATTERN.search(line)
+            if match is None:
+                continue
+            seq = int(match.group(1))
+            if self.last_seq is not None and seq < self.last_seq:
+                # 大幅回退视为发送端重启，否则为乱序
+                if self.last_seq - seq > 1000 or seq < 10:
+                    self.restarts += 1
+                    self.first_seq = seq
+                    self.sequenced = 0
+                else:
+                    self.reordered += 1
+                    self.sequenced += 1
+                    continue
+            if self.first_seq is None:
+                self.first_seq = seq
+            self.last_seq = seq
+            self.sequenced += 1
+
+    def loss(self):
+        if self.first_seq is None:
+            return None
+        expected = self.last_seq - self.first_seq + 1
+        return max(0, expected - self.sequenced), expected
+
+
+def generate(port, rate, drop, payload_size):
+    """模拟设备：每秒rate行，按payload_size打包，以drop的概率丢弃整个数据报"""
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    seq = 0
+    payload = b""
+    interval = 1.0 / rate
+    next_time = time.monotonic()
+    while True:
+        line = b"loopback,host=local temperature=23.50,humidity=45.20,co2=612i,seq=%di %d" % (
+            seq, time.time_ns())
+        seq += 1
+        if payload and len(payload) + 1 + len(line) > payload_size:
+            if random.random() >= drop:
+                sock.sendto(payload, ("127.0.0.1", port))
+            payload = b""
+        payload = payload + b"\n" + line if payload else line
+        next_time += interval
+        delay = next_time - time.monotonic()
+        if delay > 0:
+            time.sleep(delay)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="接收UDP行协议数据并统计丢失")
+    parser.add_argument("--bind", default="0.0.0.0", help="监听地址")
+    parser.add_argument("--port", type=int, default=8094, help="监听端口")
+    parser.add_argument("--report", type=float, default=10.0, help="输出统计的间隔（秒）")
+    parser.add_argument("--generate", type=float, default=0, help="本机模拟发送的行数/秒，0表示不发送")
+    parser.add_argument("--drop", type=float, default=0.0, help="模拟发送时丢弃数据报的比例")
+    parser.add_argument("--payload-size", type=int, default=PAYLOAD_SIZE, help="模拟发送时数据报的最大长度")
+    args = parser.parse_args()
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 1 << 20)
+    sock.bind((args.bind, args.port))
+    sock.settimeout(0.5)
+    print("listening on %s:%d" % (args.bind, args.port))
+    if args.generate > 0:
+        threading.Thread(target=generate, args=(args.port, args.generate, args.drop, args.payload_size),
+                         daemon=True).start()
+
+    sources = {}
+    last = {}
+    report_time = time.monotonic() + args.report
+    try:
+        while True:
+            try:
+                data, address = sock.recvfrom(65535)
+                sources.setdefault(address[0], Source()).add(data)
+            except socket.timeout:
+                pass
+            now = time.monotonic()
+            if now < report_time:
+                continue
+            elapsed = args.report + now - report_time
+            report_time = now + args.report
+            for host, source in sources.items():
+                datagrams, lines = last.get(host, (0, 0))
+                last[host] = (source.datagrams, source.lines)
+                loss = source.loss()
+                loss_text = "no seq" if loss is None else "lost %d/%d (%.2f%%)" % (
+                    loss[0], loss[1], loss[0] * 100.0 / loss[1])
+                print("%-15s %8.2f datagrams/s  %8.2f lines/s  %6.1f lines/datagram  %s  restarts %d  reordered %d" % (
+                    host,
+                    (source.datagrams - datagrams) / elapsed,
+                    (source.lines - lines) / elapsed,
+                    source.lines / source.datagrams,
+                    loss_text,
+                    source.restarts,
+                    source.reordered))
+    except KeyboardInterrupt:
+        pass
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,207 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+上传链路测试替身
+
+在本机同时运行最小的MQTT 3.1.1服务器（应答CONNECT、PUBLISH、PINGREQ）及InfluxDB写入接口
+（/api/v2/write，返回204），不保存数据，只统计两种上传方式的每秒消息数、
+每个采样的负载字节数及连接上的字节数（含协议开销），用于比较MQTT与HTTP上传的开销。
+
+将设备的mqtt配置uri指向mqtt://<本机地址>:1883，或influxdb配置host指向本机、port为8086。
+
+用法:
+    uplink_standin.py --mqtt-port 1883 --http-port 8086 --report 30
+"""
+
+import argparse
+import http.server
+import socketserver
+import sys
+import threading
+import time
+
+# MQTT控制报文类型
+CONNECT = 1
+PUBLISH = 3
+PUBREL = 6
+SUBSCRIBE = 8
+PINGREQ = 12
+DISCONNECT = 14
+
+
+class Counter:
+    """一种上传方式的统计"""
+
+    def __init__(self, name):
+        self.name = name
+        self.lock = threading.Lock()
+        self.reset()
+
+    def reset(self):
+        self.start = time.monotonic()
+        self.messages = 0
+        self.samples = 0
+        self.payload_bytes = 0
+        self.wire_bytes = 0
+
+    def add(self, samples, payload_bytes, wire_bytes):
+        with self.lock:
+            self.messages += 1
+            self.samples += samples
+            self.payload_bytes += payload_bytes
+            self.wire_bytes += wire_bytes
+
+    def add_overhead(self, wire_bytes):
+        """不含采样的报文（连接、心跳、应答）也计入连接上的字节数"""
+        with self.lock:
+            self.wire_bytes += wire_bytes
+
+    def report(self):
+        with self.lock:
+            elapsed = time.monotonic() - self.start
+            if 0 == self.samples:
+                print("%-5s no samples" % self.name)
+            else:
+                print("%-5s %6d msgs  %7.3f msgs/s  %6d samples  payload %6.1f B/sample  wire %6.1f B/sample" % (
+                    self.name, self.messages, self.messages / elapsed, self.samples,
+                    self.payload_bytes / self.samples, self.wire_bytes / self.samples))
+            self.reset()
+
+
+def count_samples(payload):
+    """行协议每行一个采样"""
+    return len([line for line in payload.split(b"\n") if line.strip()])
+
+
+def read_exactly(stream, length):
+    data = b""
+    while len(data) < length:
+        chunk = stream.recv(length - len(data))
+        if not chunk:
+            raise ConnectionError("closed")
+        data += chunk
+    return data
+
+
+def read_packet(stream):
+    """读取一个MQTT报文，返回(类型, 标志, 报文体, 报文总长)"""
+    header = read_exactly(stream, 1)[0]
+    remaining = 0
+    multiplier = 1
+    header_length = 1
+    while True:
+        byte = read_exactly(stream, 1)[0]
+        header_length += 1
+        remaining += (byte & 0x7F) * multiplier
+        multiplier *= 128
+        if 0 == byte & 0x80:
+            break
+    body = read_exactly(stream, remaining)
+    return header >> 4, header & 0x0F, body, header_length + remaining
+
+
+class MQTTHandler(socketserver.BaseRequestHandler):
+    counter = None
+
+    def handle(self):
+        stream = self.request
+        print("mqtt  connected from %s:%d" % self.client_address)
+        try:
+            while True:
+                packet_type, flags, body, length = read_packet(stream)
+                if CONNECT == packet_type:
+                    reply = bytes([0x20, 0x02, 0x00, 0x00])
+                    self.counter.add_overhead(length)
+                elif PUBLISH == packet_type:
+                    qos = (flags >> 1) & 0x03
+                    topic_length = int.from_bytes(body[0:2], "big")
+                    topic = body[2:2 + topic_length]
+                    offset = 2 + topic_length
+                    reply = b""
+                    if qos > 0:
+                        packet_id = body[offset:offset + 2]
+                        offset += 2
+                        # QoS 2只应答PUBREC，设备不使用
+                        reply = bytes([0x40 if 1 == qos else 0x50, 0x02]) + packet_id
+                    payload = body[offset:]
+                    if topic.endswith(b"/data"):
+                        self.counter.add(count_samples(payload), len(payload), length + len(reply))
+                    else:
+                        self.counter.add_overhead(length + len(reply))
+                elif PUBREL == packet_type:
+                    reply = bytes([0x70, 0x02]) + body[0:2]
+                    self.counter.add_overhead(length)
+                elif SUBSCRIBE == packet_type:
+                    reply = bytes([0x90, 0x03]) + body[0:2] + b"\x00"
+                    self.counter.add_overhead(length)
+                elif PINGREQ == packet_type:
+                    reply = bytes([0xD0, 0x00])
+                    self.counter.add_overhead(length + len(reply))
+                elif DISCONNECT == packet_type:
+                    break
+                else:
+                    reply = b""
+                    self.counter.add_overhead(length)
+                if reply:
+                    stream.sendall(reply)
+        except (ConnectionError, OSError):
+            pass
+        print("mqtt  disconnected from %s:%d" % self.client_address)
+
+
+class HTTPHandler(http.server.BaseHTTPRequestHandler):
+    counter = None
+    protocol_version = "HTTP/1.1"
+
+    def do_POST(self):
+        length = int(self.headers.get("Content-Length", 0))
+        body = self.rfile.read(length)
+        request_bytes = len(self.requestline) + 2 + len(bytes(self.headers)) + length
+        self.send_response(204)
+        self.send_header("Content-Length", "0")
+        self.end_headers()
+        # 应答约为状态行及两个头部
+        self.counter.add(count_samples(body), length, request_bytes + 60)
+
+    def log_message(self, format, *args):
+        pass
+
+
+class ThreadingTCPServer(socketserver.ThreadingMixIn, socketserver.TCPServer):
+    daemon_threads = True
+    allow_reuse_address = True
+
+
+def main():
+    parser = argparse.ArgumentParser(description="MQTT及InfluxDB上传的测试替身")
+    parser.add_argument("--bind", default="0.0.0.0", help="监听地址")
+    parser.add_argument("--mqtt-port", type=int, default=1883, help="MQTT端口，0表示不启动")
+    parser.add_argument("--http-port", type=int, default=8086, help="InfluxDB端口，0表示不启动")
+    parser.add_argument("--report", type=float, default=30.0, help="输出统计的间隔（秒）")
+    args = parser.parse_args()
+
+    counters = []
+    if args.mqtt_port:
+        MQTTHandler.counter = Counter("mqtt")
+        counters.append(MQTTHandler.counter)
+        server = ThreadingTCPServer((args.bind, args.mqtt_port), MQTTHandler)
+        threading.Thread(target=server.serve_forever, daemon=True).start()
+        print("mqtt  listening on %s:%d" % (args.bind, args.mqtt_port))
+    if args.http_port:
+        HTTPHandler.counter = Counter("http")
+        counters.append(HTTPHandler.counter)
+        server = ThreadingTCPServer((args.bind, args.http_port), HTTPHandler)
+        threading.Thread(target=server.serve_forever, daemon=True).start()
+        print("http  listening on %s:%d" % (args.bind, args.http_port))
+    try:
+        while True:
+            time.sleep(args.report)
+            for counter in counters:
+                counter.report()
+    except KeyboardInterrupt:
+        pass
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())